@@ -0,0 +1,566 @@
+#include "../src/channel.h"
+#include "../src/util.h"
+#include "../test/threading.h"
+#include <stdio.h>
+#include <string.h>
+
+#define BENCH_FORMAT_CSV  0
+#define BENCH_FORMAT_JSON 1
+
+#define BENCH_RENDEZVOUS         0
+#define BENCH_BOUNDED            1
+#define BENCH_BOUNDED_LOCKFREE   2
+#define BENCH_UNBOUNDED          3
+#define BENCH_UNBOUNDED_LOCKFREE 4
+#define BENCH_BOUNDED_SPIN       5
+#define BENCH_UNBOUNDED_SPIN     6
+#define BENCH_BOUNDED_SPSC       7
+#define BENCH_UNBOUNDED_SPSC     8
+
+// The number of messages moved per call in the burst workload.
+#define BENCH_BURST_SIZE 64
+
+// The largest number of producers in the MPSC workload.
+#define BENCH_MAX_PRODUCERS 64
+
+// A channel of any type, as used by the benchmarks.
+typedef struct BenchChannel_ {
+    int kind;
+    size_t capacity;
+    RendezvousChannel* rendezvous;
+    BoundedChannel* bounded;
+    UnboundedChannel* unbounded;
+} BenchChannel;
+
+// The state shared by the threads of a single benchmark run. The message at
+// index `i` is sent as the pointer `i + 1`, and `stamps[i]` holds the time it
+// was sent, so the receiver can work out how long it spent in the channel.
+typedef struct BenchRun_ {
+    BenchChannel* channel;
+    BenchChannel* reply;
+    size_t messages;
+    size_t producers;
+    uint64_t* stamps;
+    uint64_t* latencies;
+} BenchRun;
+
+// The work of one producer thread.
+typedef struct BenchProducer_ {
+    BenchRun* run;
+    size_t first;
+    size_t last;
+} BenchProducer;
+
+// The results of a single benchmark run.
+typedef struct BenchResult_ {
+    const char* workload;
+    const char* channel;
+    size_t capacity;
+    size_t producers;
+    size_t messages;
+    double seconds;
+    uint64_t p50;
+    uint64_t p99;
+    uint64_t p999;
+} BenchResult;
+
+static int bench_format = BENCH_FORMAT_CSV;
+static bool bench_first_result = true;
+
+// Returns the name of a channel kind.
+static const char* bench_channel_name(int kind)
+{
+    switch (kind) {
+        case BENCH_RENDEZVOUS:
+            return "rendezvous";
+        case BENCH_BOUNDED:
+            return "bounded";
+        case BENCH_BOUNDED_LOCKFREE:
+            return "bounded_lockfree";
+        case BENCH_UNBOUNDED:
+            return "unbounded";
+        case BENCH_UNBOUNDED_LOCKFREE:
+            return "unbounded_lockfree";
+        case BENCH_BOUNDED_SPIN:
+            return "bounded_spin";
+        case BENCH_UNBOUNDED_SPIN:
+            return "unbounded_spin";
+        case BENCH_BOUNDED_SPSC:
+            return "bounded_spsc";
+        case BENCH_UNBOUNDED_SPSC:
+            return "unbounded_spsc";
+        default:
+            return "unknown";
+    }
+}
+
+// Creates a channel of the given kind. The capacity is ignored by channels
+// without one.
+static BenchChannel* bench_channel(int kind, size_t capacity)
+{
+    BenchChannel* channel = (BenchChannel*)malloc(sizeof(BenchChannel));
+    channel->kind = kind;
+    channel->capacity = capacity;
+    channel->rendezvous = NULL;
+    channel->bounded = NULL;
+    channel->unbounded = NULL;
+
+    ChannelOptions spin = { CHANNEL_LOCK_SPIN, false, false };
+
+    switch (kind) {
+        case BENCH_RENDEZVOUS:
+            channel->capacity = 0;
+            channel->rendezvous = rendezvous_channel();
+            break;
+        case BENCH_BOUNDED:
+            channel->bounded = bounded_channel(capacity);
+            break;
+        case BENCH_BOUNDED_LOCKFREE:
+            channel->bounded = bounded_channel_lockfree(capacity);
+            break;
+        case BENCH_UNBOUNDED:
+            channel->capacity = 0;
+            channel->unbounded = unbounded_channel();
+            break;
+        case BENCH_UNBOUNDED_LOCKFREE:
+            channel->capacity = 0;
+            channel->unbounded = unbounded_channel_lockfree();
+            break;
+        case BENCH_BOUNDED_SPIN:
+            channel->bounded = bounded_channel_with(capacity, &spin);
+            break;
+        case BENCH_UNBOUNDED_SPIN:
+            channel->capacity = 0;
+            channel->unbounded = unbounded_channel_with(&spin);
+            break;
+        case BENCH_BOUNDED_SPSC:
+            channel->bounded = spsc_bounded_channel(capacity);
+            break;
+        case BENCH_UNBOUNDED_SPSC:
+            channel->capacity = 0;
+            channel->unbounded = spsc_unbounded_channel();
+            break;
+        default:
+            break;
+    }
+
+    return channel;
+}
+
+// Frees a channel created by `bench_channel`.
+static void bench_free(BenchChannel* channel)
+{
+    if (channel->rendezvous != NULL) {
+        free_rendezvous_channel(channel->rendezvous);
+    }
+
+    if (channel->bounded != NULL) {
+        free_bounded_channel(channel->bounded);
+    }
+
+    if (channel->unbounded != NULL) {
+        free_unbounded_channel(channel->unbounded);
+    }
+
+    free(channel);
+}
+
+// Sends a batch of messages through a benchmark channel.
+static void bench_send_many(BenchChannel* channel, void** messages, size_t count)
+{
+    if (channel->rendezvous != NULL) {
+        rendezvous_send_many_c(channel->rendezvous, messages, count, NULL);
+    }
+    else if (channel->bounded != NULL) {
+        bounded_send_many_c(channel->bounded, messages, count, NULL);
+    }
+    else {
+        unbounded_send_many_c(channel->unbounded, messages, count, NULL);
+    }
+}
+
+// Receives up to `max` messages from a benchmark channel.
+static size_t bench_recv_many(BenchChannel* channel, void** messages, size_t max)
+{
+    size_t received = 0;
+
+    if (channel->rendezvous != NULL) {
+        rendezvous_recv_many_c(channel->rendezvous, messages, max, &received);
+    }
+    else if (channel->bounded != NULL) {
+        bounded_recv_many_c(channel->bounded, messages, max, &received);
+    }
+    else {
+        unbounded_recv_many_c(channel->unbounded, messages, max, &received);
+    }
+
+    return received;
+}
+
+// Sends a single message through a benchmark channel.
+static void bench_send(BenchChannel* channel, void* message)
+{
+    if (channel->rendezvous != NULL) {
+        rendezvous_send_c(channel->rendezvous, message);
+    }
+    else if (channel->bounded != NULL) {
+        bounded_send_c(channel->bounded, message);
+    }
+    else {
+        unbounded_send_c(channel->unbounded, message);
+    }
+}
+
+// Receives a single message from a benchmark channel.
+static void* bench_recv(BenchChannel* channel)
+{
+    if (channel->rendezvous != NULL) {
+        return rendezvous_recv_c(channel->rendezvous);
+    }
+    else if (channel->bounded != NULL) {
+        return bounded_recv_c(channel->bounded);
+    }
+    else {
+        return unbounded_recv_c(channel->unbounded);
+    }
+}
+
+// Compares two latencies for `qsort`.
+static int bench_compare(const void* a, const void* b)
+{
+    uint64_t x = *(const uint64_t*)a;
+    uint64_t y = *(const uint64_t*)b;
+
+    return (x > y) - (x < y);
+}
+
+// Returns the latency at the given quantile of a sorted array, or zero if
+// the array is empty.
+static uint64_t bench_quantile(const uint64_t* sorted, size_t count, double quantile)
+{
+    if (count == 0) {
+        return 0;
+    }
+
+    size_t index = (size_t)(quantile * (double)count);
+
+    return sorted[index < count ? index : count - 1];
+}
+
+// Prints a benchmark result in the selected format.
+static void bench_report(
+    const char* workload,
+    BenchChannel* channel,
+    size_t producers,
+    size_t messages,
+    double seconds,
+    uint64_t* latencies,
+    size_t samples)
+{
+    if (samples > 0) {
+        qsort(latencies, samples, sizeof(uint64_t), bench_compare);
+    }
+
+    BenchResult result = {
+        workload,
+        bench_channel_name(channel->kind),
+        channel->capacity,
+        producers,
+        messages,
+        seconds,
+        bench_quantile(latencies, samples, 0.5),
+        bench_quantile(latencies, samples, 0.99),
+        bench_quantile(latencies, samples, 0.999)
+    };
+    double rate = (double)result.messages / result.seconds;
+
+    if (bench_format == BENCH_FORMAT_JSON) {
+        printf(
+            "%s\n  {\"workload\": \"%s\", \"channel\": \"%s\", \"capacity\": %zu, "
+            "\"producers\": %zu, \"messages\": %zu, \"seconds\": %.6f, \"msgs_per_sec\": %.0f, "
+            "\"p50_ns\": %llu, \"p99_ns\": %llu, \"p999_ns\": %llu}",
+            bench_first_result ? "[" : ",",
+            result.workload, result.channel, result.capacity, result.producers,
+            result.messages, result.seconds, rate, (unsigned long long)result.p50,
+            (unsigned long long)result.p99, (unsigned long long)result.p999);
+    }
+    else {
+        if (bench_first_result) {
+            printf("workload,channel,capacity,producers,messages,seconds,msgs_per_sec,p50_ns,p99_ns,p999_ns\n");
+        }
+
+        printf(
+            "%s,%s,%zu,%zu,%zu,%.6f,%.0f,%llu,%llu,%llu\n",
+            result.workload, result.channel, result.capacity, result.producers,
+            result.messages, result.seconds, rate, (unsigned long long)result.p50,
+            (unsigned long long)result.p99, (unsigned long long)result.p999);
+    }
+
+    bench_first_result = false;
+    fflush(stdout);
+}
+
+// Sends a range of messages one at a time, stamping each with its send time.
+static void bench_producer(void* producer_vp)
+{
+    BenchProducer* producer = (BenchProducer*)producer_vp;
+    BenchRun* run = producer->run;
+
+    for (size_t i = producer->first; i < producer->last; i++) {
+        run->stamps[i] = channel_now();
+        bench_send(run->channel, (void*)(i + 1));
+    }
+}
+
+// Sends a range of messages in bursts, stamping each burst with its send time.
+static void bench_burst_producer(void* producer_vp)
+{
+    BenchProducer* producer = (BenchProducer*)producer_vp;
+    BenchRun* run = producer->run;
+    void* burst[BENCH_BURST_SIZE];
+
+    for (size_t i = producer->first; i < producer->last; i += BENCH_BURST_SIZE) {
+        size_t count = CHANNEL_MIN(BENCH_BURST_SIZE, producer->last - i);
+        uint64_t now = channel_now();
+
+        for (size_t j = 0; j < count; j++) {
+            run->stamps[i + j] = now;
+            burst[j] = (void*)(i + j + 1);
+        }
+
+        bench_send_many(run->channel, burst, count);
+    }
+}
+
+// Runs producers sending `messages` messages through a channel to a consumer
+// on the calling thread, then reports the throughput and latency.
+static void bench_stream(const char* workload, BenchChannel* channel, size_t producers, size_t messages, bool burst)
+{
+    BenchRun run = { channel, NULL, messages, producers, NULL, NULL };
+    run.stamps = (uint64_t*)malloc(messages * sizeof(uint64_t));
+    run.latencies = (uint64_t*)malloc(messages * sizeof(uint64_t));
+
+    BenchProducer producer_info[BENCH_MAX_PRODUCERS];
+    JoinHandle* handles[BENCH_MAX_PRODUCERS];
+    uint64_t start = channel_now();
+
+    for (size_t i = 0; i < producers; i++) {
+        producer_info[i].run = &run;
+        producer_info[i].first = messages * i / producers;
+        producer_info[i].last = messages * (i + 1) / producers;
+        handles[i] = thread_spawn(burst ? bench_burst_producer : bench_producer, &producer_info[i]);
+    }
+
+    void* received[BENCH_BURST_SIZE];
+    size_t total = 0;
+
+    while (total < messages) {
+        size_t count = 1;
+
+        if (burst) {
+            count = bench_recv_many(channel, received, BENCH_BURST_SIZE);
+        }
+        else {
+            received[0] = bench_recv(channel);
+        }
+
+        uint64_t now = channel_now();
+
+        for (size_t i = 0; i < count; i++) {
+            run.latencies[total + i] = now - run.stamps[(size_t)received[i] - 1];
+        }
+
+        total += count;
+    }
+
+    double seconds = (double)(channel_now() - start) / 1e9;
+
+    for (size_t i = 0; i < producers; i++) {
+        thread_join(handles[i]);
+    }
+
+    bench_report(workload, channel, producers, messages, seconds, run.latencies, messages);
+
+    free(run.stamps);
+    free(run.latencies);
+    bench_free(channel);
+}
+
+// Sends a range of messages one at a time, without stamping them.
+static void bench_raw_producer(void* producer_vp)
+{
+    BenchProducer* producer = (BenchProducer*)producer_vp;
+
+    for (size_t i = producer->first; i < producer->last; i++) {
+        bench_send(producer->run->channel, (void*)(i + 1));
+    }
+}
+
+// Streams messages from one producer to a consumer on the calling thread
+// without timing individual messages, and reports the throughput. With no
+// clock reads or stamp writes in the loop, the cost measured is that of the
+// channel alone, including any cache lines the two threads fight over.
+static void bench_raw_stream(BenchChannel* channel, size_t messages)
+{
+    BenchRun run = { channel, NULL, messages, 1, NULL, NULL };
+    BenchProducer producer = { &run, 0, messages };
+    uint64_t start = channel_now();
+    JoinHandle* handle = thread_spawn(bench_raw_producer, &producer);
+
+    for (size_t i = 0; i < messages; i++) {
+        bench_recv(channel);
+    }
+
+    double seconds = (double)(channel_now() - start) / 1e9;
+
+    thread_join(handle);
+
+    bench_report("spsc_raw", channel, 1, messages, seconds, NULL, 0);
+    bench_free(channel);
+}
+
+// Echoes every message on the first channel back through the second.
+static void bench_echo(void* run_vp)
+{
+    BenchRun* run = (BenchRun*)run_vp;
+
+    for (size_t i = 0; i < run->messages; i++) {
+        bench_send(run->reply, bench_recv(run->channel));
+    }
+}
+
+// Bounces a message between two threads and reports the round-trip latency.
+static void bench_ping_pong(int kind, size_t capacity, size_t round_trips)
+{
+    BenchRun run = { bench_channel(kind, capacity), bench_channel(kind, capacity), round_trips, 1, NULL, NULL };
+    run.latencies = (uint64_t*)malloc(round_trips * sizeof(uint64_t));
+
+    JoinHandle* handle = thread_spawn(bench_echo, &run);
+    uint64_t start = channel_now();
+
+    for (size_t i = 0; i < round_trips; i++) {
+        uint64_t sent = channel_now();
+        bench_send(run.channel, (void*)(i + 1));
+        bench_recv(run.reply);
+        run.latencies[i] = channel_now() - sent;
+    }
+
+    double seconds = (double)(channel_now() - start) / 1e9;
+
+    thread_join(handle);
+
+    bench_report("ping_pong", run.channel, 1, round_trips, seconds, run.latencies, round_trips);
+
+    free(run.latencies);
+    bench_free(run.channel);
+    bench_free(run.reply);
+}
+
+// Prints the command line usage.
+static void bench_usage(const char* program)
+{
+    fprintf(stderr, "usage: %s [--format csv|json] [--messages N]\n", program);
+}
+
+int main(int argc, char** argv)
+{
+    size_t messages = 200000;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--format") == 0 && i + 1 < argc) {
+            i++;
+
+            if (strcmp(argv[i], "json") == 0) {
+                bench_format = BENCH_FORMAT_JSON;
+            }
+            else if (strcmp(argv[i], "csv") == 0) {
+                bench_format = BENCH_FORMAT_CSV;
+            }
+            else {
+                bench_usage(argv[0]);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--messages") == 0 && i + 1 < argc) {
+            messages = strtoul(argv[++i], NULL, 10);
+        }
+        else {
+            bench_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (messages == 0) {
+        bench_usage(argv[0]);
+        return 1;
+    }
+
+    size_t capacities[3] = { 1, 64, 1024 };
+    size_t producer_counts[7] = { 1, 2, 4, 8, 16, 32, 64 };
+    int stream_kinds[6] = {
+        BENCH_BOUNDED, BENCH_BOUNDED_LOCKFREE, BENCH_BOUNDED_SPIN,
+        BENCH_UNBOUNDED, BENCH_UNBOUNDED_LOCKFREE, BENCH_UNBOUNDED_SPIN
+    };
+    int spsc_kinds[8] = {
+        BENCH_BOUNDED, BENCH_BOUNDED_LOCKFREE, BENCH_BOUNDED_SPIN, BENCH_BOUNDED_SPSC,
+        BENCH_UNBOUNDED, BENCH_UNBOUNDED_LOCKFREE, BENCH_UNBOUNDED_SPIN, BENCH_UNBOUNDED_SPSC
+    };
+
+    // A rendezvous channel wakes a thread for every message, so it gets fewer.
+    size_t rendezvous_messages = messages / 10 > 0 ? messages / 10 : 1;
+
+    // Single producer, single consumer.
+    bench_stream("spsc", bench_channel(BENCH_RENDEZVOUS, 0), 1, rendezvous_messages, false);
+
+    for (size_t c = 0; c < 3; c++) {
+        bench_stream("spsc", bench_channel(BENCH_BOUNDED, capacities[c]), 1, messages, false);
+        bench_stream("spsc", bench_channel(BENCH_BOUNDED_LOCKFREE, capacities[c]), 1, messages, false);
+        bench_stream("spsc", bench_channel(BENCH_BOUNDED_SPSC, capacities[c]), 1, messages, false);
+    }
+
+    bench_stream("spsc", bench_channel(BENCH_UNBOUNDED, 0), 1, messages, false);
+    bench_stream("spsc", bench_channel(BENCH_UNBOUNDED_LOCKFREE, 0), 1, messages, false);
+    bench_stream("spsc", bench_channel(BENCH_UNBOUNDED_SPSC, 0), 1, messages, false);
+
+    // Single producer, single consumer, without per-message timing.
+    for (size_t k = 0; k < 8; k++) {
+        bench_raw_stream(bench_channel(spsc_kinds[k], 1024), messages);
+    }
+
+    // Many producers, single consumer.
+    for (size_t p = 0; p < 7; p++) {
+        bench_stream("mpsc", bench_channel(BENCH_RENDEZVOUS, 0), producer_counts[p], rendezvous_messages, false);
+
+        for (size_t k = 0; k < 6; k++) {
+            bench_stream("mpsc", bench_channel(stream_kinds[k], 1024), producer_counts[p], messages, false);
+        }
+    }
+
+    // Round trips between two threads.
+    bench_ping_pong(BENCH_RENDEZVOUS, 0, rendezvous_messages);
+    bench_ping_pong(BENCH_BOUNDED, 1, rendezvous_messages);
+    bench_ping_pong(BENCH_BOUNDED_LOCKFREE, 1, rendezvous_messages);
+    bench_ping_pong(BENCH_UNBOUNDED, 0, rendezvous_messages);
+    bench_ping_pong(BENCH_UNBOUNDED_LOCKFREE, 0, rendezvous_messages);
+    bench_ping_pong(BENCH_BOUNDED_SPSC, 1, rendezvous_messages);
+    bench_ping_pong(BENCH_UNBOUNDED_SPSC, 0, rendezvous_messages);
+
+    // Bursts moved with the batch operations.
+    bench_stream("burst", bench_channel(BENCH_RENDEZVOUS, 0), 1, messages, true);
+
+    for (size_t c = 1; c < 3; c++) {
+        bench_stream("burst", bench_channel(BENCH_BOUNDED, capacities[c]), 1, messages, true);
+        bench_stream("burst", bench_channel(BENCH_BOUNDED_LOCKFREE, capacities[c]), 1, messages, true);
+        bench_stream("burst", bench_channel(BENCH_BOUNDED_SPSC, capacities[c]), 1, messages, true);
+    }
+
+    bench_stream("burst", bench_channel(BENCH_UNBOUNDED, 0), 1, messages, true);
+    bench_stream("burst", bench_channel(BENCH_UNBOUNDED_LOCKFREE, 0), 1, messages, true);
+    bench_stream("burst", bench_channel(BENCH_UNBOUNDED_SPSC, 0), 1, messages, true);
+
+    if (bench_format == BENCH_FORMAT_JSON) {
+        printf("\n]\n");
+    }
+
+    return 0;
+}
@@ -1,489 +1,4007 @@
+// The library always provides the out-of-line versions of the functions
+// that `CHANNEL_HEADER_ONLY` redirects to inline fast paths.
+#undef CHANNEL_HEADER_ONLY
+
 #include "channel.h"
 #include "mutex.h"
+#include "park.h"
 #include "util.h"
 #include <stdlib.h>
-
-RendezvousChannel* rendezvous_channel(void)
+#include <stddef.h>
+#include <string.h>
+
+#ifdef __linux__
+#  include <sys/eventfd.h>
+#  include <unistd.h>
+#endif
+
+// Returned internally by non-blocking attempts that cannot complete yet.
+#define CHANNEL_WOULD_BLOCK -1
+
+// The progress of a send or receive of one or more messages on a lock-free
+// channel.
+typedef struct BatchOperation_ {
+    void* buffer;
+    void** messages;
+    size_t count;
+    size_t done;
+} BatchOperation;
+
+// Adds to a counter of a channel, if the library is built with
+// `CHANNEL_STATS`.
+static void channel_count(atomic_uint_fast64_t* counter, uint64_t amount)
 {
-    Mutex* mutex = new_mutex();
-    atomic_flag send_blocked = ATOMIC_FLAG_INIT;
-
-    RendezvousChannelBuffer* buffer = NEW(RendezvousChannelBuffer);
-    buffer->message = NULL;
-    buffer->sender_alive = true;
-    buffer->receiver_alive = true;
-    buffer->mutex = mutex;
-    buffer->send_blocked = send_blocked;
+#ifdef CHANNEL_STATS
+    atomic_fetch_add_explicit(counter, amount, memory_order_relaxed);
+#else
+    (void)counter;
+    (void)amount;
+#endif
+}
 
-    RendezvousSender* sender = NEW(RendezvousSender);
-    sender->buffer = buffer;
+// Counts messages that were sent, and raises the high-water mark of the
+// depth of the channel if the sender sees it grow past it.
+static void channel_count_sent(ChannelCounters* send_counters, ChannelCounters* recv_counters, size_t count)
+{
+#ifdef CHANNEL_STATS
+    if (count == 0) {
+        return;
+    }
 
-    RendezvousReceiver* receiver = NEW(RendezvousReceiver);
-    receiver->buffer = buffer;
+    uint64_t sent = atomic_fetch_add_explicit(&send_counters->messages, count, memory_order_relaxed) + count;
+    uint64_t received = atomic_load_explicit(&recv_counters->messages, memory_order_relaxed);
+    uint64_t depth = sent > received ? sent - received : 0;
+    uint64_t max_depth = atomic_load_explicit(&send_counters->max_depth, memory_order_relaxed);
 
-    RendezvousChannel* channel = NEW(RendezvousChannel);
-    channel->sender = sender;
-    channel->receiver = receiver;
+    while (depth > max_depth
+           && !atomic_compare_exchange_weak_explicit(
+               &send_counters->max_depth, &max_depth, depth,
+               memory_order_relaxed, memory_order_relaxed)) {
+    }
+#else
+    (void)send_counters;
+    (void)recv_counters;
+    (void)count;
+#endif
+}
 
-    return channel;
+// Initializes the counters of one side of a new channel.
+static void channel_counters_init(ChannelCounters* counters)
+{
+    atomic_init(&counters->messages, 0);
+    atomic_init(&counters->blocked_ns, 0);
+    atomic_init(&counters->waits, 0);
+    atomic_init(&counters->contentions, 0);
+    atomic_init(&counters->max_depth, 0);
 }
 
-int rendezvous_send(RendezvousSender* sender, void* message)
+// Takes the mutex of a channel. With `CHANNEL_STATS`, the mutex is tried
+// first, so that the acquisitions that have to wait can be counted.
+static int channel_lock(Mutex* mutex, ChannelCounters* counters)
 {
-    if (!sender->buffer->receiver_alive) {
-        return CHANNEL_CLOSED;
+#ifdef CHANNEL_STATS
+    if (mutex_try_lock(mutex)) {
+        return CHANNEL_MUTEX_SUCCESS;
     }
 
-    while (atomic_flag_test_and_set(&sender->buffer->send_blocked)) {
-        channel_wait();
-    }
+    channel_count(&counters->contentions, 1);
+#else
+    (void)counters;
+#endif
 
-    if (mutex_lock(sender->buffer->mutex) != CHANNEL_MUTEX_SUCCESS) {
-        atomic_flag_clear(&sender->buffer->send_blocked);
-        return CHANNEL_MUTEX_ERROR;
-    }
+    return mutex_lock(mutex);
+}
 
-    if (!sender->buffer->receiver_alive) {
-        if (mutex_release(sender->buffer->mutex) != CHANNEL_MUTEX_SUCCESS) {
-            return CHANNEL_MUTEX_ERROR;
-        }
+// Parks the calling thread like `parker_park_until`, counting the wait and
+// the time spent parked.
+static bool channel_park(Parker* parker, uint64_t deadline, ChannelCounters* counters)
+{
+#ifdef CHANNEL_STATS
+    uint64_t start = channel_now();
+    bool unparked = parker_park_until(parker, deadline);
+    channel_count(&counters->waits, 1);
+    channel_count(&counters->blocked_ns, channel_now() - start);
+
+    return unparked;
+#else
+    (void)counters;
+
+    return parker_park_until(parker, deadline);
+#endif
+}
 
-        return CHANNEL_CLOSED;
-    }
+// Waits on a wait queue with the mutex of a channel held, like
+// `wait_queue_wait`, counting the wait and the time spent blocked.
+static int channel_wait(WaitQueue* queue, Mutex* mutex, uint64_t deadline, ChannelCounters* counters)
+{
+#ifdef CHANNEL_STATS
+    uint64_t start = channel_now();
+    int result = wait_queue_wait(queue, mutex, deadline);
+    channel_count(&counters->waits, 1);
+    channel_count(&counters->blocked_ns, channel_now() - start);
+
+    return result;
+#else
+    (void)counters;
+
+    return wait_queue_wait(queue, mutex, deadline);
+#endif
+}
 
-    RendezvousMessage* new_message = NEW(RendezvousMessage);
-    new_message->message = message;
-    sender->buffer->message = new_message;
+// Takes a snapshot of the counters of both sides of a channel.
+static bool channel_counters_snapshot(
+    ChannelCounters* send_counters,
+    ChannelCounters* recv_counters,
+    ChannelStats* stats)
+{
+    // Receives are read first, so that a message counted as received is
+    // also counted as sent, unless its sender has yet to count it.
+    stats->received = atomic_load_explicit(&recv_counters->messages, memory_order_relaxed);
+    stats->sent = atomic_load_explicit(&send_counters->messages, memory_order_relaxed);
+    stats->depth = stats->sent > stats->received ? stats->sent - stats->received : 0;
+    stats->max_depth = atomic_load_explicit(&send_counters->max_depth, memory_order_relaxed);
+    stats->send_blocked_ns = atomic_load_explicit(&send_counters->blocked_ns, memory_order_relaxed);
+    stats->recv_blocked_ns = atomic_load_explicit(&recv_counters->blocked_ns, memory_order_relaxed);
+    stats->send_waits = atomic_load_explicit(&send_counters->waits, memory_order_relaxed);
+    stats->recv_waits = atomic_load_explicit(&recv_counters->waits, memory_order_relaxed);
+    stats->lock_contentions =
+        atomic_load_explicit(&send_counters->contentions, memory_order_relaxed)
+        + atomic_load_explicit(&recv_counters->contentions, memory_order_relaxed);
+
+#ifdef CHANNEL_STATS
+    return true;
+#else
+    return false;
+#endif
+}
 
-    if (mutex_release(sender->buffer->mutex) != CHANNEL_MUTEX_SUCCESS) {
-        return CHANNEL_MUTEX_ERROR;
-    }
+// How long a thread about to block may spin, in nanoseconds, and how many
+// times it may then yield, under a wait policy.
+typedef struct WaitLimits_ {
+    uint64_t spin_ns;
+    unsigned yields;
+} WaitLimits;
+
+// The limits of each wait policy, indexed by policy.
+static const WaitLimits wait_limits[] = {
+    { 0, 0 },
+    { 2000, 2 },
+    { 20000, 8 },
+};
+
+// The number of spins between reads of the clock.
+#define WAIT_SPINS_PER_CHECK 32
+
+// Initializes the wait state of one side of a new channel. An unknown policy
+// is treated as `CHANNEL_WAIT_POWER_SAVING`. The average starts out at half
+// the spin limit, so that the first waits spin as long as the policy allows.
+static void channel_wait_init(ChannelWaitState* wait, int policy)
+{
+    wait->policy = policy == CHANNEL_WAIT_THROUGHPUT || policy == CHANNEL_WAIT_LATENCY
+        ? policy
+        : CHANNEL_WAIT_POWER_SAVING;
+    atomic_init(&wait->average_ns, wait_limits[wait->policy].spin_ns / 2);
+}
+
+// Returns the time a wait that is about to start starts at, if the policy of
+// the waiting side needs to know. Power-saving channels are spared the clock
+// read and get zero.
+static uint64_t channel_wait_start(const ChannelWaitState* wait)
+{
+    return wait->policy != CHANNEL_WAIT_POWER_SAVING ? channel_now() : 0;
+}
 
-    while (sender->buffer->message != NULL) {
-        channel_wait();
+// Folds the length of a wait that began at `start` and ended with the
+// operation completing into the average of the waiting side. Waits longer
+// than four times the spin limit count as that long, so that a single long
+// pause does not keep the channel from spinning for long.
+static void channel_wait_done(ChannelWaitState* wait, uint64_t start)
+{
+    if (start == 0) {
+        return;
     }
 
-    atomic_flag_clear(&sender->buffer->send_blocked);
+    uint64_t limit = 4 * wait_limits[wait->policy].spin_ns;
+    uint64_t elapsed = CHANNEL_MIN(channel_now() - start, limit);
+    uint64_t average = atomic_load_explicit(&wait->average_ns, memory_order_relaxed);
 
-    return CHANNEL_SUCCESS;
+    // A racing update from another waiter may be lost, which only slows the
+    // adaptation down.
+    atomic_store_explicit(&wait->average_ns, average - average / 8 + elapsed / 8, memory_order_relaxed);
 }
 
-int rendezvous_send_c(RendezvousChannel* channel, void* message)
+// Returns whether a thread about to block should spin first. Spinning is
+// skipped if the policy forbids it, if the caller would not block at all, or
+// if recent waits took longer than the spin limit of the policy.
+static bool channel_should_spin(const ChannelWaitState* wait, uint64_t deadline)
 {
-    return rendezvous_send(channel->sender, message);
+    uint64_t limit = wait_limits[wait->policy].spin_ns;
+
+    return limit != 0
+        && deadline != 0
+        && atomic_load_explicit(&wait->average_ns, memory_order_relaxed) <= limit;
 }
 
-void* rendezvous_recv(RendezvousReceiver* receiver)
+// Spins, then yields, for as long as the wait policy of the waiting side
+// allows, until `ready` returns `true`. The spinning lasts about twice the
+// average wait. If `false` is returned, the thread has to block.
+static bool channel_spin(const ChannelWaitState* wait, uint64_t deadline, bool (*ready)(void*), void* context)
 {
-    if (!receiver->buffer->sender_alive && receiver->buffer->message == NULL) {
-        return NULL;
+    if (!channel_should_spin(wait, deadline)) {
+        return false;
     }
 
-    while (receiver->buffer->message == NULL && receiver->buffer->sender_alive) {
-        channel_wait();
-    }
+    const WaitLimits* limits = &wait_limits[wait->policy];
+    uint64_t average = atomic_load_explicit(&wait->average_ns, memory_order_relaxed);
+    uint64_t now = channel_now();
+    uint64_t stop = CHANNEL_MIN(now + CHANNEL_MIN(2 * average, limits->spin_ns), deadline);
 
-    if (mutex_lock(receiver->buffer->mutex) != CHANNEL_MUTEX_SUCCESS) {
-        return NULL;
-    }
+    for (unsigned spins = 1; now < stop; spins++) {
+        if (ready(context)) {
+            return true;
+        }
 
-    if (!receiver->buffer->sender_alive && receiver->buffer->message == NULL) {
-        mutex_release(receiver->buffer->mutex);
-        return NULL;
+        channel_pause();
+
+        if (spins % WAIT_SPINS_PER_CHECK == 0) {
+            now = channel_now();
+        }
     }
 
-    RendezvousMessage* new_message = receiver->buffer->message;
-    void* message = new_message->message;
-    free(new_message);
-    receiver->buffer->message = NULL;
+    for (unsigned yields = 0; yields < limits->yields; yields++) {
+        channel_yield();
 
-    if (mutex_release(receiver->buffer->mutex) != CHANNEL_MUTEX_SUCCESS) {
-        return NULL;
+        if (ready(context)) {
+            return true;
+        }
     }
 
-    return message;
+    return false;
 }
 
-void* rendezvous_recv_c(RendezvousChannel* channel)
+// A non-blocking attempt at an operation, for `channel_spin` to retry.
+typedef struct SpinAttempt_ {
+    int (*attempt)(BatchOperation* operation);
+    BatchOperation* operation;
+    int result;
+} SpinAttempt;
+
+// Makes one attempt of a `SpinAttempt`, keeping its result.
+static bool spin_attempt_ready(void* attempt_vp)
 {
-    return rendezvous_recv(channel->receiver);
+    SpinAttempt* attempt = (SpinAttempt*)attempt_vp;
+    attempt->result = attempt->attempt(attempt->operation);
+
+    return attempt->result != CHANNEL_WOULD_BLOCK;
 }
 
-void free_rendezvous_channel(RendezvousChannel* channel)
+// A condition on the state of a mutex-protected channel, for `channel_spin` to
+// retry.
+typedef struct SpinCondition_ {
+    Mutex* mutex;
+    bool (*ready)(void* buffer);
+    void* buffer;
+} SpinCondition;
+
+// Checks a `SpinCondition` if the mutex can be taken without waiting. If the
+// condition holds, the mutex is kept.
+static bool spin_condition_ready(void* condition_vp)
 {
-    if (channel->sender->buffer->message != NULL) {
-        free(channel->sender->buffer->message);
+    SpinCondition* condition = (SpinCondition*)condition_vp;
+
+    if (!mutex_try_lock(condition->mutex)) {
+        return false;
     }
 
-    free_mutex(channel->sender->buffer->mutex);
-    free(channel->sender->buffer);
-    free(channel->sender);
-    free(channel->receiver);
-    free(channel);
-}
+    if (condition->ready(condition->buffer)) {
+        return true;
+    }
 
-void free_rendezvous_channel_wrapper(RendezvousChannel* channel)
-{
-    free(channel);
+    mutex_release(condition->mutex);
+
+    return false;
 }
 
-void free_rendezvous_sender(RendezvousSender* sender)
+// Waits for `ready` to hold on a mutex-protected channel whose mutex is held,
+// like `channel_wait`. If the wait policy allows, the mutex is released and
+// the condition polled before the thread parks.
+static int channel_wait_locked(
+    WaitQueue* queue,
+    Mutex* mutex,
+    ChannelWaitState* wait,
+    bool (*ready)(void* buffer),
+    void* buffer,
+    uint64_t deadline,
+    ChannelCounters* counters)
 {
-    sender->buffer->sender_alive = false;
+    // Non-blocking calls arrive here with a deadline that has already passed,
+    // and must not be counted as waits.
+    if (deadline != CHANNEL_NO_DEADLINE && channel_now() >= deadline) {
+        return CHANNEL_WAIT_TIMEOUT;
+    }
+
+    uint64_t start = channel_wait_start(wait);
+
+    if (channel_should_spin(wait, deadline)) {
+        if (mutex_release(mutex) != CHANNEL_MUTEX_SUCCESS) {
+            return CHANNEL_MUTEX_FAILURE;
+        }
+
+        SpinCondition condition = { mutex, ready, buffer };
+        bool spun = channel_spin(wait, deadline, spin_condition_ready, &condition);
+
+        if (!spun && channel_lock(mutex, counters) != CHANNEL_MUTEX_SUCCESS) {
+            return CHANNEL_MUTEX_FAILURE;
+        }
+
+        // The condition has to be checked again once the mutex is retaken, as
+        // a notification sent while it was released is lost.
+        if (spun || ready(buffer)) {
+            channel_wait_done(wait, start);
 
-    if (!sender->buffer->receiver_alive) {
-        if (sender->buffer->message != NULL) {
-            free(sender->buffer->message);
+            return CHANNEL_MUTEX_SUCCESS;
         }
+    }
+
+    int result = channel_wait(queue, mutex, deadline, counters);
 
-        free_mutex(sender->buffer->mutex);
-        free(sender->buffer);
+    if (result == CHANNEL_MUTEX_SUCCESS && ready(buffer)) {
+        channel_wait_done(wait, start);
     }
 
-    free(sender);
+    return result;
 }
 
-void free_rendezvous_receiver(RendezvousReceiver* receiver)
+// Repeatedly makes a non-blocking attempt at an operation, parking the calling
+// thread on the wait queue between attempts. The waiter is registered before
+// the final check, so a notification sent after a failed attempt is never
+// missed. The returned value is the result of the first attempt that does not
+// return `CHANNEL_WOULD_BLOCK`, or `CHANNEL_TIMEOUT` if the deadline passes
+// first. Before parking, the attempt is retried for as long as the wait
+// policy in `wait` allows. Waits are counted in `counters`.
+static int park_until_complete(
+    WaitQueue* queue,
+    ChannelWaitState* wait,
+    int (*attempt)(BatchOperation* operation),
+    BatchOperation* operation,
+    uint64_t deadline,
+    ChannelCounters* counters)
 {
-    receiver->buffer->receiver_alive = false;
+    int result = attempt(operation);
+
+    if (result != CHANNEL_WOULD_BLOCK) {
+        return result;
+    }
+
+    if (deadline != CHANNEL_NO_DEADLINE && channel_now() >= deadline) {
+        return CHANNEL_TIMEOUT;
+    }
+
+    uint64_t start = channel_wait_start(wait);
+    SpinAttempt spin = { attempt, operation, CHANNEL_WOULD_BLOCK };
+
+    if (channel_spin(wait, deadline, spin_attempt_ready, &spin)) {
+        channel_wait_done(wait, start);
+
+        return spin.result;
+    }
+
+    Parker parker;
+    parker_init(&parker);
+
+    Waiter waiter;
+    waiter.parker = &parker;
 
-    if (!receiver->buffer->sender_alive) {
-        if (receiver->buffer->message != NULL) {
-            free(receiver->buffer->message);
+    for (;;) {
+        wait_queue_register(queue, &waiter);
+        result = attempt(operation);
+
+        if (result != CHANNEL_WOULD_BLOCK) {
+            if (wait_queue_unregister(queue, &waiter)) {
+                // We were handed a notification we no longer need, so pass it
+                // on to the next waiter.
+                wait_queue_notify_one(queue);
+            }
+
+            break;
+        }
+
+        bool unparked = channel_park(&parker, deadline, counters);
+
+        if (!wait_queue_unregister(queue, &waiter) && !unparked) {
+            result = CHANNEL_TIMEOUT;
+            break;
         }
+    }
 
-        free_mutex(receiver->buffer->mutex);
-        free(receiver->buffer);
+    parker_destroy(&parker);
+
+    if (result != CHANNEL_TIMEOUT) {
+        channel_wait_done(wait, start);
     }
 
-    free(receiver);
+    return result;
 }
 
-BoundedChannel* bounded_channel(size_t capacity)
+// Returns the options to create a channel with, substituting the defaults for
+// NULL.
+static const ChannelOptions* channel_options(const ChannelOptions* options)
 {
-    if (capacity == 0) {
-        return NULL;
-    }
+    static const ChannelOptions defaults = { CHANNEL_LOCK_DEFAULT, false, false, false, NULL, false, 0 };
 
-    Mutex* mutex = new_mutex();
-    atomic_flag send_blocked = ATOMIC_FLAG_INIT;
+    return options != NULL ? options : &defaults;
+}
 
-    BoundedMessage** messages = NEW_N(BoundedMessage*, capacity);
+// Allocates memory for a channel created without an allocator.
+static void* default_allocate(void* context, size_t size, size_t alignment)
+{
+    (void)context;
 
-    for (size_t i = 0; i < capacity; i++) {
-        messages[i] = NEW(BoundedMessage);
-        messages[i]->message = NULL;
-    }
+    // `posix_memalign` rejects alignments smaller than a pointer.
+    return channel_aligned_alloc(alignment < sizeof(void*) ? sizeof(void*) : alignment, size);
+}
 
-    BoundedChannelBuffer* buffer = NEW(BoundedChannelBuffer);
-    buffer->capacity = capacity;
-    buffer->size = 0;
-    buffer->head_offset = 0;
-    buffer->messages = messages;
-    buffer->sender_alive = true;
-    buffer->receiver_alive = true;
-    buffer->mutex = mutex;
-    buffer->send_blocked = send_blocked;
+// Frees memory allocated by `default_allocate`.
+static void default_deallocate(void* context, void* pointer, size_t size)
+{
+    (void)context;
+    (void)size;
 
-    BoundedSender* sender = NEW(BoundedSender);
-    sender->buffer = buffer;
+    channel_aligned_free(pointer);
+}
 
-    BoundedReceiver* receiver = NEW(BoundedReceiver);
-    receiver->buffer = buffer;
+// Returns the allocator to create a channel with, substituting the default
+// for NULL.
+static ChannelAllocator channel_allocator(const ChannelOptions* options)
+{
+    if (options->allocator != NULL) {
+        return *options->allocator;
+    }
 
-    BoundedChannel* channel = NEW(BoundedChannel);
-    channel->sender = sender;
-    channel->receiver = receiver;
+    ChannelAllocator allocator = { default_allocate, default_deallocate, NULL };
 
-    return channel;
+    return allocator;
 }
 
-int bounded_send(BoundedSender* sender, void* message)
+// Allocates memory owned by a channel.
+static void* channel_allocate(const ChannelAllocator* allocator, size_t size, size_t alignment)
 {
-    if (!sender->buffer->receiver_alive) {
-        return CHANNEL_CLOSED;
+    return allocator->allocate(allocator->context, size, alignment);
+}
+
+// Frees memory allocated by `channel_allocate`. Like `free`, this does nothing
+// for NULL.
+static void channel_deallocate(const ChannelAllocator* allocator, void* pointer, size_t size)
+{
+    if (pointer != NULL) {
+        allocator->deallocate(allocator->context, pointer, size);
     }
+}
+
+// The number of bits below the leading one of a latency that pick its bucket
+// within its power of two. This is the base-two logarithm of
+// `CHANNEL_LATENCY_SUB_BUCKETS`.
+#define LATENCY_SUB_BUCKET_BITS 3
+
+// Returns the position of the leading one of a nonzero number.
+static unsigned latency_log2(uint64_t value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return 63 - __builtin_clzll(value);
+#else
+    unsigned log = 0;
 
-    while (atomic_flag_test_and_set(&sender->buffer->send_blocked)) {
-        channel_wait();
+    while (value >>= 1) {
+        log++;
     }
 
-    if (mutex_lock(sender->buffer->mutex) != CHANNEL_MUTEX_SUCCESS) {
-        atomic_flag_clear(&sender->buffer->send_blocked);
-        return CHANNEL_MUTEX_ERROR;
+    return log;
+#endif
+}
+
+// Returns the bucket of a latency histogram a latency falls in.
+static size_t latency_bucket(uint64_t latency_ns)
+{
+    if (latency_ns < CHANNEL_LATENCY_SUB_BUCKETS) {
+        return latency_ns;
     }
 
-    if (!sender->buffer->receiver_alive) {
-        if (mutex_release(sender->buffer->mutex) != CHANNEL_MUTEX_SUCCESS) {
-            return CHANNEL_MUTEX_ERROR;
-        }
+    unsigned log = latency_log2(latency_ns);
+    size_t sub_bucket = (size_t)(latency_ns >> (log - LATENCY_SUB_BUCKET_BITS)) - CHANNEL_LATENCY_SUB_BUCKETS;
 
-        return CHANNEL_CLOSED;
+    return (log - LATENCY_SUB_BUCKET_BITS + 1) * CHANNEL_LATENCY_SUB_BUCKETS + sub_bucket;
+}
+
+// Empties a latency histogram.
+static void latency_histogram_reset(ChannelLatencyHistogram* latency)
+{
+    for (size_t i = 0; i < CHANNEL_LATENCY_BUCKETS; i++) {
+        atomic_store_explicit(&latency->buckets[i], 0, memory_order_relaxed);
     }
 
-    sender->buffer->messages[(sender->buffer->head_offset + sender->buffer->size) % sender->buffer->capacity]->message = message;
-    sender->buffer->size++;
+    atomic_store_explicit(&latency->total_ns, 0, memory_order_relaxed);
+    atomic_store_explicit(&latency->min_ns, UINT64_MAX, memory_order_relaxed);
+    atomic_store_explicit(&latency->max_ns, 0, memory_order_relaxed);
+}
 
-    if (sender->buffer->size < sender->buffer->capacity) {
-        atomic_flag_clear(&sender->buffer->send_blocked);
+// Creates an empty latency histogram if `trace` is set, and returns NULL
+// otherwise.
+static ChannelLatencyHistogram* new_latency_histogram(const ChannelAllocator* allocator, bool trace)
+{
+    if (!trace) {
+        return NULL;
     }
 
-    if (mutex_release(sender->buffer->mutex) != CHANNEL_MUTEX_SUCCESS) {
-        return CHANNEL_MUTEX_ERROR;
+    ChannelLatencyHistogram* latency = (ChannelLatencyHistogram*)channel_allocate(
+        allocator, sizeof(ChannelLatencyHistogram), CHANNEL_CACHE_LINE);
+
+    for (size_t i = 0; i < CHANNEL_LATENCY_BUCKETS; i++) {
+        atomic_init(&latency->buckets[i], 0);
     }
 
-    return CHANNEL_SUCCESS;
+    atomic_init(&latency->total_ns, 0);
+    atomic_init(&latency->min_ns, UINT64_MAX);
+    atomic_init(&latency->max_ns, 0);
+
+    return latency;
 }
 
-int bounded_send_c(BoundedChannel* channel, void* message)
+// Returns the time to stamp or time messages with, if the channel traces
+// latency. Channels that do not are spared the clock read.
+static uint64_t latency_now(const ChannelLatencyHistogram* latency)
 {
-    return bounded_send(channel->sender, message);
+    return latency != NULL ? channel_now() : 0;
 }
 
-void* bounded_recv(BoundedReceiver* receiver)
+// Records the latency of a message sent at `sent_at` and received at `now`.
+static void latency_record(ChannelLatencyHistogram* latency, uint64_t sent_at, uint64_t now)
 {
-    if (!receiver->buffer->sender_alive && receiver->buffer->size == 0) {
-        return NULL;
+    uint64_t elapsed = now > sent_at ? now - sent_at : 0;
+    atomic_fetch_add_explicit(&latency->buckets[latency_bucket(elapsed)], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&latency->total_ns, elapsed, memory_order_relaxed);
+
+    uint64_t min_ns = atomic_load_explicit(&latency->min_ns, memory_order_relaxed);
+
+    while (elapsed < min_ns
+           && !atomic_compare_exchange_weak_explicit(
+               &latency->min_ns, &min_ns, elapsed, memory_order_relaxed, memory_order_relaxed)) {
     }
 
-    while (receiver->buffer->size == 0 && receiver->buffer->sender_alive) {
-        channel_wait();
+    uint64_t max_ns = atomic_load_explicit(&latency->max_ns, memory_order_relaxed);
+
+    while (elapsed > max_ns
+           && !atomic_compare_exchange_weak_explicit(
+               &latency->max_ns, &max_ns, elapsed, memory_order_relaxed, memory_order_relaxed)) {
     }
+}
 
-    if (mutex_lock(receiver->buffer->mutex) != CHANNEL_MUTEX_SUCCESS) {
-        return NULL;
+// Takes a snapshot of a latency histogram, which may be NULL for a channel
+// that does not trace latency.
+static bool latency_snapshot(ChannelLatencyHistogram* latency, ChannelLatency* snapshot)
+{
+    memset(snapshot, 0, sizeof(ChannelLatency));
+
+    if (latency == NULL) {
+        return false;
     }
 
-    if (!receiver->buffer->sender_alive && receiver->buffer->size == 0) {
-        mutex_release(receiver->buffer->mutex);
-        return NULL;
+    for (size_t i = 0; i < CHANNEL_LATENCY_BUCKETS; i++) {
+        snapshot->buckets[i] = atomic_load_explicit(&latency->buckets[i], memory_order_relaxed);
+        snapshot->count += snapshot->buckets[i];
     }
 
-    void* message = receiver->buffer->messages[receiver->buffer->head_offset]->message;
-    receiver->buffer->head_offset = (receiver->buffer->head_offset + 1) % receiver->buffer->capacity;
-    receiver->buffer->size--;
-    atomic_flag_clear(&receiver->buffer->send_blocked);
+    if (snapshot->count > 0) {
+        snapshot->total_ns = atomic_load_explicit(&latency->total_ns, memory_order_relaxed);
+        snapshot->min_ns = atomic_load_explicit(&latency->min_ns, memory_order_relaxed);
+        snapshot->max_ns = atomic_load_explicit(&latency->max_ns, memory_order_relaxed);
 
-    if (mutex_release(receiver->buffer->mutex) != CHANNEL_MUTEX_SUCCESS) {
-        return NULL;
+        // A reset racing with the snapshot may have left the bounds behind.
+        if (snapshot->min_ns > snapshot->max_ns) {
+            snapshot->min_ns = snapshot->max_ns;
+        }
     }
 
-    return message;
+    return true;
 }
 
-void* bounded_recv_c(BoundedChannel* channel)
+// Returns the event descriptor of the receiving side of a channel, creating
+// it on first use. A new descriptor is signaled right away, since the channel
+// may hold messages already.
+static int channel_event_fd(atomic_int* event_fd)
 {
-    return bounded_recv(channel->receiver);
+    int fd = atomic_load_explicit(event_fd, memory_order_acquire);
+
+#ifdef __linux__
+    if (fd < 0) {
+        int created = eventfd(1, EFD_NONBLOCK | EFD_CLOEXEC);
+
+        if (created < 0) {
+            return -1;
+        }
+
+        // Receivers sharing a channel may race to create the descriptor.
+        if (atomic_compare_exchange_strong_explicit(
+                event_fd, &fd, created, memory_order_acq_rel, memory_order_acquire)) {
+            fd = created;
+        }
+        else {
+            close(created);
+        }
+    }
+#endif
+
+    return fd;
 }
 
-void free_bounded_channel(BoundedChannel* channel)
+// Arms the event descriptor of a channel that a receiver found empty, if
+// there is one, so that the next message sent signals it. If `true` is
+// returned, the event was disarmed, and messages sent before it was armed
+// again went unsignaled, so the receiver must look once more.
+static bool channel_event_rearm(WaitQueue* recv_waiters, atomic_int* event_fd)
 {
-    for (size_t i = 0; i < channel->sender->buffer->capacity; i++) {
-        free(channel->sender->buffer->messages[i]);
-    }
+    int fd = atomic_load_explicit(event_fd, memory_order_acquire);
 
-    free(channel->sender->buffer->messages);
-    free_mutex(channel->sender->buffer->mutex);
-    free(channel->sender->buffer);
-    free(channel->sender);
-    free(channel->receiver);
-    free(channel);
+    return fd >= 0 && wait_queue_arm_event(recv_waiters, fd);
 }
 
-void free_bounded_channel_wrapper(BoundedChannel* channel)
+// Closes the event descriptor of a channel being freed, if there is one.
+static void channel_event_close(atomic_int* event_fd)
 {
-    free(channel);
+#ifdef __linux__
+    int fd = atomic_load(event_fd);
+
+    if (fd >= 0) {
+        close(fd);
+    }
+#else
+    (void)event_fd;
+#endif
 }
 
-void free_bounded_sender(BoundedSender* sender)
+// Returns whether any of the given flags is set in the lifecycle state of a
+// channel.
+static bool channel_closed(atomic_uint_fast64_t* state, uint64_t flags)
 {
-    sender->buffer->sender_alive = false;
+    return (atomic_load(state) & flags) != 0;
+}
 
-    if (!sender->buffer->receiver_alive) {
-        free(sender->buffer->messages);
-        free_mutex(sender->buffer->mutex);
-        free(sender->buffer);
+// Drops a handle of the kind given by `handle`, `CHANNEL_STATE_SENDER` or
+// `CHANNEL_STATE_RECEIVER`, unless it is the last one of its kind. In that case
+// the state is left as is and `true` is returned: the caller closes its side of
+// the channel while its handle keeps the buffer alive, and releases the handle
+// with `channel_release_handle` afterwards. Deciding this in the same atomic
+// step as the decrement means that of two handles dropped concurrently exactly
+// one is seen as the last.
+static bool channel_drop_handle(atomic_uint_fast64_t* state, uint64_t handle)
+{
+    uint64_t mask = handle == CHANNEL_STATE_SENDER
+        ? CHANNEL_STATE_RECEIVER - CHANNEL_STATE_SENDER
+        : ~(CHANNEL_STATE_RECEIVER - 1);
+    uint_fast64_t old = atomic_load(state);
+
+    while ((old & mask) != handle) {
+        if (atomic_compare_exchange_weak(state, &old, old - handle)) {
+            return false;
+        }
     }
 
-    free(sender);
+    return true;
 }
 
-void free_bounded_receiver(BoundedReceiver* receiver)
+// Releases a handle of the kind given by `handle`. If it was the last handle
+// of either kind, `true` is returned and the caller has to free the buffer.
+static bool channel_release_handle(atomic_uint_fast64_t* state, uint64_t handle)
 {
-    receiver->buffer->receiver_alive = false;
+    return atomic_fetch_sub(state, handle) - handle < CHANNEL_STATE_SENDER;
+}
 
-    if (!receiver->buffer->sender_alive) {
-        free(receiver->buffer->messages);
-        free_mutex(receiver->buffer->mutex);
-        free(receiver->buffer);
-    }
+// Sets closed flags in the lifecycle state of a channel with the mutex held,
+// so that a thread checking the state under the mutex before it waits either
+// sees the flags or is woken afterwards.
+static void channel_close_locked(atomic_uint_fast64_t* state, Mutex* mutex, uint64_t flags)
+{
+    mutex_lock(mutex);
+    atomic_fetch_or(state, flags);
+    mutex_release(mutex);
+}
 
-    free(receiver);
+// Frees the internal buffer of a rendezvous channel.
+static void free_rendezvous_buffer(RendezvousChannelBuffer* buffer)
+{
+    ChannelAllocator allocator = buffer->allocator;
+
+    wait_queue_destroy(&buffer->send_waiters);
+    wait_queue_destroy(&buffer->recv_waiters);
+    mutex_destroy(&buffer->mutex);
+    channel_deallocate(&allocator, buffer, sizeof(RendezvousChannelBuffer));
 }
 
-UnboundedChannel* unbounded_channel(void)
+RendezvousChannel* rendezvous_channel(void)
 {
-    Mutex* mutex = new_mutex();
+    return rendezvous_channel_with(NULL);
+}
 
-    UnboundedChannelBuffer* buffer = NEW(UnboundedChannelBuffer);
-    buffer->size = 0;
-    buffer->first_message = NULL;
-    buffer->last_message = NULL;
-    buffer->sender_alive = true;
-    buffer->receiver_alive = true;
-    buffer->mutex = mutex;
+RendezvousChannel* rendezvous_channel_with(const ChannelOptions* options)
+{
+    options = channel_options(options);
 
-    UnboundedSender* sender = NEW(UnboundedSender);
+    if (options->lockfree
+        || options->multi_consumer
+        || options->single_producer
+        || options->trace_latency
+        || options->wait_policy != CHANNEL_WAIT_POWER_SAVING) {
+        return NULL;
+    }
+
+    ChannelAllocator allocator = channel_allocator(options);
+    RendezvousChannelBuffer* buffer = (RendezvousChannelBuffer*)channel_allocate(
+        &allocator, sizeof(RendezvousChannelBuffer), _Alignof(RendezvousChannelBuffer));
+    buffer->allocator = allocator;
+    buffer->blocked_senders.head = NULL;
+    buffer->blocked_senders.tail = NULL;
+    buffer->blocked_receivers.head = NULL;
+    buffer->blocked_receivers.tail = NULL;
+    atomic_init(&buffer->state, CHANNEL_STATE_SENDER + CHANNEL_STATE_RECEIVER);
+    mutex_init(&buffer->mutex, options->lock);
+    wait_queue_init(&buffer->send_waiters);
+    wait_queue_init(&buffer->recv_waiters);
+    channel_counters_init(&buffer->send_counters);
+    channel_counters_init(&buffer->recv_counters);
+
+    RendezvousSender* sender = NEW(RendezvousSender);
     sender->buffer = buffer;
 
-    UnboundedReceiver* receiver = NEW(UnboundedReceiver);
+    RendezvousReceiver* receiver = NEW(RendezvousReceiver);
     receiver->buffer = buffer;
 
-    UnboundedChannel* channel = NEW(UnboundedChannel);
+    RendezvousChannel* channel = NEW(RendezvousChannel);
     channel->sender = sender;
     channel->receiver = receiver;
 
     return channel;
 }
 
-int unbounded_send(UnboundedSender* sender, void* message)
+// Adds a blocked thread to the back of a rendezvous queue. The buffer mutex
+// must be held.
+static void rendezvous_enqueue(RendezvousQueue* queue, RendezvousWaiter* waiter)
 {
-    if (!sender->buffer->receiver_alive) {
-        return CHANNEL_CLOSED;
-    }
+    waiter->prev = queue->tail;
+    waiter->next = NULL;
 
-    if (mutex_lock(sender->buffer->mutex) != CHANNEL_MUTEX_SUCCESS) {
-        return CHANNEL_MUTEX_ERROR;
+    if (queue->tail != NULL) {
+        queue->tail->next = waiter;
+    }
+    else {
+        queue->head = waiter;
     }
 
-    if (!sender->buffer->receiver_alive) {
-        if (mutex_release(sender->buffer->mutex) != CHANNEL_MUTEX_SUCCESS) {
-            return CHANNEL_MUTEX_ERROR;
-        }
+    queue->tail = waiter;
+}
 
-        return CHANNEL_CLOSED;
+// Removes a blocked thread from a rendezvous queue. The buffer mutex must be
+// held.
+static void rendezvous_remove(RendezvousQueue* queue, RendezvousWaiter* waiter)
+{
+    if (waiter->prev != NULL) {
+        waiter->prev->next = waiter->next;
+    }
+    else {
+        queue->head = waiter->next;
     }
 
-    UnboundedMessage* this_message = NEW(UnboundedMessage);
-    this_message->message = message;
-    this_message->next = NULL;
-
-    if (sender->buffer->last_message != NULL) {
-        sender->buffer->last_message->next = this_message;
+    if (waiter->next != NULL) {
+        waiter->next->prev = waiter->prev;
     }
     else {
-        sender->buffer->first_message = this_message;
+        queue->tail = waiter->prev;
     }
+}
 
-    sender->buffer->last_message = this_message;
-    sender->buffer->size++;
+// Marks the thread at the front of a rendezvous queue as done and wakes it.
+// The waiter lives on that thread's stack, and the thread cannot leave before
+// it reacquires the buffer mutex, which is why this must be called with the
+// mutex held.
+static void rendezvous_complete_front(RendezvousQueue* queue)
+{
+    RendezvousWaiter* waiter = queue->head;
+    rendezvous_remove(queue, waiter);
+    waiter->complete = true;
+    parker_unpark(waiter->parker);
+}
 
-    if (mutex_release(sender->buffer->mutex) != CHANNEL_MUTEX_SUCCESS) {
-        return CHANNEL_MUTEX_ERROR;
+// Returns the receiver at the front of a rendezvous queue that may be filled,
+// or NULL if there is none. Receivers blocked in a select are claimed first;
+// those whose select has already completed another case are dropped from the
+// queue and marked complete so that their thread does not remove them again.
+// The buffer mutex must be held.
+static RendezvousWaiter* rendezvous_claim_front(RendezvousQueue* queue)
+{
+    RendezvousWaiter* waiter;
+
+    while ((waiter = queue->head) != NULL && waiter->claim != NULL) {
+        size_t unclaimed = SIZE_MAX;
+
+        if (atomic_compare_exchange_strong(waiter->claim, &unclaimed, waiter->index)) {
+            break;
+        }
+
+        rendezvous_remove(queue, waiter);
+        waiter->complete = true;
     }
 
-    return CHANNEL_SUCCESS;
+    return waiter;
 }
 
-int unbounded_send_c(UnboundedChannel* channel, void* message)
+// Wakes every thread in a rendezvous queue without completing it, so that it
+// notices the channel was closed. The buffer mutex must be held.
+static void rendezvous_wake_all(RendezvousQueue* queue)
 {
-    return unbounded_send(channel->sender, message);
+    for (RendezvousWaiter* waiter = queue->head; waiter != NULL; waiter = waiter->next) {
+        parker_unpark(waiter->parker);
+    }
 }
 
-void* unbounded_recv(UnboundedReceiver* receiver)
+// Parks the calling thread until its waiter is completed by the other side,
+// one of the `closed` flags is set or the deadline passes. The waiter must
+// already be enqueued and the buffer mutex held; the mutex is held again on
+// return. If the waiter was not completed it is removed from the queue.
+static int rendezvous_park(
+    RendezvousChannelBuffer* buffer,
+    RendezvousQueue* queue,
+    RendezvousWaiter* waiter,
+    uint64_t closed,
+    uint64_t deadline,
+    ChannelCounters* counters)
 {
-    if (!receiver->buffer->sender_alive && receiver->buffer->size == 0) {
-        return NULL;
-    }
+    while (!waiter->complete && !channel_closed(&buffer->state, closed)) {
+        mutex_release(&buffer->mutex);
+        bool unparked = channel_park(waiter->parker, deadline, counters);
+        mutex_lock(&buffer->mutex);
 
-    while (receiver->buffer->size == 0 && receiver->buffer->sender_alive) {
-        channel_wait();
+        if (!unparked) {
+            break;
+        }
     }
 
-    if (mutex_lock(receiver->buffer->mutex) != CHANNEL_MUTEX_SUCCESS) {
-        return NULL;
+    if (waiter->complete) {
+        return CHANNEL_SUCCESS;
     }
 
-    if (!receiver->buffer->sender_alive && receiver->buffer->size == 0) {
-        mutex_release(receiver->buffer->mutex);
-        return NULL;
-    }
+    rendezvous_remove(queue, waiter);
 
-    UnboundedMessage* this_message = receiver->buffer->first_message;
-    receiver->buffer->first_message = this_message->next;
-    void* message = this_message->message;
-    free(this_message);
+    return channel_closed(&buffer->state, closed) ? CHANNEL_CLOSED : CHANNEL_TIMEOUT;
+}
 
-    receiver->buffer->size--;
+// Sends messages through a rendezvous channel. Messages are written straight
+// into the arrays of blocked receivers. If there are not enough of them, the
+// calling thread blocks with its own array enqueued, and receivers copy the
+// rest straight out of it.
+static int rendezvous_send_until(
+    RendezvousChannelBuffer* buffer,
+    void** messages,
+    size_t count,
+    size_t* sent,
+    uint64_t deadline)
+{
+    size_t done = 0;
+    int result = CHANNEL_SUCCESS;
 
-    if (receiver->buffer->first_message == NULL) {
-        receiver->buffer->last_message = NULL;
+    if (sent != NULL) {
+        *sent = 0;
     }
 
-    if (mutex_release(receiver->buffer->mutex) != CHANNEL_MUTEX_SUCCESS) {
-        return NULL;
+    if (count == 0) {
+        return CHANNEL_SUCCESS;
     }
 
-    return message;
-}
+    if (channel_lock(&buffer->mutex, &buffer->send_counters) != CHANNEL_MUTEX_SUCCESS) {
+        return CHANNEL_MUTEX_ERROR;
+    }
+
+    if (channel_closed(&buffer->state, CHANNEL_STATE_CLOSED)) {
+        result = CHANNEL_CLOSED;
+    }
+    else {
+        RendezvousWaiter* receiver;
+
+        while (done < count && (receiver = rendezvous_claim_front(&buffer->blocked_receivers)) != NULL) {
+            size_t batch = CHANNEL_MIN(count - done, receiver->count);
+            memcpy(receiver->messages, &messages[done], batch * sizeof(void*));
+            receiver->done = batch;
+            rendezvous_complete_front(&buffer->blocked_receivers);
+            done += batch;
+        }
+
+        if (done < count) {
+            if (deadline != CHANNEL_NO_DEADLINE && channel_now() >= deadline) {
+                result = CHANNEL_TIMEOUT;
+            }
+            else {
+                Parker parker;
+                parker_init(&parker);
+
+                RendezvousWaiter waiter = { &parker, &messages[done], count - done, 0, false, NULL, NULL };
+                rendezvous_enqueue(&buffer->blocked_senders, &waiter);
+
+                // A receiver blocked in a select may be waiting for a sender to
+                // show up.
+                wait_queue_notify_one(&buffer->recv_waiters);
+
+                result = rendezvous_park(
+                    buffer, &buffer->blocked_senders, &waiter, CHANNEL_STATE_CLOSED, deadline,
+                    &buffer->send_counters);
+                done += waiter.done;
+                parker_destroy(&parker);
+            }
+        }
+    }
+
+    if (mutex_release(&buffer->mutex) != CHANNEL_MUTEX_SUCCESS) {
+        return CHANNEL_MUTEX_ERROR;
+    }
+
+    channel_count_sent(&buffer->send_counters, &buffer->recv_counters, done);
+
+    if (sent != NULL) {
+        *sent = done;
+    }
+
+    return result;
+}
+
+// Receives up to `max` messages from a rendezvous channel. Messages are copied
+// straight out of the arrays of blocked senders. If there are none, the
+// calling thread blocks with its own array enqueued for the next sender to
+// fill.
+static int rendezvous_recv_until(
+    RendezvousChannelBuffer* buffer,
+    void** messages,
+    size_t max,
+    size_t* received,
+    uint64_t deadline)
+{
+    size_t done = 0;
+    int result = CHANNEL_SUCCESS;
+
+    if (received != NULL) {
+        *received = 0;
+    }
+
+    if (max == 0) {
+        return CHANNEL_SUCCESS;
+    }
+
+    if (channel_lock(&buffer->mutex, &buffer->recv_counters) != CHANNEL_MUTEX_SUCCESS) {
+        return CHANNEL_MUTEX_ERROR;
+    }
+
+    while (done < max && buffer->blocked_senders.head != NULL) {
+        RendezvousWaiter* sender = buffer->blocked_senders.head;
+        size_t batch = CHANNEL_MIN(max - done, sender->count - sender->done);
+        memcpy(&messages[done], &sender->messages[sender->done], batch * sizeof(void*));
+        sender->done += batch;
+        done += batch;
+
+        if (sender->done == sender->count) {
+            rendezvous_complete_front(&buffer->blocked_senders);
+        }
+    }
+
+    if (done > 0) {
+        // Take what is there without waiting for more.
+    }
+    else if (channel_closed(&buffer->state, CHANNEL_STATE_SEND_CLOSED)) {
+        result = CHANNEL_CLOSED;
+    }
+    else if (deadline != CHANNEL_NO_DEADLINE && channel_now() >= deadline) {
+        result = CHANNEL_TIMEOUT;
+    }
+    else {
+        Parker parker;
+        parker_init(&parker);
+
+        RendezvousWaiter waiter = { &parker, messages, max, 0, false, NULL, NULL };
+        rendezvous_enqueue(&buffer->blocked_receivers, &waiter);
+
+        // A sender blocked in a select may be waiting for a receiver to show
+        // up.
+        wait_queue_notify_one(&buffer->send_waiters);
+
+        result = rendezvous_park(
+            buffer, &buffer->blocked_receivers, &waiter, CHANNEL_STATE_SEND_CLOSED, deadline,
+            &buffer->recv_counters);
+        done = waiter.done;
+        parker_destroy(&parker);
+    }
+
+    if (mutex_release(&buffer->mutex) != CHANNEL_MUTEX_SUCCESS) {
+        return CHANNEL_MUTEX_ERROR;
+    }
+
+    channel_count(&buffer->recv_counters.messages, done);
+
+    if (received != NULL) {
+        *received = done;
+    }
+
+    return result;
+}
+
+int rendezvous_send(RendezvousSender* sender, void* message)
+{
+    return rendezvous_send_until(sender->buffer, &message, 1, NULL, CHANNEL_NO_DEADLINE);
+}
+
+int rendezvous_send_c(RendezvousChannel* channel, void* message)
+{
+    return rendezvous_send(channel->sender, message);
+}
+
+void* rendezvous_recv(RendezvousReceiver* receiver)
+{
+    void* message = NULL;
+
+    if (rendezvous_recv_until(receiver->buffer, &message, 1, NULL, CHANNEL_NO_DEADLINE) != CHANNEL_SUCCESS) {
+        return NULL;
+    }
+
+    return message;
+}
+
+void* rendezvous_recv_c(RendezvousChannel* channel)
+{
+    return rendezvous_recv(channel->receiver);
+}
+
+int rendezvous_send_timeout(RendezvousSender* sender, void* message, double timeout)
+{
+    return rendezvous_send_deadline(sender, message, channel_deadline(timeout));
+}
+
+int rendezvous_send_timeout_c(RendezvousChannel* channel, void* message, double timeout)
+{
+    return rendezvous_send_timeout(channel->sender, message, timeout);
+}
+
+int rendezvous_send_deadline(RendezvousSender* sender, void* message, uint64_t deadline)
+{
+    return rendezvous_send_until(sender->buffer, &message, 1, NULL, deadline);
+}
+
+int rendezvous_send_deadline_c(RendezvousChannel* channel, void* message, uint64_t deadline)
+{
+    return rendezvous_send_deadline(channel->sender, message, deadline);
+}
+
+int rendezvous_recv_timeout(RendezvousReceiver* receiver, void** message, double timeout)
+{
+    return rendezvous_recv_deadline(receiver, message, channel_deadline(timeout));
+}
+
+int rendezvous_recv_timeout_c(RendezvousChannel* channel, void** message, double timeout)
+{
+    return rendezvous_recv_timeout(channel->receiver, message, timeout);
+}
+
+int rendezvous_recv_deadline(RendezvousReceiver* receiver, void** message, uint64_t deadline)
+{
+    return rendezvous_recv_until(receiver->buffer, message, 1, NULL, deadline);
+}
+
+int rendezvous_recv_deadline_c(RendezvousChannel* channel, void** message, uint64_t deadline)
+{
+    return rendezvous_recv_deadline(channel->receiver, message, deadline);
+}
+
+int rendezvous_try_send(RendezvousSender* sender, void* message)
+{
+    RendezvousChannelBuffer* buffer = sender->buffer;
+
+    if (channel_lock(&buffer->mutex, &buffer->send_counters) != CHANNEL_MUTEX_SUCCESS) {
+        return CHANNEL_MUTEX_ERROR;
+    }
+
+    int result = CHANNEL_SUCCESS;
+
+    if (channel_closed(&buffer->state, CHANNEL_STATE_CLOSED)) {
+        result = CHANNEL_CLOSED;
+    }
+    else if (rendezvous_claim_front(&buffer->blocked_receivers) != NULL) {
+        buffer->blocked_receivers.head->messages[0] = message;
+        buffer->blocked_receivers.head->done = 1;
+        rendezvous_complete_front(&buffer->blocked_receivers);
+    }
+    else {
+        // A receiver in a select that has not queued itself yet retries and
+        // does.
+        wait_queue_notify_one(&buffer->recv_waiters);
+        result = CHANNEL_FULL;
+    }
+
+    if (mutex_release(&buffer->mutex) != CHANNEL_MUTEX_SUCCESS) {
+        return CHANNEL_MUTEX_ERROR;
+    }
+
+    if (result == CHANNEL_SUCCESS) {
+        channel_count_sent(&buffer->send_counters, &buffer->recv_counters, 1);
+    }
+
+    return result;
+}
+
+int rendezvous_try_send_c(RendezvousChannel* channel, void* message)
+{
+    return rendezvous_try_send(channel->sender, message);
+}
+
+int rendezvous_try_recv(RendezvousReceiver* receiver, void** message)
+{
+    int result = rendezvous_recv_until(receiver->buffer, message, 1, NULL, 0);
+
+    return result == CHANNEL_TIMEOUT ? CHANNEL_EMPTY : result;
+}
+
+int rendezvous_try_recv_c(RendezvousChannel* channel, void** message)
+{
+    return rendezvous_try_recv(channel->receiver, message);
+}
+
+int rendezvous_send_many(RendezvousSender* sender, void** messages, size_t count, size_t* sent)
+{
+    return rendezvous_send_until(sender->buffer, messages, count, sent, CHANNEL_NO_DEADLINE);
+}
+
+int rendezvous_send_many_c(RendezvousChannel* channel, void** messages, size_t count, size_t* sent)
+{
+    return rendezvous_send_many(channel->sender, messages, count, sent);
+}
+
+int rendezvous_send_many_timeout(
+    RendezvousSender* sender,
+    void** messages,
+    size_t count,
+    size_t* sent,
+    double timeout)
+{
+    return rendezvous_send_until(sender->buffer, messages, count, sent, channel_deadline(timeout));
+}
+
+int rendezvous_send_many_timeout_c(
+    RendezvousChannel* channel,
+    void** messages,
+    size_t count,
+    size_t* sent,
+    double timeout)
+{
+    return rendezvous_send_many_timeout(channel->sender, messages, count, sent, timeout);
+}
+
+int rendezvous_recv_many(RendezvousReceiver* receiver, void** messages, size_t max, size_t* received)
+{
+    return rendezvous_recv_until(receiver->buffer, messages, max, received, CHANNEL_NO_DEADLINE);
+}
+
+int rendezvous_recv_many_c(RendezvousChannel* channel, void** messages, size_t max, size_t* received)
+{
+    return rendezvous_recv_many(channel->receiver, messages, max, received);
+}
+
+int rendezvous_recv_many_timeout(
+    RendezvousReceiver* receiver,
+    void** messages,
+    size_t max,
+    size_t* received,
+    double timeout)
+{
+    return rendezvous_recv_until(receiver->buffer, messages, max, received, channel_deadline(timeout));
+}
+
+int rendezvous_recv_many_timeout_c(
+    RendezvousChannel* channel,
+    void** messages,
+    size_t max,
+    size_t* received,
+    double timeout)
+{
+    return rendezvous_recv_many_timeout(channel->receiver, messages, max, received, timeout);
+}
+
+void free_rendezvous_channel(RendezvousChannel* channel)
+{
+    free_rendezvous_buffer(channel->sender->buffer);
+    free(channel->sender);
+    free(channel->receiver);
+    free(channel);
+}
+
+void free_rendezvous_channel_wrapper(RendezvousChannel* channel)
+{
+    free(channel);
+}
+
+RendezvousSender* clone_rendezvous_sender(RendezvousSender* sender)
+{
+    atomic_fetch_add(&sender->buffer->state, CHANNEL_STATE_SENDER);
+
+    RendezvousSender* clone = NEW(RendezvousSender);
+    clone->buffer = sender->buffer;
+
+    return clone;
+}
+
+// Sets closed flags in the lifecycle state of a rendezvous channel and wakes
+// every thread blocked in it, so that it notices.
+static void rendezvous_close_with(RendezvousChannelBuffer* buffer, uint64_t flags)
+{
+    mutex_lock(&buffer->mutex);
+    atomic_fetch_or(&buffer->state, flags);
+    rendezvous_wake_all(&buffer->blocked_senders);
+    rendezvous_wake_all(&buffer->blocked_receivers);
+    mutex_release(&buffer->mutex);
+
+    wait_queue_notify_all(&buffer->send_waiters);
+    wait_queue_notify_all(&buffer->recv_waiters);
+}
+
+void free_rendezvous_sender(RendezvousSender* sender)
+{
+    RendezvousChannelBuffer* buffer = sender->buffer;
+
+    if (channel_drop_handle(&buffer->state, CHANNEL_STATE_SENDER)) {
+        rendezvous_close_with(buffer, CHANNEL_STATE_SEND_CLOSED);
+
+        if (channel_release_handle(&buffer->state, CHANNEL_STATE_SENDER)) {
+            free_rendezvous_buffer(buffer);
+        }
+    }
+
+    free(sender);
+}
+
+void free_rendezvous_receiver(RendezvousReceiver* receiver)
+{
+    RendezvousChannelBuffer* buffer = receiver->buffer;
+    rendezvous_close_with(buffer, CHANNEL_STATE_RECV_CLOSED);
+
+    if (channel_release_handle(&buffer->state, CHANNEL_STATE_RECEIVER)) {
+        free_rendezvous_buffer(buffer);
+    }
+
+    free(receiver);
+}
+
+void rendezvous_close(RendezvousSender* sender)
+{
+    rendezvous_close_with(sender->buffer, CHANNEL_STATE_SEND_CLOSED);
+}
+
+void rendezvous_close_c(RendezvousChannel* channel)
+{
+    rendezvous_close(channel->sender);
+}
+
+// Frees the internal buffer of a bounded channel.
+static void free_bounded_buffer(BoundedChannelBuffer* buffer)
+{
+    ChannelAllocator allocator = buffer->allocator;
+
+    if (buffer->lockfree) {
+        channel_deallocate(&allocator, buffer->slots, buffer->capacity * sizeof(BoundedSlot));
+    }
+
+    if (buffer->sized || !buffer->lockfree) {
+        channel_deallocate(&allocator, buffer->values, buffer->capacity * buffer->element_size);
+    }
+
+    channel_deallocate(&allocator, buffer->sent_at, buffer->capacity * sizeof(uint64_t));
+    channel_deallocate(&allocator, buffer->latency, sizeof(ChannelLatencyHistogram));
+    channel_event_close(&buffer->event_fd);
+    wait_queue_destroy(&buffer->send_waiters);
+    wait_queue_destroy(&buffer->recv_waiters);
+    mutex_destroy(&buffer->mutex);
+    channel_deallocate(&allocator, buffer, sizeof(BoundedChannelBuffer));
+}
+
+// Creates a bounded channel of pointers, or of values of `element_size` bytes
+// if `sized` is set.
+static BoundedChannel* new_bounded_channel(
+    size_t capacity,
+    bool sized,
+    size_t element_size,
+    const ChannelOptions* options)
+{
+    if (capacity == 0 || element_size == 0 || element_size > SIZE_MAX / capacity) {
+        return NULL;
+    }
+
+    options = channel_options(options);
+    bool single_producer = options->single_producer;
+    bool lockfree = options->lockfree && !single_producer;
+
+    if (single_producer && options->multi_consumer) {
+        return NULL;
+    }
+
+    ChannelAllocator allocator = channel_allocator(options);
+    void** messages = NULL;
+    BoundedSlot* slots = NULL;
+    unsigned char* values = NULL;
+
+    if (lockfree) {
+        slots = (BoundedSlot*)channel_allocate(&allocator, capacity * sizeof(BoundedSlot), CHANNEL_CACHE_LINE);
+
+        for (size_t i = 0; i < capacity; i++) {
+            atomic_init(&slots[i].sequence, 2 * i);
+            slots[i].message = NULL;
+        }
+    }
+
+    if (sized) {
+        values = (unsigned char*)channel_allocate(&allocator, capacity * element_size, CHANNEL_CACHE_LINE);
+    }
+    else if (!lockfree) {
+        messages = (void**)channel_allocate(&allocator, capacity * sizeof(void*), CHANNEL_CACHE_LINE);
+        values = (unsigned char*)messages;
+    }
+
+    uint64_t* sent_at = NULL;
+
+    if (options->trace_latency) {
+        sent_at = (uint64_t*)channel_allocate(&allocator, capacity * sizeof(uint64_t), CHANNEL_CACHE_LINE);
+    }
+
+    BoundedChannelBuffer* buffer = (BoundedChannelBuffer*)channel_allocate(
+        &allocator, sizeof(BoundedChannelBuffer), _Alignof(BoundedChannelBuffer));
+    buffer->allocator = allocator;
+    buffer->capacity = capacity;
+    buffer->power_of_two = (capacity & (capacity - 1)) == 0;
+    buffer->size = 0;
+    buffer->head_offset = 0;
+    buffer->messages = messages;
+    buffer->lockfree = lockfree;
+    buffer->multi_consumer = options->multi_consumer;
+    buffer->single_producer = single_producer;
+    buffer->slots = slots;
+    buffer->sized = sized;
+    buffer->element_size = element_size;
+    buffer->values = values;
+    buffer->sent_at = sent_at;
+    buffer->latency = new_latency_histogram(&allocator, options->trace_latency);
+    atomic_init(&buffer->event_fd, -1);
+    atomic_init(&buffer->head, 0);
+    atomic_init(&buffer->tail, 0);
+    buffer->cached_head = 0;
+    buffer->cached_tail = 0;
+    channel_wait_init(&buffer->send_wait, options->wait_policy);
+    channel_wait_init(&buffer->recv_wait, options->wait_policy);
+    atomic_init(&buffer->state, CHANNEL_STATE_SENDER + CHANNEL_STATE_RECEIVER);
+    mutex_init(&buffer->mutex, options->lock);
+    wait_queue_init(&buffer->send_waiters);
+    wait_queue_init(&buffer->recv_waiters);
+    channel_counters_init(&buffer->send_counters);
+    channel_counters_init(&buffer->recv_counters);
+
+    BoundedSender* sender = NEW(BoundedSender);
+    sender->buffer = buffer;
+
+    BoundedReceiver* receiver = NEW(BoundedReceiver);
+    receiver->buffer = buffer;
+
+    BoundedChannel* channel = NEW(BoundedChannel);
+    channel->sender = sender;
+    channel->receiver = receiver;
+
+    return channel;
+}
+
+BoundedChannel* bounded_channel_with(size_t capacity, const ChannelOptions* options)
+{
+    return new_bounded_channel(capacity, false, sizeof(void*), options);
+}
+
+BoundedChannel* bounded_channel(size_t capacity)
+{
+    return bounded_channel_with(capacity, NULL);
+}
+
+BoundedChannel* bounded_channel_lockfree(size_t capacity)
+{
+    ChannelOptions options = { CHANNEL_LOCK_DEFAULT, true, false };
+
+    return bounded_channel_with(capacity, &options);
+}
+
+BoundedChannel* bounded_channel_mpmc(size_t capacity)
+{
+    ChannelOptions options = { CHANNEL_LOCK_DEFAULT, true, true };
+
+    return bounded_channel_with(capacity, &options);
+}
+
+BoundedChannel* spsc_bounded_channel(size_t capacity)
+{
+    ChannelOptions options = { CHANNEL_LOCK_DEFAULT, false, false, true };
+
+    return bounded_channel_with(capacity, &options);
+}
+
+BoundedChannel* bounded_channel_sized(size_t capacity, size_t element_size)
+{
+    return bounded_channel_sized_with(capacity, element_size, NULL);
+}
+
+BoundedChannel* bounded_channel_sized_with(size_t capacity, size_t element_size, const ChannelOptions* options)
+{
+    return new_bounded_channel(capacity, true, element_size, options);
+}
+
+// Maps a position in the ring of a bounded channel to a slot index.
+static size_t bounded_index(const BoundedChannelBuffer* buffer, size_t position)
+{
+    if (buffer->power_of_two) {
+        return position & (buffer->capacity - 1);
+    }
+
+    return position % buffer->capacity;
+}
+
+// Returns the address of the `index`th entry of an array of messages or, for
+// a sized channel, of values.
+static unsigned char* bounded_entry(const BoundedChannelBuffer* buffer, void* array, size_t index)
+{
+    return (unsigned char*)array + index * buffer->element_size;
+}
+
+// Copies `count` consecutive messages or values from `source` into the ring
+// of a channel that is not lock-free, starting at slot `index` and wrapping
+// around at the end of the ring.
+static void bounded_ring_write(BoundedChannelBuffer* buffer, size_t index, const unsigned char* source, size_t count)
+{
+    size_t first_run = CHANNEL_MIN(count, buffer->capacity - index);
+    memcpy(&buffer->values[index * buffer->element_size], source, first_run * buffer->element_size);
+    memcpy(buffer->values, source + first_run * buffer->element_size, (count - first_run) * buffer->element_size);
+}
+
+// Copies `count` consecutive messages or values out of the ring of a channel
+// that is not lock-free into `destination`, starting at slot `index` and
+// wrapping around at the end of the ring.
+static void bounded_ring_read(const BoundedChannelBuffer* buffer, size_t index, unsigned char* destination, size_t count)
+{
+    size_t first_run = CHANNEL_MIN(count, buffer->capacity - index);
+    memcpy(destination, &buffer->values[index * buffer->element_size], first_run * buffer->element_size);
+    memcpy(destination + first_run * buffer->element_size, buffer->values, (count - first_run) * buffer->element_size);
+}
+
+// Stamps `count` consecutive slots of the ring of a channel that traces
+// latency with the time their messages were sent, starting at slot `index`
+// and wrapping around at the end of the ring. Other channels are left alone.
+static void bounded_stamp(BoundedChannelBuffer* buffer, size_t index, size_t count, uint64_t now)
+{
+    if (buffer->latency == NULL) {
+        return;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        size_t slot = index + i < buffer->capacity ? index + i : index + i - buffer->capacity;
+        buffer->sent_at[slot] = now;
+    }
+}
+
+// Records the latencies of the messages in `count` consecutive slots of the
+// ring of a channel that traces latency, which are received at `now`.
+static void bounded_record(const BoundedChannelBuffer* buffer, size_t index, size_t count, uint64_t now)
+{
+    if (buffer->latency == NULL) {
+        return;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        size_t slot = index + i < buffer->capacity ? index + i : index + i - buffer->capacity;
+        latency_record(buffer->latency, buffer->sent_at[slot], now);
+    }
+}
+
+// Attempts to push messages into the ring of a lock-free bounded channel.
+// Senders claim slots by advancing the tail position, which is only possible
+// once the receiver has released the slots from the previous lap. As many
+// consecutive free slots as the batch needs are claimed at once.
+static int bounded_lockfree_push(BatchOperation* operation)
+{
+    BoundedChannelBuffer* buffer = (BoundedChannelBuffer*)operation->buffer;
+
+    if (channel_closed(&buffer->state, CHANNEL_STATE_CLOSED)) {
+        return CHANNEL_CLOSED;
+    }
+
+    size_t wanted = CHANNEL_MIN(operation->count - operation->done, buffer->capacity);
+    size_t position = atomic_load_explicit(&buffer->tail, memory_order_relaxed);
+
+    for (;;) {
+        // A marked tail can no longer be advanced, as it differs from every
+        // position a slot waits for.
+        if (position & CHANNEL_TAIL_CLOSED) {
+            return CHANNEL_CLOSED;
+        }
+
+        BoundedSlot* slot = &buffer->slots[bounded_index(buffer, position)];
+        size_t sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        ptrdiff_t difference = (ptrdiff_t)(sequence - 2 * position);
+
+        if (difference < 0) {
+            return CHANNEL_WOULD_BLOCK;
+        }
+
+        if (difference > 0) {
+            position = atomic_load_explicit(&buffer->tail, memory_order_relaxed);
+            continue;
+        }
+
+        size_t count = 1;
+
+        while (count < wanted) {
+            BoundedSlot* next = &buffer->slots[bounded_index(buffer, position + count)];
+
+            if (atomic_load_explicit(&next->sequence, memory_order_acquire) != 2 * (position + count)) {
+                break;
+            }
+
+            count++;
+        }
+
+        if (atomic_compare_exchange_weak_explicit(
+                &buffer->tail, &position, position + count,
+                memory_order_relaxed, memory_order_relaxed)) {
+            uint64_t now = latency_now(buffer->latency);
+
+            for (size_t i = 0; i < count; i++) {
+                size_t index = bounded_index(buffer, position + i);
+                slot = &buffer->slots[index];
+                bounded_stamp(buffer, index, 1, now);
+
+                if (buffer->sized) {
+                    memcpy(
+                        bounded_entry(buffer, buffer->values, index),
+                        bounded_entry(buffer, operation->messages, operation->done + i),
+                        buffer->element_size);
+                }
+                else {
+                    slot->message = operation->messages[operation->done + i];
+                }
+
+                atomic_store_explicit(&slot->sequence, 2 * (position + i) + 1, memory_order_release);
+            }
+
+            operation->done += count;
+            wait_queue_notify_many(&buffer->recv_waiters, count);
+
+            return CHANNEL_SUCCESS;
+        }
+    }
+}
+
+// Attempts to pop messages from the ring of a lock-free bounded channel.
+static int bounded_lockfree_pop(BatchOperation* operation)
+{
+    BoundedChannelBuffer* buffer = (BoundedChannelBuffer*)operation->buffer;
+    size_t position = atomic_load_explicit(&buffer->head, memory_order_relaxed);
+    size_t wanted = operation->count - operation->done;
+    size_t count;
+
+    for (;;) {
+        BoundedSlot* slot = &buffer->slots[bounded_index(buffer, position)];
+        size_t sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        ptrdiff_t difference = (ptrdiff_t)(sequence - (2 * position + 1));
+
+        if (difference > 0) {
+            // Another receiver took this slot already.
+            position = atomic_load_explicit(&buffer->head, memory_order_relaxed);
+            continue;
+        }
+
+        count = difference == 0 ? 1 : 0;
+
+        while (count > 0 && count < wanted) {
+            BoundedSlot* next = &buffer->slots[bounded_index(buffer, position + count)];
+
+            if (atomic_load_explicit(&next->sequence, memory_order_acquire) != 2 * (position + count) + 1) {
+                break;
+            }
+
+            count++;
+        }
+
+        if (count > 0) {
+            if (!buffer->multi_consumer) {
+                atomic_store_explicit(&buffer->head, position + count, memory_order_relaxed);
+                break;
+            }
+
+            // Other receivers compete for the same slots, so they have to be
+            // claimed before they are read.
+            if (atomic_compare_exchange_weak_explicit(
+                    &buffer->head, &position, position + count,
+                    memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+
+            continue;
+        }
+
+        size_t tail = atomic_load_explicit(&buffer->tail, memory_order_acquire);
+
+        if (!(tail & CHANNEL_TAIL_CLOSED)) {
+            return CHANNEL_WOULD_BLOCK;
+        }
+
+        if ((tail & ~CHANNEL_TAIL_CLOSED) == position) {
+            return CHANNEL_CLOSED;
+        }
+
+        // Slots claimed before the channel was closed are still being filled,
+        // and their senders are only ever a few stores away from finishing.
+        channel_yield();
+        position = atomic_load_explicit(&buffer->head, memory_order_relaxed);
+    }
+
+    uint64_t now = latency_now(buffer->latency);
+
+    for (size_t i = 0; i < count; i++) {
+        size_t index = bounded_index(buffer, position + i);
+        BoundedSlot* slot = &buffer->slots[index];
+        bounded_record(buffer, index, 1, now);
+
+        if (buffer->sized) {
+            memcpy(
+                bounded_entry(buffer, operation->messages, operation->done + i),
+                bounded_entry(buffer, buffer->values, index),
+                buffer->element_size);
+        }
+        else {
+            operation->messages[operation->done + i] = slot->message;
+        }
+
+        atomic_store_explicit(&slot->sequence, 2 * (position + i + buffer->capacity), memory_order_release);
+    }
+
+    operation->done += count;
+    wait_queue_notify_many(&buffer->send_waiters, count);
+
+    return CHANNEL_SUCCESS;
+}
+
+// Attempts to push messages into the ring of a single-producer bounded
+// channel. The sender is the only writer of the tail and keeps a copy of the
+// head, which it only refreshes from the receiver's cache line when the ring
+// looks full. Free slots are filled in at most two runs and published with a
+// single store, so the sender never waits for the receiver to make progress.
+static int bounded_spsc_push(BatchOperation* operation)
+{
+    BoundedChannelBuffer* buffer = (BoundedChannelBuffer*)operation->buffer;
+
+    if (channel_closed(&buffer->state, CHANNEL_STATE_CLOSED)) {
+        return CHANNEL_CLOSED;
+    }
+
+    size_t tail = atomic_load_explicit(&buffer->tail, memory_order_relaxed);
+    size_t wanted = operation->count - operation->done;
+    size_t free_slots = buffer->capacity - (tail - buffer->cached_head);
+
+    if (free_slots < wanted) {
+        buffer->cached_head = atomic_load_explicit(&buffer->head, memory_order_acquire);
+        free_slots = buffer->capacity - (tail - buffer->cached_head);
+
+        if (free_slots == 0) {
+            return CHANNEL_WOULD_BLOCK;
+        }
+    }
+
+    size_t count = CHANNEL_MIN(wanted, free_slots);
+    size_t index = bounded_index(buffer, tail);
+    bounded_ring_write(buffer, index, bounded_entry(buffer, operation->messages, operation->done), count);
+    bounded_stamp(buffer, index, count, latency_now(buffer->latency));
+    atomic_store_explicit(&buffer->tail, tail + count, memory_order_release);
+
+    operation->done += count;
+    wait_queue_notify_one(&buffer->recv_waiters);
+
+    return CHANNEL_SUCCESS;
+}
+
+// Attempts to pop messages from the ring of a single-producer bounded
+// channel. The receiver mirrors the sender: it keeps a copy of the tail and
+// only refreshes it when the ring looks empty.
+static int bounded_spsc_pop(BatchOperation* operation)
+{
+    BoundedChannelBuffer* buffer = (BoundedChannelBuffer*)operation->buffer;
+    size_t head = atomic_load_explicit(&buffer->head, memory_order_relaxed);
+    size_t wanted = operation->count - operation->done;
+    size_t available = buffer->cached_tail - head;
+
+    if (available < wanted) {
+        buffer->cached_tail = atomic_load_explicit(&buffer->tail, memory_order_acquire);
+        available = buffer->cached_tail - head;
+    }
+
+    if (available == 0) {
+        if (!channel_closed(&buffer->state, CHANNEL_STATE_SEND_CLOSED)) {
+            return CHANNEL_WOULD_BLOCK;
+        }
+
+        // Everything sent before the channel was closed is visible once the
+        // close is, so one more look settles whether the ring is empty.
+        buffer->cached_tail = atomic_load_explicit(&buffer->tail, memory_order_acquire);
+        available = buffer->cached_tail - head;
+
+        if (available == 0) {
+            return CHANNEL_CLOSED;
+        }
+    }
+
+    size_t count = CHANNEL_MIN(wanted, available);
+    size_t index = bounded_index(buffer, head);
+    bounded_ring_read(buffer, index, bounded_entry(buffer, operation->messages, operation->done), count);
+    bounded_record(buffer, index, count, latency_now(buffer->latency));
+    atomic_store_explicit(&buffer->head, head + count, memory_order_release);
+
+    operation->done += count;
+    wait_queue_notify_one(&buffer->send_waiters);
+
+    return CHANNEL_SUCCESS;
+}
+
+// Returns whether a sender waiting on the mutex-protected ring of a bounded
+// channel can go on.
+static bool bounded_locked_send_ready(void* buffer_vp)
+{
+    BoundedChannelBuffer* buffer = (BoundedChannelBuffer*)buffer_vp;
+
+    return buffer->size != buffer->capacity || channel_closed(&buffer->state, CHANNEL_STATE_CLOSED);
+}
+
+// Returns whether a receiver waiting on the mutex-protected ring of a bounded
+// channel can go on.
+static bool bounded_locked_recv_ready(void* buffer_vp)
+{
+    BoundedChannelBuffer* buffer = (BoundedChannelBuffer*)buffer_vp;
+
+    return buffer->size != 0 || channel_closed(&buffer->state, CHANNEL_STATE_SEND_CLOSED);
+}
+
+// Sends messages through the mutex-protected ring of a bounded channel. The
+// messages are copied into the ring in at most two runs per lock acquisition.
+static int bounded_locked_send(
+    BoundedChannelBuffer* buffer,
+    void** messages,
+    size_t count,
+    size_t* sent,
+    uint64_t deadline)
+{
+    if (channel_lock(&buffer->mutex, &buffer->send_counters) != CHANNEL_MUTEX_SUCCESS) {
+        return CHANNEL_MUTEX_ERROR;
+    }
+
+    int result = CHANNEL_SUCCESS;
+    int wait_result = CHANNEL_MUTEX_SUCCESS;
+    size_t notified = 0;
+
+    while (*sent < count) {
+        while (!bounded_locked_send_ready(buffer) && wait_result == CHANNEL_MUTEX_SUCCESS) {
+            if (*sent > notified) {
+                // Let the receivers drain what we have sent so far.
+                wait_queue_notify_many(&buffer->recv_waiters, *sent - notified);
+                notified = *sent;
+            }
+
+            wait_result = channel_wait_locked(
+                &buffer->send_waiters,
+                &buffer->mutex,
+                &buffer->send_wait,
+                bounded_locked_send_ready,
+                buffer,
+                deadline,
+                &buffer->send_counters);
+        }
+
+        if (wait_result == CHANNEL_MUTEX_FAILURE) {
+            return CHANNEL_MUTEX_ERROR;
+        }
+
+        if (channel_closed(&buffer->state, CHANNEL_STATE_CLOSED)) {
+            result = CHANNEL_CLOSED;
+            break;
+        }
+
+        if (buffer->size == buffer->capacity) {
+            result = CHANNEL_TIMEOUT;
+            break;
+        }
+
+        size_t batch = CHANNEL_MIN(count - *sent, buffer->capacity - buffer->size);
+        size_t tail = bounded_index(buffer, buffer->head_offset + buffer->size);
+        bounded_ring_write(buffer, tail, bounded_entry(buffer, messages, *sent), batch);
+        bounded_stamp(buffer, tail, batch, latency_now(buffer->latency));
+        buffer->size += batch;
+        *sent += batch;
+    }
+
+    if (mutex_release(&buffer->mutex) != CHANNEL_MUTEX_SUCCESS) {
+        return CHANNEL_MUTEX_ERROR;
+    }
+
+    if (*sent > notified) {
+        wait_queue_notify_many(&buffer->recv_waiters, *sent - notified);
+    }
+
+    return result;
+}
+
+// Receives messages from the mutex-protected ring of a bounded channel. The
+// messages are copied out of the ring in at most two runs.
+static int bounded_locked_recv(
+    BoundedChannelBuffer* buffer,
+    void** messages,
+    size_t max,
+    size_t* received,
+    uint64_t deadline)
+{
+    if (channel_lock(&buffer->mutex, &buffer->recv_counters) != CHANNEL_MUTEX_SUCCESS) {
+        return CHANNEL_MUTEX_ERROR;
+    }
+
+    int wait_result = CHANNEL_MUTEX_SUCCESS;
+
+    while (buffer->size == 0 && !channel_closed(&buffer->state, CHANNEL_STATE_SEND_CLOSED)
+           && wait_result == CHANNEL_MUTEX_SUCCESS) {
+        wait_result = channel_wait_locked(
+            &buffer->recv_waiters,
+            &buffer->mutex,
+            &buffer->recv_wait,
+            bounded_locked_recv_ready,
+            buffer,
+            deadline,
+            &buffer->recv_counters);
+    }
+
+    if (wait_result == CHANNEL_MUTEX_FAILURE) {
+        return CHANNEL_MUTEX_ERROR;
+    }
+
+    if (buffer->size == 0) {
+        int result = channel_closed(&buffer->state, CHANNEL_STATE_SEND_CLOSED) ? CHANNEL_CLOSED : CHANNEL_TIMEOUT;
+
+        if (mutex_release(&buffer->mutex) != CHANNEL_MUTEX_SUCCESS) {
+            return CHANNEL_MUTEX_ERROR;
+        }
+
+        return result;
+    }
+
+    size_t count = CHANNEL_MIN(max, buffer->size);
+    bounded_ring_read(buffer, buffer->head_offset, (unsigned char*)messages, count);
+    bounded_record(buffer, buffer->head_offset, count, latency_now(buffer->latency));
+    buffer->head_offset = bounded_index(buffer, buffer->head_offset + count);
+    buffer->size -= count;
+
+    if (mutex_release(&buffer->mutex) != CHANNEL_MUTEX_SUCCESS) {
+        return CHANNEL_MUTEX_ERROR;
+    }
+
+    *received = count;
+    wait_queue_notify_many(&buffer->send_waiters, count);
+
+    return CHANNEL_SUCCESS;
+}
+
+// Sends messages through a bounded channel, blocking until all of them are
+// sent, the receiver is destroyed or the deadline passes.
+static int bounded_send_until(
+    BoundedChannelBuffer* buffer,
+    void** messages,
+    size_t count,
+    size_t* sent,
+    uint64_t deadline)
+{
+    size_t done = 0;
+    int result = CHANNEL_SUCCESS;
+
+    if (buffer->lockfree || buffer->single_producer) {
+        BatchOperation operation = { buffer, messages, count, 0 };
+        int (*push)(BatchOperation*) = buffer->single_producer ? bounded_spsc_push : bounded_lockfree_push;
+
+        while (operation.done < count && result == CHANNEL_SUCCESS) {
+            result = park_until_complete(
+                &buffer->send_waiters, &buffer->send_wait, push, &operation, deadline, &buffer->send_counters);
+        }
+
+        done = operation.done;
+    }
+    else if (count > 0) {
+        result = bounded_locked_send(buffer, messages, count, &done, deadline);
+    }
+
+    channel_count_sent(&buffer->send_counters, &buffer->recv_counters, done);
+
+    if (sent != NULL) {
+        *sent = done;
+    }
+
+    return result;
+}
+
+// Receives up to `max` messages from a bounded channel, blocking until at
+// least one is available, the sender is destroyed or the deadline passes.
+static int bounded_recv_until(
+    BoundedChannelBuffer* buffer,
+    void** messages,
+    size_t max,
+    size_t* received,
+    uint64_t deadline)
+{
+    size_t done = 0;
+    int result = CHANNEL_SUCCESS;
+
+    if (max == 0) {
+        // Nothing to receive.
+    }
+    else if (buffer->lockfree || buffer->single_producer) {
+        BatchOperation operation = { buffer, messages, max, 0 };
+        int (*pop)(BatchOperation*) = buffer->single_producer ? bounded_spsc_pop : bounded_lockfree_pop;
+        result = park_until_complete(
+            &buffer->recv_waiters, &buffer->recv_wait, pop, &operation, deadline, &buffer->recv_counters);
+        done = operation.done;
+    }
+    else {
+        result = bounded_locked_recv(buffer, messages, max, &done, deadline);
+    }
+
+    channel_count(&buffer->recv_counters.messages, done);
+
+    if (received != NULL) {
+        *received = done;
+    }
+
+    if (result == CHANNEL_TIMEOUT && channel_event_rearm(&buffer->recv_waiters, &buffer->event_fd)) {
+        return bounded_recv_until(buffer, messages, max, received, 0);
+    }
+
+    return result;
+}
+
+int bounded_send(BoundedSender* sender, void* message)
+{
+    return bounded_send_until(sender->buffer, &message, 1, NULL, CHANNEL_NO_DEADLINE);
+}
+
+int bounded_send_c(BoundedChannel* channel, void* message)
+{
+    return bounded_send(channel->sender, message);
+}
+
+void* bounded_recv(BoundedReceiver* receiver)
+{
+    void* message = NULL;
+
+    if (bounded_recv_until(receiver->buffer, &message, 1, NULL, CHANNEL_NO_DEADLINE) != CHANNEL_SUCCESS) {
+        return NULL;
+    }
+
+    return message;
+}
+
+void* bounded_recv_c(BoundedChannel* channel)
+{
+    return bounded_recv(channel->receiver);
+}
+
+int bounded_send_timeout(BoundedSender* sender, void* message, double timeout)
+{
+    return bounded_send_deadline(sender, message, channel_deadline(timeout));
+}
+
+int bounded_send_timeout_c(BoundedChannel* channel, void* message, double timeout)
+{
+    return bounded_send_timeout(channel->sender, message, timeout);
+}
+
+int bounded_send_deadline(BoundedSender* sender, void* message, uint64_t deadline)
+{
+    return bounded_send_until(sender->buffer, &message, 1, NULL, deadline);
+}
+
+int bounded_send_deadline_c(BoundedChannel* channel, void* message, uint64_t deadline)
+{
+    return bounded_send_deadline(channel->sender, message, deadline);
+}
+
+int bounded_recv_timeout(BoundedReceiver* receiver, void** message, double timeout)
+{
+    return bounded_recv_deadline(receiver, message, channel_deadline(timeout));
+}
+
+int bounded_recv_timeout_c(BoundedChannel* channel, void** message, double timeout)
+{
+    return bounded_recv_timeout(channel->receiver, message, timeout);
+}
+
+int bounded_recv_deadline(BoundedReceiver* receiver, void** message, uint64_t deadline)
+{
+    return bounded_recv_until(receiver->buffer, message, 1, NULL, deadline);
+}
+
+int bounded_recv_deadline_c(BoundedChannel* channel, void** message, uint64_t deadline)
+{
+    return bounded_recv_deadline(channel->receiver, message, deadline);
+}
+
+int bounded_try_send(BoundedSender* sender, void* message)
+{
+    int result = bounded_send_until(sender->buffer, &message, 1, NULL, 0);
+
+    return result == CHANNEL_TIMEOUT ? CHANNEL_FULL : result;
+}
+
+int bounded_try_send_c(BoundedChannel* channel, void* message)
+{
+    return bounded_try_send(channel->sender, message);
+}
+
+int bounded_try_recv(BoundedReceiver* receiver, void** message)
+{
+    int result = bounded_recv_until(receiver->buffer, message, 1, NULL, 0);
+
+    return result == CHANNEL_TIMEOUT ? CHANNEL_EMPTY : result;
+}
+
+int bounded_try_recv_c(BoundedChannel* channel, void** message)
+{
+    return bounded_try_recv(channel->receiver, message);
+}
+
+int bounded_send_many(BoundedSender* sender, void** messages, size_t count, size_t* sent)
+{
+    return bounded_send_until(sender->buffer, messages, count, sent, CHANNEL_NO_DEADLINE);
+}
+
+int bounded_send_many_c(BoundedChannel* channel, void** messages, size_t count, size_t* sent)
+{
+    return bounded_send_many(channel->sender, messages, count, sent);
+}
+
+int bounded_send_many_timeout(
+    BoundedSender* sender,
+    void** messages,
+    size_t count,
+    size_t* sent,
+    double timeout)
+{
+    return bounded_send_until(sender->buffer, messages, count, sent, channel_deadline(timeout));
+}
+
+int bounded_send_many_timeout_c(
+    BoundedChannel* channel,
+    void** messages,
+    size_t count,
+    size_t* sent,
+    double timeout)
+{
+    return bounded_send_many_timeout(channel->sender, messages, count, sent, timeout);
+}
+
+int bounded_recv_many(BoundedReceiver* receiver, void** messages, size_t max, size_t* received)
+{
+    return bounded_recv_until(receiver->buffer, messages, max, received, CHANNEL_NO_DEADLINE);
+}
+
+int bounded_recv_many_c(BoundedChannel* channel, void** messages, size_t max, size_t* received)
+{
+    return bounded_recv_many(channel->receiver, messages, max, received);
+}
+
+int bounded_recv_many_timeout(
+    BoundedReceiver* receiver,
+    void** messages,
+    size_t max,
+    size_t* received,
+    double timeout)
+{
+    return bounded_recv_until(receiver->buffer, messages, max, received, channel_deadline(timeout));
+}
+
+int bounded_recv_many_timeout_c(
+    BoundedChannel* channel,
+    void** messages,
+    size_t max,
+    size_t* received,
+    double timeout)
+{
+    return bounded_recv_many_timeout(channel->receiver, messages, max, received, timeout);
+}
+
+// Passes an array of values to be sent to the functions shared with channels
+// of pointers, which take messages as `void**` but only read them when
+// sending.
+static void** bounded_values_to_send(const void* values)
+{
+    return (void**)(uintptr_t)values;
+}
+
+int bounded_send_value(BoundedSender* sender, const void* value)
+{
+    return bounded_send_value_deadline(sender, value, CHANNEL_NO_DEADLINE);
+}
+
+int bounded_send_value_c(BoundedChannel* channel, const void* value)
+{
+    return bounded_send_value(channel->sender, value);
+}
+
+int bounded_recv_value(BoundedReceiver* receiver, void* value)
+{
+    return bounded_recv_value_deadline(receiver, value, CHANNEL_NO_DEADLINE);
+}
+
+int bounded_recv_value_c(BoundedChannel* channel, void* value)
+{
+    return bounded_recv_value(channel->receiver, value);
+}
+
+int bounded_send_value_timeout(BoundedSender* sender, const void* value, double timeout)
+{
+    return bounded_send_value_deadline(sender, value, channel_deadline(timeout));
+}
+
+int bounded_send_value_timeout_c(BoundedChannel* channel, const void* value, double timeout)
+{
+    return bounded_send_value_timeout(channel->sender, value, timeout);
+}
+
+int bounded_recv_value_timeout(BoundedReceiver* receiver, void* value, double timeout)
+{
+    return bounded_recv_value_deadline(receiver, value, channel_deadline(timeout));
+}
+
+int bounded_recv_value_timeout_c(BoundedChannel* channel, void* value, double timeout)
+{
+    return bounded_recv_value_timeout(channel->receiver, value, timeout);
+}
+
+int bounded_send_value_deadline(BoundedSender* sender, const void* value, uint64_t deadline)
+{
+    return bounded_send_until(sender->buffer, bounded_values_to_send(value), 1, NULL, deadline);
+}
+
+int bounded_send_value_deadline_c(BoundedChannel* channel, const void* value, uint64_t deadline)
+{
+    return bounded_send_value_deadline(channel->sender, value, deadline);
+}
+
+int bounded_recv_value_deadline(BoundedReceiver* receiver, void* value, uint64_t deadline)
+{
+    return bounded_recv_until(receiver->buffer, value, 1, NULL, deadline);
+}
+
+int bounded_recv_value_deadline_c(BoundedChannel* channel, void* value, uint64_t deadline)
+{
+    return bounded_recv_value_deadline(channel->receiver, value, deadline);
+}
+
+int bounded_try_send_value(BoundedSender* sender, const void* value)
+{
+    int result = bounded_send_value_deadline(sender, value, 0);
+
+    return result == CHANNEL_TIMEOUT ? CHANNEL_FULL : result;
+}
+
+int bounded_try_send_value_c(BoundedChannel* channel, const void* value)
+{
+    return bounded_try_send_value(channel->sender, value);
+}
+
+int bounded_try_recv_value(BoundedReceiver* receiver, void* value)
+{
+    int result = bounded_recv_value_deadline(receiver, value, 0);
+
+    return result == CHANNEL_TIMEOUT ? CHANNEL_EMPTY : result;
+}
+
+int bounded_try_recv_value_c(BoundedChannel* channel, void* value)
+{
+    return bounded_try_recv_value(channel->receiver, value);
+}
+
+int bounded_send_values(BoundedSender* sender, const void* values, size_t count, size_t* sent)
+{
+    return bounded_send_until(sender->buffer, bounded_values_to_send(values), count, sent, CHANNEL_NO_DEADLINE);
+}
+
+int bounded_send_values_c(BoundedChannel* channel, const void* values, size_t count, size_t* sent)
+{
+    return bounded_send_values(channel->sender, values, count, sent);
+}
+
+int bounded_recv_values(BoundedReceiver* receiver, void* values, size_t max, size_t* received)
+{
+    return bounded_recv_until(receiver->buffer, values, max, received, CHANNEL_NO_DEADLINE);
+}
+
+int bounded_recv_values_c(BoundedChannel* channel, void* values, size_t max, size_t* received)
+{
+    return bounded_recv_values(channel->receiver, values, max, received);
+}
+
+void free_bounded_channel(BoundedChannel* channel)
+{
+    free_bounded_buffer(channel->sender->buffer);
+    free(channel->sender);
+    free(channel->receiver);
+    free(channel);
+}
+
+void free_bounded_channel_wrapper(BoundedChannel* channel)
+{
+    free(channel);
+}
+
+BoundedSender* clone_bounded_sender(BoundedSender* sender)
+{
+    if (sender->buffer->single_producer) {
+        return NULL;
+    }
+
+    atomic_fetch_add(&sender->buffer->state, CHANNEL_STATE_SENDER);
+
+    BoundedSender* clone = NEW(BoundedSender);
+    clone->buffer = sender->buffer;
+
+    return clone;
+}
+
+// Closes a bounded channel for sending and wakes every thread blocked in it.
+static void bounded_close_sending(BoundedChannelBuffer* buffer)
+{
+    if (buffer->lockfree) {
+        atomic_fetch_or(&buffer->tail, CHANNEL_TAIL_CLOSED);
+    }
+
+    channel_close_locked(&buffer->state, &buffer->mutex, CHANNEL_STATE_SEND_CLOSED);
+    wait_queue_notify_all(&buffer->recv_waiters);
+    wait_queue_notify_all(&buffer->send_waiters);
+}
+
+void free_bounded_sender(BoundedSender* sender)
+{
+    BoundedChannelBuffer* buffer = sender->buffer;
+
+    if (channel_drop_handle(&buffer->state, CHANNEL_STATE_SENDER)) {
+        bounded_close_sending(buffer);
+
+        if (channel_release_handle(&buffer->state, CHANNEL_STATE_SENDER)) {
+            free_bounded_buffer(buffer);
+        }
+    }
+
+    free(sender);
+}
+
+void bounded_close(BoundedSender* sender)
+{
+    bounded_close_sending(sender->buffer);
+}
+
+void bounded_close_c(BoundedChannel* channel)
+{
+    bounded_close(channel->sender);
+}
+
+BoundedReceiver* clone_bounded_receiver(BoundedReceiver* receiver)
+{
+    BoundedChannelBuffer* buffer = receiver->buffer;
+
+    if (!buffer->multi_consumer) {
+        return NULL;
+    }
+
+    atomic_fetch_add(&buffer->state, CHANNEL_STATE_RECEIVER);
+
+    BoundedReceiver* clone = NEW(BoundedReceiver);
+    clone->buffer = buffer;
+
+    return clone;
+}
+
+void free_bounded_receiver(BoundedReceiver* receiver)
+{
+    BoundedChannelBuffer* buffer = receiver->buffer;
+
+    if (channel_drop_handle(&buffer->state, CHANNEL_STATE_RECEIVER)) {
+        channel_close_locked(&buffer->state, &buffer->mutex, CHANNEL_STATE_RECV_CLOSED);
+        wait_queue_notify_all(&buffer->send_waiters);
+
+        if (channel_release_handle(&buffer->state, CHANNEL_STATE_RECEIVER)) {
+            free_bounded_buffer(buffer);
+        }
+    }
+
+    free(receiver);
+}
+
+// Frees a chain of message nodes of an unbounded channel.
+static void free_unbounded_nodes(UnboundedChannelBuffer* buffer, UnboundedMessage* first)
+{
+    while (first != NULL) {
+        UnboundedMessage* next = first->next;
+        channel_deallocate(&buffer->allocator, first, sizeof(UnboundedMessage));
+        first = next;
+    }
+}
+
+// Initializes the empty node cache of a new half of an unbounded channel.
+static void unbounded_cache_init(UnboundedNodeCache* cache)
+{
+    atomic_flag_clear(&cache->busy);
+    cache->count = 0;
+    cache->first = NULL;
+}
+
+// Claims the node cache of a half for the calling thread. If `false` is
+// returned, another thread sharing the half is using it.
+static bool unbounded_cache_acquire(UnboundedNodeCache* cache)
+{
+    return !atomic_flag_test_and_set_explicit(&cache->busy, memory_order_acquire);
+}
+
+// Gives up a node cache claimed with `unbounded_cache_acquire`.
+static void unbounded_cache_release(UnboundedNodeCache* cache)
+{
+    atomic_flag_clear_explicit(&cache->busy, memory_order_release);
+}
+
+// Frees the nodes in the cache of a half that is being freed.
+static void unbounded_cache_destroy(UnboundedChannelBuffer* buffer, UnboundedNodeCache* cache)
+{
+    free_unbounded_nodes(buffer, cache->first);
+    cache->first = NULL;
+    cache->count = 0;
+}
+
+// Frees the internal buffer of an unbounded channel, along with any messages
+// that were never received.
+static void free_unbounded_buffer(UnboundedChannelBuffer* buffer)
+{
+    ChannelAllocator allocator = buffer->allocator;
+
+    if (buffer->lockfree) {
+        while (buffer->head_block != NULL) {
+            UnboundedBlock* block = buffer->head_block;
+            buffer->head_block = atomic_load(&block->next);
+            channel_deallocate(&allocator, block, sizeof(UnboundedBlock));
+        }
+
+        for (size_t i = 0; i < UNBOUNDED_SPARE_BLOCKS; i++) {
+            channel_deallocate(&allocator, atomic_load(&buffer->spare_blocks[i]), sizeof(UnboundedBlock));
+        }
+    }
+    else {
+        free_unbounded_nodes(buffer, buffer->first_message);
+
+        for (size_t i = 0; i < UNBOUNDED_SPARE_NODE_BATCHES; i++) {
+            free_unbounded_nodes(buffer, atomic_load(&buffer->spare_nodes[i]));
+        }
+    }
+
+    channel_deallocate(&allocator, buffer->latency, sizeof(ChannelLatencyHistogram));
+    channel_event_close(&buffer->event_fd);
+    wait_queue_destroy(&buffer->recv_waiters);
+    mutex_destroy(&buffer->mutex);
+    channel_deallocate(&allocator, buffer, sizeof(UnboundedChannelBuffer));
+}
+
+// Allocates an empty block for a lock-free unbounded channel.
+static UnboundedBlock* new_unbounded_block(UnboundedChannelBuffer* buffer)
+{
+    UnboundedBlock* block = (UnboundedBlock*)channel_allocate(
+        &buffer->allocator, sizeof(UnboundedBlock), _Alignof(UnboundedBlock));
+    atomic_init(&block->next, NULL);
+
+    for (size_t i = 0; i < UNBOUNDED_BLOCK_CAPACITY; i++) {
+        block->slots[i].message = NULL;
+        atomic_init(&block->slots[i].ready, false);
+    }
+
+    return block;
+}
+
+// Takes a retired block for reuse if one is available, or allocates a new one.
+static UnboundedBlock* acquire_unbounded_block(UnboundedChannelBuffer* buffer)
+{
+    for (size_t i = 0; i < UNBOUNDED_SPARE_BLOCKS; i++) {
+        UnboundedBlock* block = atomic_exchange(&buffer->spare_blocks[i], NULL);
+
+        if (block != NULL) {
+            atomic_store_explicit(&block->next, NULL, memory_order_relaxed);
+            return block;
+        }
+    }
+
+    return new_unbounded_block(buffer);
+}
+
+// Keeps an unused block for reuse, or frees it if enough blocks are kept
+// already. Every slot of the block must be marked as not ready.
+static void release_unbounded_block(UnboundedChannelBuffer* buffer, UnboundedBlock* block)
+{
+    for (size_t i = 0; i < UNBOUNDED_SPARE_BLOCKS; i++) {
+        UnboundedBlock* empty = NULL;
+
+        if (atomic_compare_exchange_strong(&buffer->spare_blocks[i], &empty, block)) {
+            return;
+        }
+    }
+
+    channel_deallocate(&buffer->allocator, block, sizeof(UnboundedBlock));
+}
+
+// Takes a free node for a message: from the cache of the sender if the
+// calling thread holds it, refilling the cache with a batch passed on by the
+// receiver when it runs dry, and from the allocator otherwise.
+static UnboundedMessage* unbounded_take_node(
+    UnboundedChannelBuffer* buffer,
+    UnboundedNodeCache* cache,
+    bool cached)
+{
+    if (cached) {
+        // The spare batches are only touched once per batch, and only read
+        // while they are empty, so senders and the receiver rarely share
+        // their cache line.
+        for (size_t i = 0; i < UNBOUNDED_SPARE_NODE_BATCHES && cache->first == NULL; i++) {
+            if (atomic_load_explicit(&buffer->spare_nodes[i], memory_order_relaxed) != NULL) {
+                cache->first = atomic_exchange_explicit(&buffer->spare_nodes[i], NULL, memory_order_acquire);
+            }
+        }
+
+        UnboundedMessage* node = cache->first;
+
+        if (node != NULL) {
+            cache->first = node->next;
+            return node;
+        }
+    }
+
+    return (UnboundedMessage*)channel_allocate(
+        &buffer->allocator, sizeof(UnboundedMessage), _Alignof(UnboundedMessage));
+}
+
+// Recycles the node of a received message. The node joins the cache of the
+// receiver if the calling thread holds it, and every full batch is passed on
+// to the senders, or freed if enough batches are waiting for them already.
+static void unbounded_give_node(
+    UnboundedChannelBuffer* buffer,
+    UnboundedNodeCache* cache,
+    bool cached,
+    UnboundedMessage* node)
+{
+    if (!cached) {
+        channel_deallocate(&buffer->allocator, node, sizeof(UnboundedMessage));
+        return;
+    }
+
+    node->next = cache->first;
+    cache->first = node;
+
+    if (++cache->count < UNBOUNDED_NODE_BATCH) {
+        return;
+    }
+
+    UnboundedMessage* batch = cache->first;
+    cache->first = NULL;
+    cache->count = 0;
+
+    for (size_t i = 0; i < UNBOUNDED_SPARE_NODE_BATCHES; i++) {
+        UnboundedMessage* empty = NULL;
+
+        if (atomic_compare_exchange_strong_explicit(
+                &buffer->spare_nodes[i], &empty, batch,
+                memory_order_release, memory_order_relaxed)) {
+            return;
+        }
+    }
+
+    free_unbounded_nodes(buffer, batch);
+}
+
+UnboundedChannel* unbounded_channel_with(const ChannelOptions* options)
+{
+    options = channel_options(options);
+    bool single_producer = options->single_producer;
+    bool lockfree = options->lockfree || single_producer;
+    bool multi_consumer = options->multi_consumer;
+
+    // The lock-free blocks only support a single receiver.
+    if (lockfree && multi_consumer) {
+        return NULL;
+    }
+
+    ChannelAllocator allocator = channel_allocator(options);
+    UnboundedChannelBuffer* buffer = (UnboundedChannelBuffer*)channel_allocate(
+        &allocator, sizeof(UnboundedChannelBuffer), _Alignof(UnboundedChannelBuffer));
+    buffer->allocator = allocator;
+    buffer->size = 0;
+    buffer->first_message = NULL;
+    buffer->last_message = NULL;
+    buffer->lockfree = lockfree;
+    buffer->multi_consumer = multi_consumer;
+    buffer->single_producer = single_producer;
+    buffer->latency = new_latency_histogram(&allocator, options->trace_latency);
+    atomic_init(&buffer->event_fd, -1);
+    buffer->head = 0;
+    buffer->head_block = lockfree ? new_unbounded_block(buffer) : NULL;
+    channel_wait_init(&buffer->recv_wait, options->wait_policy);
+    atomic_init(&buffer->tail, 0);
+    atomic_init(&buffer->tail_block, buffer->head_block);
+
+    for (size_t i = 0; i < UNBOUNDED_SPARE_BLOCKS; i++) {
+        atomic_init(&buffer->spare_blocks[i], NULL);
+    }
+
+    for (size_t i = 0; i < UNBOUNDED_SPARE_NODE_BATCHES; i++) {
+        atomic_init(&buffer->spare_nodes[i], NULL);
+    }
+
+    atomic_init(&buffer->state, CHANNEL_STATE_SENDER + CHANNEL_STATE_RECEIVER);
+    mutex_init(&buffer->mutex, options->lock);
+    wait_queue_init(&buffer->recv_waiters);
+    channel_counters_init(&buffer->send_counters);
+    channel_counters_init(&buffer->recv_counters);
+
+    UnboundedSender* sender = NEW(UnboundedSender);
+    sender->buffer = buffer;
+    unbounded_cache_init(&sender->nodes);
+
+    UnboundedReceiver* receiver = NEW(UnboundedReceiver);
+    receiver->buffer = buffer;
+    unbounded_cache_init(&receiver->nodes);
+
+    UnboundedChannel* channel = NEW(UnboundedChannel);
+    channel->sender = sender;
+    channel->receiver = receiver;
+
+    return channel;
+}
+
+UnboundedChannel* unbounded_channel(void)
+{
+    return unbounded_channel_with(NULL);
+}
+
+UnboundedChannel* unbounded_channel_lockfree(void)
+{
+    ChannelOptions options = { CHANNEL_LOCK_DEFAULT, true, false };
+
+    return unbounded_channel_with(&options);
+}
+
+UnboundedChannel* unbounded_channel_mpmc(void)
+{
+    ChannelOptions options = { CHANNEL_LOCK_DEFAULT, false, true };
+
+    return unbounded_channel_with(&options);
+}
+
+UnboundedChannel* spsc_unbounded_channel(void)
+{
+    ChannelOptions options = { CHANNEL_LOCK_DEFAULT, true, false, true };
+
+    return unbounded_channel_with(&options);
+}
+
+// Pushes messages into the blocks of a lock-free unbounded channel. A sender
+// claims a run of positions within the current block by advancing the tail.
+// The sender that claims the last slot of a block installs the next block
+// before filling its slots, and the other senders wait for the installation
+// to finish.
+static int unbounded_lockfree_push(
+    UnboundedChannelBuffer* buffer,
+    void** messages,
+    size_t count,
+    size_t* sent)
+{
+    if (channel_closed(&buffer->state, CHANNEL_STATE_CLOSED)) {
+        return CHANNEL_CLOSED;
+    }
+
+    UnboundedBlock* next_block = NULL;
+    int result = CHANNEL_SUCCESS;
+
+    while (*sent < count) {
+        size_t tail = atomic_load_explicit(&buffer->tail, memory_order_acquire);
+
+        // A marked tail can still be advanced by the sender installing the
+        // next block, but no longer claimed.
+        if (tail & CHANNEL_TAIL_CLOSED) {
+            result = CHANNEL_CLOSED;
+            break;
+        }
+
+        UnboundedBlock* block = atomic_load_explicit(&buffer->tail_block, memory_order_acquire);
+        size_t offset = tail % UNBOUNDED_BLOCK_LAP;
+
+        if (offset == UNBOUNDED_BLOCK_CAPACITY) {
+            channel_yield();
+            continue;
+        }
+
+        size_t batch = CHANNEL_MIN(count - *sent, UNBOUNDED_BLOCK_CAPACITY - offset);
+        bool fills_block = offset + batch == UNBOUNDED_BLOCK_CAPACITY;
+
+        if (fills_block && next_block == NULL) {
+            next_block = acquire_unbounded_block(buffer);
+        }
+
+        if (!atomic_compare_exchange_weak_explicit(
+                &buffer->tail, &tail, tail + batch,
+                memory_order_seq_cst, memory_order_relaxed)) {
+            continue;
+        }
+
+        if (fills_block) {
+            atomic_store_explicit(&block->next, next_block, memory_order_release);
+            atomic_store_explicit(&buffer->tail_block, next_block, memory_order_release);
+            atomic_fetch_add_explicit(&buffer->tail, 1, memory_order_release);
+            next_block = NULL;
+        }
+
+        uint64_t now = latency_now(buffer->latency);
+
+        for (size_t i = 0; i < batch; i++) {
+            UnboundedSlot* slot = &block->slots[offset + i];
+            slot->message = messages[*sent + i];
+            slot->sent_at = now;
+            atomic_store_explicit(&slot->ready, true, memory_order_release);
+        }
+
+        *sent += batch;
+    }
+
+    if (next_block != NULL) {
+        release_unbounded_block(buffer, next_block);
+    }
+
+    wait_queue_notify_one(&buffer->recv_waiters);
+
+    return result;
+}
+
+// Pushes messages into the blocks of a single-producer unbounded channel.
+// With no other sender to race against, slots are filled and the tail is
+// advanced with plain stores, and the next block is installed as soon as the
+// last slot of a block is reached.
+static int unbounded_spsc_push(
+    UnboundedChannelBuffer* buffer,
+    void** messages,
+    size_t count,
+    size_t* sent)
+{
+    if (channel_closed(&buffer->state, CHANNEL_STATE_CLOSED)) {
+        return CHANNEL_CLOSED;
+    }
+
+    size_t tail = atomic_load_explicit(&buffer->tail, memory_order_relaxed);
+    UnboundedBlock* block = atomic_load_explicit(&buffer->tail_block, memory_order_relaxed);
+    uint64_t now = latency_now(buffer->latency);
+
+    for (size_t i = 0; i < count; i++) {
+        size_t offset = tail % UNBOUNDED_BLOCK_LAP;
+        UnboundedSlot* slot = &block->slots[offset];
+        slot->message = messages[i];
+        slot->sent_at = now;
+
+        if (offset + 1 == UNBOUNDED_BLOCK_CAPACITY) {
+            // The receiver follows the link after reading the last slot, so
+            // it has to be in place before that slot is marked as ready.
+            UnboundedBlock* next_block = acquire_unbounded_block(buffer);
+            atomic_store_explicit(&block->next, next_block, memory_order_release);
+            atomic_store_explicit(&slot->ready, true, memory_order_release);
+            block = next_block;
+            tail += 2;
+        }
+        else {
+            atomic_store_explicit(&slot->ready, true, memory_order_release);
+            tail++;
+        }
+    }
+
+    atomic_store_explicit(&buffer->tail_block, block, memory_order_relaxed);
+    atomic_store_explicit(&buffer->tail, tail, memory_order_relaxed);
+
+    *sent = count;
+    wait_queue_notify_one(&buffer->recv_waiters);
+
+    return CHANNEL_SUCCESS;
+}
+
+// Attempts to pop messages from the blocks of a lock-free unbounded channel.
+// Once the last slot of a block has been read, the block is retired.
+static int unbounded_lockfree_pop(BatchOperation* operation)
+{
+    UnboundedChannelBuffer* buffer = (UnboundedChannelBuffer*)operation->buffer;
+    size_t wanted = operation->count - operation->done;
+    size_t count = 0;
+    uint64_t now = latency_now(buffer->latency);
+
+    for (;;) {
+        while (count < wanted) {
+            UnboundedBlock* block = buffer->head_block;
+            size_t offset = buffer->head % UNBOUNDED_BLOCK_LAP;
+            UnboundedSlot* slot = &block->slots[offset];
+
+            if (!atomic_load_explicit(&slot->ready, memory_order_acquire)) {
+                break;
+            }
+
+            operation->messages[operation->done + count] = slot->message;
+
+            if (buffer->latency != NULL) {
+                latency_record(buffer->latency, slot->sent_at, now);
+            }
+
+            atomic_store_explicit(&slot->ready, false, memory_order_relaxed);
+            count++;
+
+            if (offset + 1 == UNBOUNDED_BLOCK_CAPACITY) {
+                buffer->head_block = atomic_load_explicit(&block->next, memory_order_acquire);
+                buffer->head += 2;
+                release_unbounded_block(buffer, block);
+            }
+            else {
+                buffer->head++;
+            }
+        }
+
+        if (count > 0) {
+            break;
+        }
+
+        size_t tail = atomic_load_explicit(&buffer->tail, memory_order_acquire);
+
+        if (!(tail & CHANNEL_TAIL_CLOSED)) {
+            return CHANNEL_WOULD_BLOCK;
+        }
+
+        if ((tail & ~CHANNEL_TAIL_CLOSED) == buffer->head) {
+            return CHANNEL_CLOSED;
+        }
+
+        // Slots claimed before the channel was closed are still being filled,
+        // and their senders are only ever a few stores away from finishing.
+        channel_yield();
+    }
+
+    operation->done += count;
+
+    return CHANNEL_SUCCESS;
+}
+
+// Sends messages through the mutex-protected message list of an unbounded
+// channel. The nodes are taken before the lock is and the whole batch is
+// linked in at once.
+static int unbounded_locked_send(
+    UnboundedSender* sender,
+    void** messages,
+    size_t count,
+    size_t* sent)
+{
+    UnboundedChannelBuffer* buffer = sender->buffer;
+    UnboundedMessage* first = NULL;
+    UnboundedMessage* last = NULL;
+    bool cached = unbounded_cache_acquire(&sender->nodes);
+    uint64_t now = latency_now(buffer->latency);
+
+    for (size_t i = 0; i < count; i++) {
+        UnboundedMessage* this_message = unbounded_take_node(buffer, &sender->nodes, cached);
+        this_message->message = messages[i];
+        this_message->next = NULL;
+        this_message->sent_at = now;
+
+        if (last != NULL) {
+            last->next = this_message;
+        }
+        else {
+            first = this_message;
+        }
+
+        last = this_message;
+    }
+
+    if (cached) {
+        unbounded_cache_release(&sender->nodes);
+    }
+
+    if (channel_lock(&buffer->mutex, &buffer->send_counters) != CHANNEL_MUTEX_SUCCESS) {
+        return CHANNEL_MUTEX_ERROR;
+    }
+
+    bool open = !channel_closed(&buffer->state, CHANNEL_STATE_CLOSED);
+
+    if (open) {
+        if (buffer->last_message != NULL) {
+            buffer->last_message->next = first;
+        }
+        else {
+            buffer->first_message = first;
+        }
+
+        buffer->last_message = last;
+        buffer->size += count;
+    }
+
+    if (mutex_release(&buffer->mutex) != CHANNEL_MUTEX_SUCCESS) {
+        return CHANNEL_MUTEX_ERROR;
+    }
+
+    if (!open) {
+        free_unbounded_nodes(buffer, first);
+
+        return CHANNEL_CLOSED;
+    }
+
+    *sent = count;
+    wait_queue_notify_many(&buffer->recv_waiters, count);
+
+    return CHANNEL_SUCCESS;
+}
+
+// Returns whether a receiver waiting on the mutex-protected message list of an
+// unbounded channel can go on.
+static bool unbounded_locked_recv_ready(void* buffer_vp)
+{
+    UnboundedChannelBuffer* buffer = (UnboundedChannelBuffer*)buffer_vp;
+
+    return buffer->size != 0 || channel_closed(&buffer->state, CHANNEL_STATE_SEND_CLOSED);
+}
+
+// Receives messages from the mutex-protected message list of an unbounded
+// channel. The nodes are unlinked under the lock and recycled after it is
+// released.
+static int unbounded_locked_recv(
+    UnboundedReceiver* receiver,
+    void** messages,
+    size_t max,
+    size_t* received,
+    uint64_t deadline)
+{
+    UnboundedChannelBuffer* buffer = receiver->buffer;
+
+    if (channel_lock(&buffer->mutex, &buffer->recv_counters) != CHANNEL_MUTEX_SUCCESS) {
+        return CHANNEL_MUTEX_ERROR;
+    }
+
+    int wait_result = CHANNEL_MUTEX_SUCCESS;
+
+    while (buffer->size == 0 && !channel_closed(&buffer->state, CHANNEL_STATE_SEND_CLOSED)
+           && wait_result == CHANNEL_MUTEX_SUCCESS) {
+        wait_result = channel_wait_locked(
+            &buffer->recv_waiters,
+            &buffer->mutex,
+            &buffer->recv_wait,
+            unbounded_locked_recv_ready,
+            buffer,
+            deadline,
+            &buffer->recv_counters);
+    }
+
+    if (wait_result == CHANNEL_MUTEX_FAILURE) {
+        return CHANNEL_MUTEX_ERROR;
+    }
+
+    if (buffer->size == 0) {
+        int result = channel_closed(&buffer->state, CHANNEL_STATE_SEND_CLOSED) ? CHANNEL_CLOSED : CHANNEL_TIMEOUT;
+
+        if (mutex_release(&buffer->mutex) != CHANNEL_MUTEX_SUCCESS) {
+            return CHANNEL_MUTEX_ERROR;
+        }
+
+        return result;
+    }
+
+    size_t count = CHANNEL_MIN(max, buffer->size);
+    UnboundedMessage* first = buffer->first_message;
+    UnboundedMessage* last = first;
+
+    for (size_t i = 1; i < count; i++) {
+        last = last->next;
+    }
+
+    buffer->first_message = last->next;
+    buffer->size -= count;
+
+    if (buffer->first_message == NULL) {
+        buffer->last_message = NULL;
+    }
+
+    if (mutex_release(&buffer->mutex) != CHANNEL_MUTEX_SUCCESS) {
+        return CHANNEL_MUTEX_ERROR;
+    }
+
+    bool cached = unbounded_cache_acquire(&receiver->nodes);
+    uint64_t now = latency_now(buffer->latency);
+
+    for (size_t i = 0; i < count; i++) {
+        UnboundedMessage* next = first->next;
+        messages[i] = first->message;
+
+        if (buffer->latency != NULL) {
+            latency_record(buffer->latency, first->sent_at, now);
+        }
+
+        unbounded_give_node(buffer, &receiver->nodes, cached, first);
+        first = next;
+    }
+
+    if (cached) {
+        unbounded_cache_release(&receiver->nodes);
+    }
+
+    *received = count;
+
+    return CHANNEL_SUCCESS;
+}
+
+// Sends messages through an unbounded channel. This never blocks.
+static int unbounded_send_all(
+    UnboundedSender* sender,
+    void** messages,
+    size_t count,
+    size_t* sent)
+{
+    UnboundedChannelBuffer* buffer = sender->buffer;
+    size_t done = 0;
+    int result = CHANNEL_SUCCESS;
+
+    if (count == 0) {
+        // Nothing to send.
+    }
+    else if (buffer->single_producer) {
+        result = unbounded_spsc_push(buffer, messages, count, &done);
+    }
+    else if (buffer->lockfree) {
+        result = unbounded_lockfree_push(buffer, messages, count, &done);
+    }
+    else {
+        result = unbounded_locked_send(sender, messages, count, &done);
+    }
+
+    channel_count_sent(&buffer->send_counters, &buffer->recv_counters, done);
+
+    if (sent != NULL) {
+        *sent = done;
+    }
+
+    return result;
+}
+
+// Receives up to `max` messages from an unbounded channel, blocking until at
+// least one is available, the sender is destroyed or the deadline passes.
+static int unbounded_recv_until(
+    UnboundedReceiver* receiver,
+    void** messages,
+    size_t max,
+    size_t* received,
+    uint64_t deadline)
+{
+    UnboundedChannelBuffer* buffer = receiver->buffer;
+    size_t done = 0;
+    int result = CHANNEL_SUCCESS;
+
+    if (max == 0) {
+        // Nothing to receive.
+    }
+    else if (buffer->lockfree) {
+        BatchOperation operation = { buffer, messages, max, 0 };
+        result = park_until_complete(
+            &buffer->recv_waiters,
+            &buffer->recv_wait,
+            unbounded_lockfree_pop,
+            &operation,
+            deadline,
+            &buffer->recv_counters);
+        done = operation.done;
+    }
+    else {
+        result = unbounded_locked_recv(receiver, messages, max, &done, deadline);
+    }
+
+    channel_count(&buffer->recv_counters.messages, done);
+
+    if (received != NULL) {
+        *received = done;
+    }
+
+    if (result == CHANNEL_TIMEOUT && channel_event_rearm(&buffer->recv_waiters, &buffer->event_fd)) {
+        return unbounded_recv_until(receiver, messages, max, received, 0);
+    }
+
+    return result;
+}
+
+int unbounded_send(UnboundedSender* sender, void* message)
+{
+    return unbounded_send_all(sender, &message, 1, NULL);
+}
+
+int unbounded_send_c(UnboundedChannel* channel, void* message)
+{
+    return unbounded_send(channel->sender, message);
+}
+
+void* unbounded_recv(UnboundedReceiver* receiver)
+{
+    void* message = NULL;
+
+    if (unbounded_recv_until(receiver, &message, 1, NULL, CHANNEL_NO_DEADLINE) != CHANNEL_SUCCESS) {
+        return NULL;
+    }
+
+    return message;
+}
+
+void* unbounded_recv_c(UnboundedChannel* channel)
+{
+    return unbounded_recv(channel->receiver);
+}
+
+int unbounded_recv_timeout(UnboundedReceiver* receiver, void** message, double timeout)
+{
+    return unbounded_recv_deadline(receiver, message, channel_deadline(timeout));
+}
+
+int unbounded_recv_timeout_c(UnboundedChannel* channel, void** message, double timeout)
+{
+    return unbounded_recv_timeout(channel->receiver, message, timeout);
+}
+
+int unbounded_recv_deadline(UnboundedReceiver* receiver, void** message, uint64_t deadline)
+{
+    return unbounded_recv_until(receiver, message, 1, NULL, deadline);
+}
+
+int unbounded_recv_deadline_c(UnboundedChannel* channel, void** message, uint64_t deadline)
+{
+    return unbounded_recv_deadline(channel->receiver, message, deadline);
+}
+
+int unbounded_try_send(UnboundedSender* sender, void* message)
+{
+    return unbounded_send(sender, message);
+}
+
+int unbounded_try_send_c(UnboundedChannel* channel, void* message)
+{
+    return unbounded_try_send(channel->sender, message);
+}
+
+int unbounded_try_recv(UnboundedReceiver* receiver, void** message)
+{
+    int result = unbounded_recv_until(receiver, message, 1, NULL, 0);
+
+    return result == CHANNEL_TIMEOUT ? CHANNEL_EMPTY : result;
+}
+
+int unbounded_try_recv_c(UnboundedChannel* channel, void** message)
+{
+    return unbounded_try_recv(channel->receiver, message);
+}
+
+int unbounded_send_many(UnboundedSender* sender, void** messages, size_t count, size_t* sent)
+{
+    return unbounded_send_all(sender, messages, count, sent);
+}
+
+int unbounded_send_many_c(UnboundedChannel* channel, void** messages, size_t count, size_t* sent)
+{
+    return unbounded_send_many(channel->sender, messages, count, sent);
+}
+
+int unbounded_recv_many(UnboundedReceiver* receiver, void** messages, size_t max, size_t* received)
+{
+    return unbounded_recv_until(receiver, messages, max, received, CHANNEL_NO_DEADLINE);
+}
+
+int unbounded_recv_many_c(UnboundedChannel* channel, void** messages, size_t max, size_t* received)
+{
+    return unbounded_recv_many(channel->receiver, messages, max, received);
+}
+
+int unbounded_recv_many_timeout(
+    UnboundedReceiver* receiver,
+    void** messages,
+    size_t max,
+    size_t* received,
+    double timeout)
+{
+    return unbounded_recv_until(receiver, messages, max, received, channel_deadline(timeout));
+}
+
+int unbounded_recv_many_timeout_c(
+    UnboundedChannel* channel,
+    void** messages,
+    size_t max,
+    size_t* received,
+    double timeout)
+{
+    return unbounded_recv_many_timeout(channel->receiver, messages, max, received, timeout);
+}
+
+void free_unbounded_channel(UnboundedChannel* channel)
+{
+    UnboundedChannelBuffer* buffer = channel->sender->buffer;
+    unbounded_cache_destroy(buffer, &channel->sender->nodes);
+    unbounded_cache_destroy(buffer, &channel->receiver->nodes);
+    free_unbounded_buffer(buffer);
+    free(channel->sender);
+    free(channel->receiver);
+    free(channel);
+}
+
+void free_unbounded_channel_wrapper(UnboundedChannel* channel)
+{
+    free(channel);
+}
+
+UnboundedSender* clone_unbounded_sender(UnboundedSender* sender)
+{
+    if (sender->buffer->single_producer) {
+        return NULL;
+    }
+
+    atomic_fetch_add(&sender->buffer->state, CHANNEL_STATE_SENDER);
+
+    UnboundedSender* clone = NEW(UnboundedSender);
+    clone->buffer = sender->buffer;
+    unbounded_cache_init(&clone->nodes);
+
+    return clone;
+}
+
+// Closes an unbounded channel for sending and wakes every receiver blocked in
+// it.
+static void unbounded_close_sending(UnboundedChannelBuffer* buffer)
+{
+    if (buffer->lockfree) {
+        atomic_fetch_or(&buffer->tail, CHANNEL_TAIL_CLOSED);
+    }
+
+    channel_close_locked(&buffer->state, &buffer->mutex, CHANNEL_STATE_SEND_CLOSED);
+    wait_queue_notify_all(&buffer->recv_waiters);
+}
+
+void free_unbounded_sender(UnboundedSender* sender)
+{
+    UnboundedChannelBuffer* buffer = sender->buffer;
+    unbounded_cache_destroy(buffer, &sender->nodes);
+
+    if (channel_drop_handle(&buffer->state, CHANNEL_STATE_SENDER)) {
+        unbounded_close_sending(buffer);
+
+        if (channel_release_handle(&buffer->state, CHANNEL_STATE_SENDER)) {
+            free_unbounded_buffer(buffer);
+        }
+    }
+
+    free(sender);
+}
+
+void unbounded_close(UnboundedSender* sender)
+{
+    unbounded_close_sending(sender->buffer);
+}
+
+void unbounded_close_c(UnboundedChannel* channel)
+{
+    unbounded_close(channel->sender);
+}
+
+UnboundedReceiver* clone_unbounded_receiver(UnboundedReceiver* receiver)
+{
+    UnboundedChannelBuffer* buffer = receiver->buffer;
+
+    if (!buffer->multi_consumer) {
+        return NULL;
+    }
+
+    atomic_fetch_add(&buffer->state, CHANNEL_STATE_RECEIVER);
+
+    UnboundedReceiver* clone = NEW(UnboundedReceiver);
+    clone->buffer = buffer;
+    unbounded_cache_init(&clone->nodes);
+
+    return clone;
+}
+
+void free_unbounded_receiver(UnboundedReceiver* receiver)
+{
+    UnboundedChannelBuffer* buffer = receiver->buffer;
+    unbounded_cache_destroy(buffer, &receiver->nodes);
+
+    if (channel_drop_handle(&buffer->state, CHANNEL_STATE_RECEIVER)) {
+        channel_close_locked(&buffer->state, &buffer->mutex, CHANNEL_STATE_RECV_CLOSED);
+
+        if (channel_release_handle(&buffer->state, CHANNEL_STATE_RECEIVER)) {
+            free_unbounded_buffer(buffer);
+        }
+    }
+
+    free(receiver);
+}
+
+// The length in the header of the padding a byte channel sender leaves at the
+// end of the ring when a record does not fit there.
+#define BYTE_PADDING UINT64_MAX
+
+// Returns the room a record of `size` bytes takes in the ring of a byte
+// channel, header included.
+static size_t byte_record_size(size_t size)
+{
+    return (BYTE_RECORD_ALIGN + size + BYTE_RECORD_ALIGN - 1) & ~(size_t)(BYTE_RECORD_ALIGN - 1);
+}
+
+// Writes the header of a record, or of padding, at an index of the ring of a
+// byte channel.
+static void byte_write_header(ByteChannelBuffer* buffer, size_t index, uint64_t length)
+{
+    memcpy(&buffer->bytes[index], &length, sizeof(length));
+}
+
+// Reads the header at an index of the ring of a byte channel.
+static uint64_t byte_read_header(const ByteChannelBuffer* buffer, size_t index)
+{
+    uint64_t length;
+    memcpy(&length, &buffer->bytes[index], sizeof(length));
+
+    return length;
+}
+
+// Frees the internal buffer of a byte channel.
+static void free_byte_buffer(ByteChannelBuffer* buffer)
+{
+    ChannelAllocator allocator = buffer->allocator;
+
+    channel_deallocate(&allocator, buffer->bytes, buffer->capacity);
+    wait_queue_destroy(&buffer->send_waiters);
+    wait_queue_destroy(&buffer->recv_waiters);
+    channel_deallocate(&allocator, buffer, sizeof(ByteChannelBuffer));
+}
+
+ByteChannel* byte_channel(size_t capacity)
+{
+    return byte_channel_with(capacity, NULL);
+}
+
+ByteChannel* byte_channel_with(size_t capacity, const ChannelOptions* options)
+{
+    options = channel_options(options);
+
+    if (capacity == 0 || capacity > SIZE_MAX / 2 || options->multi_consumer || options->trace_latency) {
+        return NULL;
+    }
+
+    capacity = (capacity + BYTE_RECORD_ALIGN - 1) & ~(size_t)(BYTE_RECORD_ALIGN - 1);
+
+    ChannelAllocator allocator = channel_allocator(options);
+    ByteChannelBuffer* buffer = (ByteChannelBuffer*)channel_allocate(
+        &allocator, sizeof(ByteChannelBuffer), _Alignof(ByteChannelBuffer));
+    buffer->allocator = allocator;
+    buffer->capacity = capacity;
+    buffer->bytes = (unsigned char*)channel_allocate(&allocator, capacity, CHANNEL_CACHE_LINE);
+    atomic_init(&buffer->state, CHANNEL_STATE_SENDER + CHANNEL_STATE_RECEIVER);
+    atomic_init(&buffer->tail, 0);
+    buffer->cached_head = 0;
+    buffer->reserved = 0;
+    buffer->reserved_size = 0;
+    buffer->reserving = false;
+    channel_wait_init(&buffer->send_wait, options->wait_policy);
+    atomic_init(&buffer->head, 0);
+    buffer->cached_tail = 0;
+    buffer->held = 0;
+    channel_wait_init(&buffer->recv_wait, options->wait_policy);
+    wait_queue_init(&buffer->send_waiters);
+    wait_queue_init(&buffer->recv_waiters);
+    channel_counters_init(&buffer->send_counters);
+    channel_counters_init(&buffer->recv_counters);
+
+    ByteSender* sender = NEW(ByteSender);
+    sender->buffer = buffer;
+
+    ByteReceiver* receiver = NEW(ByteReceiver);
+    receiver->buffer = buffer;
+
+    ByteChannel* channel = NEW(ByteChannel);
+    channel->sender = sender;
+    channel->receiver = receiver;
+
+    return channel;
+}
+
+// Attempts to reserve room for a record in the ring of a byte channel. The
+// size of the record is passed in `count`, and its address is stored in the
+// first entry of `messages`. If the record does not fit before the end of the
+// ring, the rest of the ring is marked as padding, to be published with the
+// record.
+static int byte_reserve_attempt(BatchOperation* operation)
+{
+    ByteChannelBuffer* buffer = (ByteChannelBuffer*)operation->buffer;
+
+    if (channel_closed(&buffer->state, CHANNEL_STATE_CLOSED)) {
+        return CHANNEL_CLOSED;
+    }
+
+    size_t tail = atomic_load_explicit(&buffer->tail, memory_order_relaxed);
+    size_t index = tail % buffer->capacity;
+    size_t record = byte_record_size(operation->count);
+    size_t skip = buffer->capacity - index < record ? buffer->capacity - index : 0;
+
+    if (buffer->capacity - (tail - buffer->cached_head) < skip + record) {
+        buffer->cached_head = atomic_load_explicit(&buffer->head, memory_order_acquire);
+
+        if (buffer->capacity - (tail - buffer->cached_head) < skip + record) {
+            return CHANNEL_WOULD_BLOCK;
+        }
+    }
+
+    if (skip > 0) {
+        byte_write_header(buffer, index, BYTE_PADDING);
+    }
+
+    buffer->reserved = tail + skip;
+    buffer->reserved_size = operation->count;
+    buffer->reserving = true;
+    operation->messages[0] = &buffer->bytes[(index + skip) % buffer->capacity + BYTE_RECORD_ALIGN];
+    operation->done = 1;
+
+    return CHANNEL_SUCCESS;
+}
+
+// Reserves room for a record in a byte channel, blocking until there is
+// enough room, the receiver is destroyed or the deadline passes.
+static int byte_reserve_until(ByteChannelBuffer* buffer, size_t size, void** data, uint64_t deadline)
+{
+    // A record may take at most half the ring, so that the room it needs,
+    // padding included, never exceeds the ring.
+    if (size > buffer->capacity / 2 || byte_record_size(size) > buffer->capacity / 2) {
+        return CHANNEL_FULL;
+    }
+
+    BatchOperation operation = { buffer, data, size, 0 };
+
+    return park_until_complete(
+        &buffer->send_waiters, &buffer->send_wait, byte_reserve_attempt, &operation, deadline, &buffer->send_counters);
+}
 
-void* unbounded_recv_c(UnboundedChannel* channel)
+// Attempts to read the next record from the ring of a byte channel. The
+// address of the record is stored in the first entry of `messages` and its
+// size in `count`. Padding at the end of the ring is handed back to the
+// sender on the way.
+static int byte_read_attempt(BatchOperation* operation)
 {
-    return unbounded_recv(channel->receiver);
+    ByteChannelBuffer* buffer = (ByteChannelBuffer*)operation->buffer;
+    size_t head = atomic_load_explicit(&buffer->head, memory_order_relaxed);
+
+    for (;;) {
+        if (buffer->cached_tail == head) {
+            buffer->cached_tail = atomic_load_explicit(&buffer->tail, memory_order_acquire);
+        }
+
+        if (buffer->cached_tail == head) {
+            if (!channel_closed(&buffer->state, CHANNEL_STATE_SEND_CLOSED)) {
+                return CHANNEL_WOULD_BLOCK;
+            }
+
+            // Everything committed before the channel was closed is visible
+            // once the close is, so one more look settles whether the ring is
+            // empty.
+            buffer->cached_tail = atomic_load_explicit(&buffer->tail, memory_order_acquire);
+
+            if (buffer->cached_tail == head) {
+                return CHANNEL_CLOSED;
+            }
+        }
+
+        size_t index = head % buffer->capacity;
+        uint64_t length = byte_read_header(buffer, index);
+
+        if (length != BYTE_PADDING) {
+            operation->messages[0] = &buffer->bytes[index + BYTE_RECORD_ALIGN];
+            operation->count = (size_t)length;
+            operation->done = 1;
+            buffer->held = byte_record_size((size_t)length);
+
+            return CHANNEL_SUCCESS;
+        }
+
+        head += buffer->capacity - index;
+        atomic_store_explicit(&buffer->head, head, memory_order_release);
+    }
 }
 
-void free_unbounded_channel(UnboundedChannel* channel)
+// Reads the next record from a byte channel, blocking until there is one, the
+// channel is closed or the deadline passes.
+static int byte_read_until(ByteChannelBuffer* buffer, const void** data, size_t* size, uint64_t deadline)
+{
+    void* record = NULL;
+    BatchOperation operation = { buffer, &record, 0, 0 };
+    int result = park_until_complete(
+        &buffer->recv_waiters, &buffer->recv_wait, byte_read_attempt, &operation, deadline, &buffer->recv_counters);
+
+    if (result == CHANNEL_SUCCESS) {
+        *data = record;
+        *size = operation.count;
+    }
+
+    return result;
+}
+
+int byte_reserve(ByteSender* sender, size_t size, void** data)
+{
+    return byte_reserve_until(sender->buffer, size, data, CHANNEL_NO_DEADLINE);
+}
+
+int byte_reserve_c(ByteChannel* channel, size_t size, void** data)
+{
+    return byte_reserve(channel->sender, size, data);
+}
+
+int byte_reserve_timeout(ByteSender* sender, size_t size, void** data, double timeout)
+{
+    return byte_reserve_until(sender->buffer, size, data, channel_deadline(timeout));
+}
+
+int byte_reserve_timeout_c(ByteChannel* channel, size_t size, void** data, double timeout)
+{
+    return byte_reserve_timeout(channel->sender, size, data, timeout);
+}
+
+int byte_reserve_deadline(ByteSender* sender, size_t size, void** data, uint64_t deadline)
+{
+    return byte_reserve_until(sender->buffer, size, data, deadline);
+}
+
+int byte_reserve_deadline_c(ByteChannel* channel, size_t size, void** data, uint64_t deadline)
+{
+    return byte_reserve_deadline(channel->sender, size, data, deadline);
+}
+
+int byte_try_reserve(ByteSender* sender, size_t size, void** data)
+{
+    int result = byte_reserve_until(sender->buffer, size, data, 0);
+
+    return result == CHANNEL_TIMEOUT ? CHANNEL_FULL : result;
+}
+
+int byte_try_reserve_c(ByteChannel* channel, size_t size, void** data)
+{
+    return byte_try_reserve(channel->sender, size, data);
+}
+
+void byte_commit(ByteSender* sender, size_t size)
+{
+    ByteChannelBuffer* buffer = sender->buffer;
+
+    if (!buffer->reserving) {
+        return;
+    }
+
+    size = CHANNEL_MIN(size, buffer->reserved_size);
+    byte_write_header(buffer, buffer->reserved % buffer->capacity, size);
+    buffer->reserving = false;
+    atomic_store_explicit(&buffer->tail, buffer->reserved + byte_record_size(size), memory_order_release);
+
+    channel_count_sent(&buffer->send_counters, &buffer->recv_counters, 1);
+    wait_queue_notify_one(&buffer->recv_waiters);
+}
+
+void byte_commit_c(ByteChannel* channel, size_t size)
+{
+    byte_commit(channel->sender, size);
+}
+
+int byte_read(ByteReceiver* receiver, const void** data, size_t* size)
+{
+    return byte_read_until(receiver->buffer, data, size, CHANNEL_NO_DEADLINE);
+}
+
+int byte_read_c(ByteChannel* channel, const void** data, size_t* size)
+{
+    return byte_read(channel->receiver, data, size);
+}
+
+int byte_read_timeout(ByteReceiver* receiver, const void** data, size_t* size, double timeout)
+{
+    return byte_read_until(receiver->buffer, data, size, channel_deadline(timeout));
+}
+
+int byte_read_timeout_c(ByteChannel* channel, const void** data, size_t* size, double timeout)
+{
+    return byte_read_timeout(channel->receiver, data, size, timeout);
+}
+
+int byte_read_deadline(ByteReceiver* receiver, const void** data, size_t* size, uint64_t deadline)
+{
+    return byte_read_until(receiver->buffer, data, size, deadline);
+}
+
+int byte_read_deadline_c(ByteChannel* channel, const void** data, size_t* size, uint64_t deadline)
+{
+    return byte_read_deadline(channel->receiver, data, size, deadline);
+}
+
+int byte_try_read(ByteReceiver* receiver, const void** data, size_t* size)
+{
+    int result = byte_read_until(receiver->buffer, data, size, 0);
+
+    return result == CHANNEL_TIMEOUT ? CHANNEL_EMPTY : result;
+}
+
+int byte_try_read_c(ByteChannel* channel, const void** data, size_t* size)
+{
+    return byte_try_read(channel->receiver, data, size);
+}
+
+void byte_release(ByteReceiver* receiver)
 {
-    while (channel->sender->buffer->first_message != NULL) {
-        UnboundedMessage* message = channel->sender->buffer->first_message;
-        channel->sender->buffer->first_message = message->next;
-        free(message);
+    ByteChannelBuffer* buffer = receiver->buffer;
+
+    if (buffer->held == 0) {
+        return;
     }
 
-    free_mutex(channel->sender->buffer->mutex);
-    free(channel->sender->buffer);
+    size_t head = atomic_load_explicit(&buffer->head, memory_order_relaxed);
+    atomic_store_explicit(&buffer->head, head + buffer->held, memory_order_release);
+    buffer->held = 0;
+
+    channel_count(&buffer->recv_counters.messages, 1);
+    wait_queue_notify_one(&buffer->send_waiters);
+}
+
+void byte_release_c(ByteChannel* channel)
+{
+    byte_release(channel->receiver);
+}
+
+void free_byte_channel(ByteChannel* channel)
+{
+    free_byte_buffer(channel->sender->buffer);
     free(channel->sender);
     free(channel->receiver);
     free(channel);
 }
 
-void free_unbounded_channel_wrapper(UnboundedChannel* channel)
+void free_byte_channel_wrapper(ByteChannel* channel)
 {
     free(channel);
 }
 
-void free_unbounded_sender(UnboundedSender* sender)
+// Sets closed flags in the lifecycle state of a byte channel and wakes both
+// sides. Both only wait through `park_until_complete`, which checks the state
+// after registering, so no mutex is needed.
+static void byte_close_with(ByteChannelBuffer* buffer, uint64_t flags)
 {
-    sender->buffer->sender_alive = false;
+    atomic_fetch_or(&buffer->state, flags);
+    wait_queue_notify_all(&buffer->recv_waiters);
+    wait_queue_notify_all(&buffer->send_waiters);
+}
 
-    if (!sender->buffer->receiver_alive) {
-        while (sender->buffer->first_message != NULL) {
-            UnboundedMessage* message = sender->buffer->first_message;
-            sender->buffer->first_message = message->next;
-            free(message);
-        }
+void free_byte_sender(ByteSender* sender)
+{
+    ByteChannelBuffer* buffer = sender->buffer;
+    byte_close_with(buffer, CHANNEL_STATE_SEND_CLOSED);
 
-        free_mutex(sender->buffer->mutex);
-        free(sender->buffer);
+    if (channel_release_handle(&buffer->state, CHANNEL_STATE_SENDER)) {
+        free_byte_buffer(buffer);
     }
 
     free(sender);
 }
 
-void free_unbounded_receiver(UnboundedReceiver* receiver)
+void free_byte_receiver(ByteReceiver* receiver)
+{
+    ByteChannelBuffer* buffer = receiver->buffer;
+    byte_close_with(buffer, CHANNEL_STATE_RECV_CLOSED);
+
+    if (channel_release_handle(&buffer->state, CHANNEL_STATE_RECEIVER)) {
+        free_byte_buffer(buffer);
+    }
+
+    free(receiver);
+}
+
+void byte_close(ByteSender* sender)
+{
+    sender->buffer->reserving = false;
+    byte_close_with(sender->buffer, CHANNEL_STATE_SEND_CLOSED);
+}
+
+void byte_close_c(ByteChannel* channel)
+{
+    byte_close(channel->sender);
+}
+
+SelectCase select_rendezvous_send(RendezvousSender* sender, void* message)
+{
+    SelectCase select_case = { CHANNEL_SELECT_RENDEZVOUS_SEND, sender, message };
+    return select_case;
+}
+
+SelectCase select_rendezvous_recv(RendezvousReceiver* receiver)
+{
+    SelectCase select_case = { CHANNEL_SELECT_RENDEZVOUS_RECV, receiver, NULL };
+    return select_case;
+}
+
+SelectCase select_bounded_send(BoundedSender* sender, void* message)
+{
+    SelectCase select_case = { CHANNEL_SELECT_BOUNDED_SEND, sender, message };
+    return select_case;
+}
+
+SelectCase select_bounded_recv(BoundedReceiver* receiver)
+{
+    SelectCase select_case = { CHANNEL_SELECT_BOUNDED_RECV, receiver, NULL };
+    return select_case;
+}
+
+SelectCase select_unbounded_send(UnboundedSender* sender, void* message)
+{
+    SelectCase select_case = { CHANNEL_SELECT_UNBOUNDED_SEND, sender, message };
+    return select_case;
+}
+
+SelectCase select_unbounded_recv(UnboundedReceiver* receiver)
+{
+    SelectCase select_case = { CHANNEL_SELECT_UNBOUNDED_RECV, receiver, NULL };
+    return select_case;
+}
+
+// Attempts the operation of a select case without blocking. The returned value
+// is the result of the operation, or `CHANNEL_WOULD_BLOCK` if it is not ready.
+static int select_attempt(SelectCase* select_case)
+{
+    int result;
+
+    switch (select_case->operation) {
+        case CHANNEL_SELECT_RENDEZVOUS_SEND:
+            result = rendezvous_try_send((RendezvousSender*)select_case->half, select_case->message);
+            return result == CHANNEL_FULL ? CHANNEL_WOULD_BLOCK : result;
+        case CHANNEL_SELECT_RENDEZVOUS_RECV:
+            result = rendezvous_try_recv((RendezvousReceiver*)select_case->half, &select_case->message);
+            return result == CHANNEL_EMPTY ? CHANNEL_WOULD_BLOCK : result;
+        case CHANNEL_SELECT_BOUNDED_SEND:
+            result = bounded_try_send((BoundedSender*)select_case->half, select_case->message);
+            return result == CHANNEL_FULL ? CHANNEL_WOULD_BLOCK : result;
+        case CHANNEL_SELECT_BOUNDED_RECV:
+            result = bounded_try_recv((BoundedReceiver*)select_case->half, &select_case->message);
+            return result == CHANNEL_EMPTY ? CHANNEL_WOULD_BLOCK : result;
+        case CHANNEL_SELECT_UNBOUNDED_SEND:
+            return unbounded_send((UnboundedSender*)select_case->half, select_case->message);
+        case CHANNEL_SELECT_UNBOUNDED_RECV:
+            result = unbounded_try_recv((UnboundedReceiver*)select_case->half, &select_case->message);
+            return result == CHANNEL_EMPTY ? CHANNEL_WOULD_BLOCK : result;
+        default:
+            return CHANNEL_WOULD_BLOCK;
+    }
+}
+
+// Returns the wait queue that is notified when a select case may have become
+// ready, or NULL if the case never blocks.
+static WaitQueue* select_queue(const SelectCase* select_case)
+{
+    switch (select_case->operation) {
+        case CHANNEL_SELECT_RENDEZVOUS_SEND:
+            return &((RendezvousSender*)select_case->half)->buffer->send_waiters;
+        case CHANNEL_SELECT_RENDEZVOUS_RECV:
+            return &((RendezvousReceiver*)select_case->half)->buffer->recv_waiters;
+        case CHANNEL_SELECT_BOUNDED_SEND:
+            return &((BoundedSender*)select_case->half)->buffer->send_waiters;
+        case CHANNEL_SELECT_BOUNDED_RECV:
+            return &((BoundedReceiver*)select_case->half)->buffer->recv_waiters;
+        case CHANNEL_SELECT_UNBOUNDED_RECV:
+            return &((UnboundedReceiver*)select_case->half)->buffer->recv_waiters;
+        case CHANNEL_SELECT_UNBOUNDED_SEND:
+        default:
+            return NULL;
+    }
+}
+
+// Attempts every select case once, beginning at `start` and wrapping around,
+// and stops at the first one that is ready.
+static int select_attempt_all(SelectCase* cases, size_t count, size_t start, size_t* selected)
+{
+    for (size_t i = 0; i < count; i++) {
+        size_t index = (start + i) % count;
+        int result = select_attempt(&cases[index]);
+
+        if (result != CHANNEL_WOULD_BLOCK) {
+            *selected = index;
+            return result;
+        }
+    }
+
+    return CHANNEL_WOULD_BLOCK;
+}
+
+// Queues a receiver for every rendezvous receive case in its channel, so that
+// senders can fill it directly while the select is parked. All of them share
+// `claim`, which the first sender to fill one sets to the index of its case.
+static void select_enqueue_receivers(
+    SelectCase* cases,
+    size_t count,
+    RendezvousWaiter* receivers,
+    Parker* parker,
+    atomic_size_t* claim)
+{
+    atomic_store(claim, SIZE_MAX);
+
+    for (size_t i = 0; i < count; i++) {
+        if (cases[i].operation != CHANNEL_SELECT_RENDEZVOUS_RECV) {
+            continue;
+        }
+
+        RendezvousChannelBuffer* buffer = ((RendezvousReceiver*)cases[i].half)->buffer;
+        RendezvousWaiter receiver = { parker, &cases[i].message, 1, 0, false, NULL, NULL, claim, i };
+        receivers[i] = receiver;
+
+        mutex_lock(&buffer->mutex);
+        rendezvous_enqueue(&buffer->blocked_receivers, &receivers[i]);
+
+        // A sender blocked in a select may be waiting for a receiver to show
+        // up.
+        wait_queue_notify_one(&buffer->send_waiters);
+        mutex_release(&buffer->mutex);
+    }
+}
+
+// Removes the receivers queued by `select_enqueue_receivers` again. Returns
+// whether a sender filled one of them before the select could claim itself, in
+// which case that case is stored in `selected`.
+static bool select_dequeue_receivers(
+    SelectCase* cases,
+    size_t count,
+    RendezvousWaiter* receivers,
+    atomic_size_t* claim,
+    size_t* selected)
 {
-    receiver->buffer->receiver_alive = false;
+    size_t claimed = SIZE_MAX;
+    bool filled = !atomic_compare_exchange_strong(claim, &claimed, count);
+
+    for (size_t i = 0; i < count; i++) {
+        if (cases[i].operation != CHANNEL_SELECT_RENDEZVOUS_RECV) {
+            continue;
+        }
 
-    if (!receiver->buffer->sender_alive) {
-        while (receiver->buffer->first_message != NULL) {
-            UnboundedMessage* message = receiver->buffer->first_message;
-            receiver->buffer->first_message = message->next;
-            free(message);
+        // The sender fills a receiver with the mutex held, so the message is
+        // in place once the mutex is taken here.
+        RendezvousChannelBuffer* buffer = ((RendezvousReceiver*)cases[i].half)->buffer;
+        mutex_lock(&buffer->mutex);
+
+        if (!receivers[i].complete) {
+            rendezvous_remove(&buffer->blocked_receivers, &receivers[i]);
         }
 
-        free_mutex(receiver->buffer->mutex);
-        free(receiver->buffer);
+        mutex_release(&buffer->mutex);
+
+        if (filled && i == claimed) {
+            channel_count(&buffer->recv_counters.messages, 1);
+        }
     }
 
-    free(receiver);
+    if (filled) {
+        *selected = claimed;
+    }
+
+    return filled;
+}
+
+// Blocks until one of the select cases completes or the deadline passes. The
+// calling thread registers a waiter with the wait queue of every case, all
+// sharing one parker, so that whichever channel becomes ready first wakes it.
+static int select_until(SelectCase* cases, size_t count, size_t* selected, uint64_t deadline)
+{
+    size_t index = 0;
+
+    if (selected == NULL) {
+        selected = &index;
+    }
+
+    // Starting at a random case keeps one busy channel from starving the
+    // others.
+    size_t start = count > 0 ? channel_random() % count : 0;
+    int result = select_attempt_all(cases, count, start, selected);
+
+    if (result != CHANNEL_WOULD_BLOCK) {
+        return result;
+    }
+
+    if (deadline != CHANNEL_NO_DEADLINE && channel_now() >= deadline) {
+        return CHANNEL_TIMEOUT;
+    }
+
+    Parker parker;
+    parker_init(&parker);
+
+    Waiter* waiters = NEW_N(Waiter, count);
+    RendezvousWaiter* receivers = NEW_N(RendezvousWaiter, count);
+    atomic_size_t claim;
+    atomic_init(&claim, SIZE_MAX);
+
+    for (;;) {
+        for (size_t i = 0; i < count; i++) {
+            WaitQueue* queue = select_queue(&cases[i]);
+
+            if (queue != NULL) {
+                waiters[i].parker = &parker;
+                wait_queue_register(queue, &waiters[i]);
+            }
+        }
+
+        result = select_attempt_all(cases, count, start, selected);
+        bool unparked = true;
+
+        if (result == CHANNEL_WOULD_BLOCK) {
+            select_enqueue_receivers(cases, count, receivers, &parker, &claim);
+            unparked = parker_park_until(&parker, deadline);
+
+            if (select_dequeue_receivers(cases, count, receivers, &claim, selected)) {
+                result = CHANNEL_SUCCESS;
+            }
+        }
+
+        bool notified = false;
+
+        for (size_t i = 0; i < count; i++) {
+            WaitQueue* queue = select_queue(&cases[i]);
+
+            if (queue != NULL && wait_queue_unregister(queue, &waiters[i])) {
+                notified = true;
+
+                // Pass on notifications for cases that were not taken.
+                if (result != CHANNEL_WOULD_BLOCK && i != *selected) {
+                    wait_queue_notify_one(queue);
+                }
+            }
+        }
+
+        if (result != CHANNEL_WOULD_BLOCK) {
+            break;
+        }
+
+        if (!unparked && !notified) {
+            result = CHANNEL_TIMEOUT;
+            break;
+        }
+    }
+
+    free(receivers);
+    free(waiters);
+    parker_destroy(&parker);
+
+    return result;
+}
+
+int channel_select(SelectCase* cases, size_t count, size_t* selected)
+{
+    return select_until(cases, count, selected, CHANNEL_NO_DEADLINE);
+}
+
+int channel_try_select(SelectCase* cases, size_t count, size_t* selected)
+{
+    int result = select_until(cases, count, selected, 0);
+
+    return result == CHANNEL_TIMEOUT ? CHANNEL_EMPTY : result;
+}
+
+int channel_select_timeout(SelectCase* cases, size_t count, size_t* selected, double timeout)
+{
+    return select_until(cases, count, selected, channel_deadline(timeout));
+}
+
+int channel_select_deadline(SelectCase* cases, size_t count, size_t* selected, uint64_t deadline)
+{
+    return select_until(cases, count, selected, deadline);
+}
+
+bool rendezvous_channel_stats(RendezvousChannelBuffer* buffer, ChannelStats* stats)
+{
+    return channel_counters_snapshot(&buffer->send_counters, &buffer->recv_counters, stats);
+}
+
+bool bounded_channel_stats(BoundedChannelBuffer* buffer, ChannelStats* stats)
+{
+    return channel_counters_snapshot(&buffer->send_counters, &buffer->recv_counters, stats);
+}
+
+bool unbounded_channel_stats(UnboundedChannelBuffer* buffer, ChannelStats* stats)
+{
+    return channel_counters_snapshot(&buffer->send_counters, &buffer->recv_counters, stats);
+}
+
+bool byte_channel_stats(ByteChannelBuffer* buffer, ChannelStats* stats)
+{
+    return channel_counters_snapshot(&buffer->send_counters, &buffer->recv_counters, stats);
+}
+
+bool bounded_channel_latency(BoundedChannelBuffer* buffer, ChannelLatency* latency)
+{
+    return latency_snapshot(buffer->latency, latency);
+}
+
+bool unbounded_channel_latency(UnboundedChannelBuffer* buffer, ChannelLatency* latency)
+{
+    return latency_snapshot(buffer->latency, latency);
+}
+
+void bounded_channel_latency_reset(BoundedChannelBuffer* buffer)
+{
+    if (buffer->latency != NULL) {
+        latency_histogram_reset(buffer->latency);
+    }
+}
+
+void unbounded_channel_latency_reset(UnboundedChannelBuffer* buffer)
+{
+    if (buffer->latency != NULL) {
+        latency_histogram_reset(buffer->latency);
+    }
+}
+
+uint64_t channel_latency_bucket_min(size_t bucket)
+{
+    if (bucket < CHANNEL_LATENCY_SUB_BUCKETS) {
+        return bucket;
+    }
+
+    if (bucket >= CHANNEL_LATENCY_BUCKETS) {
+        return UINT64_MAX;
+    }
+
+    size_t log = bucket / CHANNEL_LATENCY_SUB_BUCKETS + LATENCY_SUB_BUCKET_BITS - 1;
+    uint64_t mantissa = bucket % CHANNEL_LATENCY_SUB_BUCKETS + CHANNEL_LATENCY_SUB_BUCKETS;
+
+    return mantissa << (log - LATENCY_SUB_BUCKET_BITS);
+}
+
+uint64_t channel_latency_percentile(const ChannelLatency* latency, double percentile)
+{
+    if (latency->count == 0) {
+        return 0;
+    }
+
+    // The rank of the latency sought, counting from one.
+    double target = (percentile > 0 ? percentile : 0) / 100 * (double)latency->count;
+    uint64_t rank = target < (double)latency->count ? (uint64_t)target : latency->count;
+
+    if ((double)rank < target || rank == 0) {
+        rank++;
+    }
+
+    uint64_t seen = 0;
+
+    for (size_t i = 0; i < CHANNEL_LATENCY_BUCKETS; i++) {
+        seen += latency->buckets[i];
+
+        if (seen >= rank) {
+            uint64_t end = channel_latency_bucket_min(i + 1) - 1;
+
+            return CHANNEL_MIN(end, latency->max_ns);
+        }
+    }
+
+    return latency->max_ns;
+}
+
+int bounded_receiver_fd(BoundedReceiver* receiver)
+{
+    return channel_event_fd(&receiver->buffer->event_fd);
+}
+
+int unbounded_receiver_fd(UnboundedReceiver* receiver)
+{
+    return channel_event_fd(&receiver->buffer->event_fd);
 }
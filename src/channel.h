@@ -1,7 +1,9 @@
 #ifndef CHANNEL_H
 #define CHANNEL_H
 
+#include "clock.h"
 #include "mutex.h"
+#include "park.h"
 #include <stdlib.h>
 #include <stdbool.h>
 #include <stdatomic.h>
@@ -9,19 +11,227 @@
 #define CHANNEL_SUCCESS     0
 #define CHANNEL_CLOSED      1
 #define CHANNEL_MUTEX_ERROR 2
+#define CHANNEL_TIMEOUT     3
+#define CHANNEL_EMPTY       4
+#define CHANNEL_FULL        5
 
-// A message in a rendezvous channel.
-typedef struct RendezvousMessage_ {
-    void* message;
-} RendezvousMessage;
+// The size of a cache line, which fields written by different threads are
+// aligned to so that they do not share one.
+#define CHANNEL_CACHE_LINE 64
+
+// Callbacks a channel uses to allocate the memory it owns: the internal
+// buffer, the ring of a bounded channel, and the nodes or blocks that hold
+// the messages of an unbounded channel. `allocate` returns `size` bytes
+// aligned to `alignment`, a power of two no larger than `CHANNEL_CACHE_LINE`;
+// like `malloc` in the rest of the library, it is not expected to fail.
+// `deallocate` releases memory returned by `allocate`, given the size that
+// was requested. Both are passed `context`, and may be called from any thread
+// that uses the channel until the channel is freed. The sending and receiving
+// halves and the channel wrapper are always allocated with `malloc`.
+typedef struct ChannelAllocator_ {
+    void* (*allocate)(void* context, size_t size, size_t alignment);
+    void (*deallocate)(void* context, void* pointer, size_t size);
+    void* context;
+} ChannelAllocator;
+
+// Wait policies for `ChannelOptions`, which decide what a thread does when an
+// operation on a bounded or unbounded channel cannot complete yet.
+// `CHANNEL_WAIT_POWER_SAVING` parks the thread straight away, which costs no
+// CPU time but a wake-up through the kernel. `CHANNEL_WAIT_THROUGHPUT` first
+// spins for up to a couple of microseconds and yields a few times, and
+// `CHANNEL_WAIT_LATENCY` spins for up to tens of microseconds and yields
+// more, before parking. Either way, the time spent spinning adapts to how
+// long recent waits on the same side of the channel took: a thread spins for
+// about twice as long as a typical wait, and not at all once waits outgrow
+// the limit of the policy, since then the spinning would be wasted.
+#define CHANNEL_WAIT_POWER_SAVING 0
+#define CHANNEL_WAIT_THROUGHPUT   1
+#define CHANNEL_WAIT_LATENCY      2
+
+// The wait policy of one side of a bounded or unbounded channel, and a
+// moving average of how long its threads recently waited for an operation
+// to complete, in nanoseconds.
+typedef struct ChannelWaitState_ {
+    int policy;
+    atomic_uint_fast64_t average_ns;
+} ChannelWaitState;
+
+// Options for creating a channel with `rendezvous_channel_with`,
+// `bounded_channel_with` or `unbounded_channel_with`. A zero-initialized
+// struct, like passing NULL, creates the same channel as the constructor
+// without options.
+//
+// `lock` selects one of the `CHANNEL_LOCK_*` backends from `mutex.h` for the
+// mutex of the channel. The spinlock is usually the fastest choice for
+// bounded and unbounded channels, whose critical sections only copy a few
+// pointers, but it wastes CPU time when there are more busy threads than
+// cores. Lock-free channels only take the mutex when a thread blocks, so the
+// backend hardly matters for them.
+//
+// `lockfree` creates a bounded or unbounded channel like
+// `bounded_channel_lockfree` or `unbounded_channel_lockfree`, and
+// `multi_consumer` allows additional receivers to be created with
+// `clone_bounded_receiver` or `clone_unbounded_receiver`. `single_producer`
+// creates a channel like `spsc_bounded_channel` or `spsc_unbounded_channel`,
+// regardless of `lockfree`. Rendezvous channels support none of these,
+// unbounded channels do not support `lockfree` together with
+// `multi_consumer`, and neither bounded nor unbounded channels support
+// `single_producer` together with `multi_consumer`; the constructors return
+// NULL for such options.
+//
+// `allocator` points to the callbacks the channel allocates its memory with,
+// which are copied into the channel. NULL allocates from the C library with
+// the requested alignment.
+//
+// `trace_latency` makes a bounded or unbounded channel time every message
+// from send to receive and keep a histogram of the latencies, which
+// `channel_latency` reads. The send time is kept next to the message in the
+// ring slot or list node, never in the message itself. Tracing costs a clock
+// read per batch on each side and turns off the inline fast paths of
+// `channel_inline.h`. Rendezvous channels do not support it.
+//
+// `wait_policy` is one of the `CHANNEL_WAIT_*` policies above. Rendezvous
+// channels only support `CHANNEL_WAIT_POWER_SAVING`.
+typedef struct ChannelOptions_ {
+    int lock;
+    bool lockfree;
+    bool multi_consumer;
+    bool single_producer;
+    const ChannelAllocator* allocator;
+    bool trace_latency;
+    int wait_policy;
+} ChannelOptions;
+
+// The counters kept by each side of a channel when the library is built with
+// `CHANNEL_STATS` defined, which `make STATS=true` does. Otherwise they stay
+// zero and cost nothing but their space in the buffer. Each side has its own
+// cache line and only updates it with relaxed atomic operations, so counting
+// adds no synchronization between the sides. `max_depth` is only kept by the
+// sending side.
+typedef struct ChannelCounters_ {
+    atomic_uint_fast64_t messages;
+    atomic_uint_fast64_t blocked_ns;
+    atomic_uint_fast64_t waits;
+    atomic_uint_fast64_t contentions;
+    atomic_uint_fast64_t max_depth;
+} ChannelCounters;
+
+// A snapshot of the counters of a channel, taken with `channel_stats`.
+// `depth` is the number of messages sent but not yet received, and
+// `max_depth` the largest depth a sender has seen. `send_blocked_ns` and
+// `recv_blocked_ns` add up the time threads spent blocked in sends and
+// receives, and `send_waits` and `recv_waits` count how often they blocked.
+// `lock_contentions` counts the times a thread found the mutex of the
+// channel taken. Blocking in `channel_select` is not counted, since it
+// involves several channels.
+//
+// The counters are read one by one while the channel is in use, so the
+// snapshot is not atomic as a whole.
+typedef struct ChannelStats_ {
+    uint64_t sent;
+    uint64_t received;
+    uint64_t depth;
+    uint64_t max_depth;
+    uint64_t send_blocked_ns;
+    uint64_t recv_blocked_ns;
+    uint64_t send_waits;
+    uint64_t recv_waits;
+    uint64_t lock_contentions;
+} ChannelStats;
+
+// The number of buckets each power of two of nanoseconds is split into by a
+// latency histogram. Like in an HDR histogram, a latency is therefore known
+// to within an eighth of its value, whatever its magnitude.
+#define CHANNEL_LATENCY_SUB_BUCKETS 8
 
-// The internal message buffer in a rendezvous channel.
+// The number of buckets in a latency histogram. Latencies below
+// `CHANNEL_LATENCY_SUB_BUCKETS` nanoseconds each have a bucket of their own,
+// and every power of two above that has `CHANNEL_LATENCY_SUB_BUCKETS`, up to
+// the largest latency that fits in 64 bits.
+#define CHANNEL_LATENCY_BUCKETS (62 * CHANNEL_LATENCY_SUB_BUCKETS)
+
+// The histogram of the time messages spend in a bounded or unbounded channel
+// created with `trace_latency` set, from the moment they are sent to the
+// moment they are received. Receivers update it with relaxed atomic
+// operations. `min_ns` starts out at `UINT64_MAX`.
+typedef struct ChannelLatencyHistogram_ {
+    atomic_uint_fast64_t buckets[CHANNEL_LATENCY_BUCKETS];
+    atomic_uint_fast64_t total_ns;
+    atomic_uint_fast64_t min_ns;
+    atomic_uint_fast64_t max_ns;
+} ChannelLatencyHistogram;
+
+// A snapshot of the latency histogram of a channel, taken with
+// `channel_latency`. `count` is the number of messages received, and
+// `buckets` the number of them whose latency fell in each bucket. `min_ns`
+// and `max_ns` are exact; both are zero if no message was received. Like the
+// counters of `ChannelStats`, the buckets are read one by one, so a snapshot
+// taken while messages are received is not atomic as a whole.
+typedef struct ChannelLatency_ {
+    uint64_t count;
+    uint64_t total_ns;
+    uint64_t min_ns;
+    uint64_t max_ns;
+    uint64_t buckets[CHANNEL_LATENCY_BUCKETS];
+} ChannelLatency;
+
+// The lifecycle of a channel is kept in a single atomic state word: two
+// flags telling whether the channel is closed for sending and whether every
+// receiver is gone, and below them the number of sender and receiver handles
+// left, counted in units of `CHANNEL_STATE_SENDER` and
+// `CHANNEL_STATE_RECEIVER`. Operations only ever load the word, and whoever
+// releases the last handle of either kind frees the buffer.
+#define CHANNEL_STATE_SEND_CLOSED ((uint64_t)1)
+#define CHANNEL_STATE_RECV_CLOSED ((uint64_t)2)
+#define CHANNEL_STATE_CLOSED      (CHANNEL_STATE_SEND_CLOSED | CHANNEL_STATE_RECV_CLOSED)
+#define CHANNEL_STATE_SENDER      ((uint64_t)1 << 2)
+#define CHANNEL_STATE_RECEIVER    ((uint64_t)1 << 33)
+
+// Set in the tail position of a lock-free bounded or unbounded channel once
+// it is closed for sending. Slots are claimed by advancing the tail, so no
+// slot can be claimed after the mark is set, and receivers know the channel
+// is drained once their head reaches the marked tail.
+#define CHANNEL_TAIL_CLOSED (SIZE_MAX / 2 + 1)
+
+// A thread blocked in a rendezvous channel, waiting for the other side to
+// take or fill its array of messages. Waiters live on the stack of the blocked
+// thread and are only touched with the buffer mutex held. A receiver blocked in
+// a select is queued in every rendezvous channel it waits on, and the sender
+// that fills it first has to claim the select by setting `claim` from
+// `SIZE_MAX` to `index`, the position of its case. `claim` is NULL otherwise.
+typedef struct RendezvousWaiter_ {
+    Parker* parker;
+    void** messages;
+    size_t count;
+    size_t done;
+    bool complete;
+    struct RendezvousWaiter_* prev;
+    struct RendezvousWaiter_* next;
+    atomic_size_t* claim;
+    size_t index;
+} RendezvousWaiter;
+
+// A queue of threads blocked in a rendezvous channel.
+typedef struct RendezvousQueue_ {
+    RendezvousWaiter* head;
+    RendezvousWaiter* tail;
+} RendezvousQueue;
+
+// The internal state of a rendezvous channel. Messages are never stored in
+// the buffer itself: they are copied directly between the arrays of the
+// sending and receiving threads, whichever side arrived first being queued
+// in `blocked_senders` or `blocked_receivers`. The wait queues are only used
+// by selects.
 typedef struct RendezvousChannelBuffer_ {
-    RendezvousMessage* message;
-    bool sender_alive;
-    bool receiver_alive;
-    Mutex* mutex;
-    atomic_flag send_blocked;
+    RendezvousQueue blocked_senders;
+    RendezvousQueue blocked_receivers;
+    atomic_uint_fast64_t state;
+    ChannelAllocator allocator;
+    Mutex mutex;
+    WaitQueue send_waiters;
+    WaitQueue recv_waiters;
+    _Alignas(CHANNEL_CACHE_LINE) ChannelCounters send_counters;
+    _Alignas(CHANNEL_CACHE_LINE) ChannelCounters recv_counters;
 } RendezvousChannelBuffer;
 
 // The sending half of a rendezvous channel.
@@ -61,6 +271,10 @@ typedef struct RendezvousChannel_ {
 // introduce a race condition.
 RendezvousChannel* rendezvous_channel(void);
 
+// Creates a rendezvous channel, like `rendezvous_channel`, with the given
+// options. NULL is returned if the options are not supported.
+RendezvousChannel* rendezvous_channel_with(const ChannelOptions* options);
+
 // Sends a message through the channel via the sender. The message must be
 // kept alive at at least long enough to be received. The returned value is an
 // error code.
@@ -79,6 +293,146 @@ void* rendezvous_recv(RendezvousReceiver* receiver);
 // returned, the sender was destroyed.
 void* rendezvous_recv_c(RendezvousChannel* channel);
 
+// Sends a message through the channel via the sender, like `rendezvous_send`,
+// but gives up and returns `CHANNEL_TIMEOUT` if the message has not been
+// received within `timeout` seconds.
+int rendezvous_send_timeout(RendezvousSender* sender, void* message, double timeout);
+
+// Sends a message through the channel via the channel wrapper, like `rendezvous_send`,
+// but gives up and returns `CHANNEL_TIMEOUT` if the message has not been
+// received within `timeout` seconds.
+int rendezvous_send_timeout_c(RendezvousChannel* channel, void* message, double timeout);
+
+// Sends a message through the channel via the sender, like
+// `rendezvous_send_timeout`, but with an absolute deadline on the monotonic
+// clock, in nanoseconds, as returned by `channel_now` or `channel_deadline`.
+int rendezvous_send_deadline(RendezvousSender* sender, void* message, uint64_t deadline);
+
+// Sends a message through the channel via the channel wrapper, like
+// `rendezvous_send_timeout`, but with an absolute deadline on the monotonic
+// clock, in nanoseconds, as returned by `channel_now` or `channel_deadline`.
+int rendezvous_send_deadline_c(RendezvousChannel* channel, void* message, uint64_t deadline);
+
+// Receives a message from the channel via the receiver, blocking for at most
+// `timeout` seconds. The message is stored in `message`. The returned value
+// is `CHANNEL_SUCCESS`, `CHANNEL_CLOSED` if the sender was destroyed, or
+// `CHANNEL_TIMEOUT`.
+int rendezvous_recv_timeout(RendezvousReceiver* receiver, void** message, double timeout);
+
+// Receives a message from the channel via the channel wrapper, blocking for at most
+// `timeout` seconds. The message is stored in `message`. The returned value
+// is `CHANNEL_SUCCESS`, `CHANNEL_CLOSED` if the sender was destroyed, or
+// `CHANNEL_TIMEOUT`.
+int rendezvous_recv_timeout_c(RendezvousChannel* channel, void** message, double timeout);
+
+// Receives a message from the channel via the receiver, like
+// `rendezvous_recv_timeout`, but with an absolute deadline on the monotonic
+// clock, in nanoseconds, as returned by `channel_now` or `channel_deadline`.
+int rendezvous_recv_deadline(RendezvousReceiver* receiver, void** message, uint64_t deadline);
+
+// Receives a message from the channel via the channel wrapper, like
+// `rendezvous_recv_timeout`, but with an absolute deadline on the monotonic
+// clock, in nanoseconds, as returned by `channel_now` or `channel_deadline`.
+int rendezvous_recv_deadline_c(RendezvousChannel* channel, void** message, uint64_t deadline);
+
+// Sends a message through the channel via the sender without blocking. This
+// only succeeds if the receiver is currently blocked waiting for a message,
+// in which case the message is handed straight to it. Otherwise
+// `CHANNEL_FULL` is returned.
+int rendezvous_try_send(RendezvousSender* sender, void* message);
+
+// Sends a message through the channel via the channel wrapper without blocking. This
+// only succeeds if the receiver is currently blocked waiting for a message,
+// in which case the message is handed straight to it. Otherwise
+// `CHANNEL_FULL` is returned.
+int rendezvous_try_send_c(RendezvousChannel* channel, void* message);
+
+// Receives a message from the channel via the receiver without blocking. The
+// message is stored in `message`. If `CHANNEL_EMPTY` is returned, no message
+// was available; if `CHANNEL_CLOSED` is returned, the sender was destroyed
+// and every message has been received.
+int rendezvous_try_recv(RendezvousReceiver* receiver, void** message);
+
+// Receives a message from the channel via the channel wrapper without blocking. The
+// message is stored in `message`. If `CHANNEL_EMPTY` is returned, no message
+// was available; if `CHANNEL_CLOSED` is returned, the sender was destroyed
+// and every message has been received.
+int rendezvous_try_recv_c(RendezvousChannel* channel, void** message);
+
+// Sends a batch of messages through the channel via the sender, blocking
+// until the receiver has received all of them. The receiver reads the
+// messages straight out of `messages`, so the array must stay alive until
+// this returns. The number of messages received is stored in `sent`, which
+// may be NULL. The returned value is an error code.
+int rendezvous_send_many(RendezvousSender* sender, void** messages, size_t count, size_t* sent);
+
+// Sends a batch of messages through the channel via the channel wrapper, blocking
+// until the receiver has received all of them. The receiver reads the
+// messages straight out of `messages`, so the array must stay alive until
+// this returns. The number of messages received is stored in `sent`, which
+// may be NULL. The returned value is an error code.
+int rendezvous_send_many_c(RendezvousChannel* channel, void** messages, size_t count, size_t* sent);
+
+// Sends a batch of messages through the channel via the sender, giving up
+// once `timeout` seconds have passed. If `CHANNEL_TIMEOUT` is returned, only
+// the first `*sent` messages were sent.
+int rendezvous_send_many_timeout(
+    RendezvousSender* sender,
+    void** messages,
+    size_t count,
+    size_t* sent,
+    double timeout);
+
+// Sends a batch of messages through the channel via the channel wrapper, giving up
+// once `timeout` seconds have passed. If `CHANNEL_TIMEOUT` is returned, only
+// the first `*sent` messages were sent.
+int rendezvous_send_many_timeout_c(
+    RendezvousChannel* channel,
+    void** messages,
+    size_t count,
+    size_t* sent,
+    double timeout);
+
+// Receives up to `max` messages from the channel via the receiver, blocking
+// until at least one is available. The number of messages written to
+// `messages` is stored in `received`, which may be NULL. If `CHANNEL_CLOSED` is
+// returned, the sender was destroyed and every message has been received.
+int rendezvous_recv_many(
+    RendezvousReceiver* receiver,
+    void** messages,
+    size_t max,
+    size_t* received);
+
+// Receives up to `max` messages from the channel via the channel wrapper, blocking
+// until at least one is available. The number of messages written to
+// `messages` is stored in `received`, which may be NULL. If `CHANNEL_CLOSED` is
+// returned, the sender was destroyed and every message has been received.
+int rendezvous_recv_many_c(
+    RendezvousChannel* channel,
+    void** messages,
+    size_t max,
+    size_t* received);
+
+// Receives up to `max` messages from the channel via the receiver, like
+// `rendezvous_recv_many`, but returns `CHANNEL_TIMEOUT` if no message arrives
+// within `timeout` seconds.
+int rendezvous_recv_many_timeout(
+    RendezvousReceiver* receiver,
+    void** messages,
+    size_t max,
+    size_t* received,
+    double timeout);
+
+// Receives up to `max` messages from the channel via the channel wrapper, like
+// `rendezvous_recv_many`, but returns `CHANNEL_TIMEOUT` if no message arrives
+// within `timeout` seconds.
+int rendezvous_recv_many_timeout_c(
+    RendezvousChannel* channel,
+    void** messages,
+    size_t max,
+    size_t* received,
+    double timeout);
+
 // Frees all memory within the channel, including the sender, receiver, and
 // internal buffer.
 void free_rendezvous_channel(RendezvousChannel* channel);
@@ -87,30 +441,97 @@ void free_rendezvous_channel(RendezvousChannel* channel);
 // and internal buffer will remain allocated.
 void free_rendezvous_channel_wrapper(RendezvousChannel* channel);
 
+// Creates another sender for the channel, for use by another producer. The
+// clone must be freed with `free_rendezvous_sender` like the original. The
+// channel is only closed to the receiver once every sender has been freed.
+RendezvousSender* clone_rendezvous_sender(RendezvousSender* sender);
+
 // Frees the memory used by the sending half of the channel. If the receiver
-// is still alive, the internal buffer will remain allocated.
+// or another sender is still alive, the internal buffer will remain
+// allocated. Freeing the last sender closes the channel.
 void free_rendezvous_sender(RendezvousSender* sender);
 
+// Closes the channel on behalf of every sender, without freeing any of them.
+// Threads blocked in the channel are woken at once and get `CHANNEL_CLOSED`,
+// as does every later send and receive. Messages already handed over are
+// kept. Closing a closed channel does nothing.
+void rendezvous_close(RendezvousSender* sender);
+
+// Closes the channel via the channel wrapper, like `rendezvous_close`.
+void rendezvous_close_c(RendezvousChannel* channel);
+
 // Frees the memory used by the receiving half of the channel. If the sender
 // is still alive, the internal buffer will remain allocated.
 void free_rendezvous_receiver(RendezvousReceiver* receiver);
 
-// A message in a bounded channel. This only contains a pointer to the message
-// itself.
-typedef struct BoundedMessage_ {
+// A slot in the ring of a lock-free bounded channel. The sequence number
+// tells producers and the consumer which lap of the ring the slot belongs to:
+// it is twice the position the slot is waiting for, plus one once a message
+// has been written. Doubling keeps the states of consecutive laps apart even
+// when the capacity is one.
+typedef struct BoundedSlot_ {
+    atomic_size_t sequence;
     void* message;
-} BoundedMessage;
+} BoundedSlot;
 
-// The internal message buffer of a bounded channel.
+// The internal message buffer of a bounded channel. Lock-free channels use
+// `slots`, `head` and `tail`; single-producer channels use `messages`, `head`
+// and `tail`, plus a copy of the other side's position kept by each side; all
+// other channels use `messages`, `size` and `head_offset` under the mutex.
+// Either way the ring is a single cache-aligned array of `capacity` entries.
+// Closing a multi-producer lock-free channel sets `CHANNEL_TAIL_CLOSED` in
+// `tail`; `state` holds the lifecycle of every channel.
+//
+// `values` is the ring seen as bytes, with `element_size` bytes per slot. For
+// channels of pointers it is the same array as `messages`, unless the channel
+// is lock-free, in which case it is NULL. Sized channels keep their values in
+// it instead, alongside `slots` if they are lock-free, and leave `messages`
+// NULL.
+//
+// Channels that trace latency keep the send time of the message in each slot
+// in `sent_at`, another array of `capacity` entries; otherwise `sent_at` and
+// `latency` are NULL.
+//
+// `event_fd` is the descriptor returned by `bounded_receiver_fd`, or -1 until
+// it is first asked for.
+//
+// The buffer itself is cache-aligned too, and its fields are grouped by the
+// side that writes them, each group starting on its own cache line: the
+// fields that only change when a half is created or freed, the tail and wait
+// state written by senders, the head and wait state written by the receiver,
+// the state of the locked ring, and the two wait queues. A sender and a
+// receiver working on the ring at the same time therefore do not keep
+// stealing each other's cache lines. The mutex shares its line with the
+// locked ring state it protects.
 typedef struct BoundedChannelBuffer_ {
     size_t capacity;
+    bool power_of_two;
+    bool lockfree;
+    bool multi_consumer;
+    bool single_producer;
+    bool sized;
+    void** messages;
+    BoundedSlot* slots;
+    size_t element_size;
+    unsigned char* values;
+    uint64_t* sent_at;
+    ChannelLatencyHistogram* latency;
+    atomic_int event_fd;
+    ChannelAllocator allocator;
+    atomic_uint_fast64_t state;
+    _Alignas(CHANNEL_CACHE_LINE) atomic_size_t tail;
+    size_t cached_head;
+    ChannelWaitState send_wait;
+    _Alignas(CHANNEL_CACHE_LINE) atomic_size_t head;
+    size_t cached_tail;
+    ChannelWaitState recv_wait;
+    _Alignas(CHANNEL_CACHE_LINE) Mutex mutex;
     size_t size;
     size_t head_offset;
-    BoundedMessage** messages;
-    bool sender_alive;
-    bool receiver_alive;
-    Mutex* mutex;
-    atomic_flag send_blocked;
+    _Alignas(CHANNEL_CACHE_LINE) WaitQueue send_waiters;
+    _Alignas(CHANNEL_CACHE_LINE) WaitQueue recv_waiters;
+    _Alignas(CHANNEL_CACHE_LINE) ChannelCounters send_counters;
+    _Alignas(CHANNEL_CACHE_LINE) ChannelCounters recv_counters;
 } BoundedChannelBuffer;
 
 // The sending half of a bounded channel.
@@ -134,7 +555,8 @@ typedef struct BoundedChannel_ {
 // clear up space within the buffer. The capacity cannot be zero, or NULL will
 // be returned. If you need a channel with a zero-sized buffer, use a rendezvous
 // channel. If you need a channel with no upper bound on memory usage, use an
-// unbounded channel.
+// unbounded channel. Any capacity may be used, but a power of two lets the
+// channel locate ring slots with a mask rather than a division.
 //
 // The channel is intended to be separated into its sending and receiving
 // halves. To separate the channel, use this function, extract the `sender` and
@@ -152,6 +574,41 @@ typedef struct BoundedChannel_ {
 // introduce a race condition.
 BoundedChannel* bounded_channel(size_t capacity);
 
+// Creates a lock-free bounded channel with the given internal buffer capacity.
+// The channel behaves exactly like one created by `bounded_channel` and is
+// used through the same functions, but sending and receiving never take a
+// lock. Each slot of the ring carries a sequence number, so concurrent senders
+// only contend on a single atomic increment of the tail position. The
+// capacity cannot be zero, or NULL will be returned.
+//
+// This is the better choice when many threads send through the same channel.
+// The channel is multi-producer, single-consumer, like `bounded_channel`.
+BoundedChannel* bounded_channel_lockfree(size_t capacity);
+
+// Creates a multi-producer, multi-consumer bounded channel with the given
+// internal buffer capacity. The channel is lock-free like one created by
+// `bounded_channel_lockfree` and is used through the same functions, but any
+// number of threads may receive from it at the same time. Each message is
+// received by exactly one receiver. Additional receivers are created with
+// `clone_bounded_receiver`, and the channel counts as closed to senders once
+// every receiver has been freed. The capacity cannot be zero, or NULL will be
+// returned.
+BoundedChannel* bounded_channel_mpmc(size_t capacity);
+
+// Creates a single-producer, single-consumer bounded channel with the given
+// internal buffer capacity. The channel is used through the same functions as
+// one created by `bounded_channel`, but there can only ever be one sender and
+// one receiver, so `clone_bounded_sender` returns NULL. In exchange, sending
+// and receiving are wait-free: each side owns its position in the ring and
+// keeps a copy of the other side's, which it only refreshes when the ring
+// looks full or empty, so the two threads rarely touch the same cache line.
+// The capacity cannot be zero, or NULL will be returned.
+BoundedChannel* spsc_bounded_channel(size_t capacity);
+
+// Creates a bounded channel, like `bounded_channel`, with the given options.
+// NULL is returned if the capacity is zero.
+BoundedChannel* bounded_channel_with(size_t capacity, const ChannelOptions* options);
+
 // Sends a message through the channel via the sender. The message must be
 // kept alive at at least long enough to be received. The returned value is an
 // error code.
@@ -170,6 +627,132 @@ void* bounded_recv(BoundedReceiver* receiver);
 // returned, the sender was destroyed.
 void* bounded_recv_c(BoundedChannel* channel);
 
+// Sends a message through the channel via the sender, like `bounded_send`,
+// but gives up and returns `CHANNEL_TIMEOUT` if the message has not been
+// sent within `timeout` seconds.
+int bounded_send_timeout(BoundedSender* sender, void* message, double timeout);
+
+// Sends a message through the channel via the channel wrapper, like `bounded_send`,
+// but gives up and returns `CHANNEL_TIMEOUT` if the message has not been
+// sent within `timeout` seconds.
+int bounded_send_timeout_c(BoundedChannel* channel, void* message, double timeout);
+
+// Sends a message through the channel via the sender, like
+// `bounded_send_timeout`, but with an absolute deadline on the monotonic
+// clock, in nanoseconds, as returned by `channel_now` or `channel_deadline`.
+int bounded_send_deadline(BoundedSender* sender, void* message, uint64_t deadline);
+
+// Sends a message through the channel via the channel wrapper, like
+// `bounded_send_timeout`, but with an absolute deadline on the monotonic
+// clock, in nanoseconds, as returned by `channel_now` or `channel_deadline`.
+int bounded_send_deadline_c(BoundedChannel* channel, void* message, uint64_t deadline);
+
+// Receives a message from the channel via the receiver, blocking for at most
+// `timeout` seconds. The message is stored in `message`. The returned value
+// is `CHANNEL_SUCCESS`, `CHANNEL_CLOSED` if the sender was destroyed, or
+// `CHANNEL_TIMEOUT`.
+int bounded_recv_timeout(BoundedReceiver* receiver, void** message, double timeout);
+
+// Receives a message from the channel via the channel wrapper, blocking for at most
+// `timeout` seconds. The message is stored in `message`. The returned value
+// is `CHANNEL_SUCCESS`, `CHANNEL_CLOSED` if the sender was destroyed, or
+// `CHANNEL_TIMEOUT`.
+int bounded_recv_timeout_c(BoundedChannel* channel, void** message, double timeout);
+
+// Receives a message from the channel via the receiver, like
+// `bounded_recv_timeout`, but with an absolute deadline on the monotonic
+// clock, in nanoseconds, as returned by `channel_now` or `channel_deadline`.
+int bounded_recv_deadline(BoundedReceiver* receiver, void** message, uint64_t deadline);
+
+// Receives a message from the channel via the channel wrapper, like
+// `bounded_recv_timeout`, but with an absolute deadline on the monotonic
+// clock, in nanoseconds, as returned by `channel_now` or `channel_deadline`.
+int bounded_recv_deadline_c(BoundedChannel* channel, void** message, uint64_t deadline);
+
+// Sends a message through the channel via the sender without blocking. If
+// the buffer is full, `CHANNEL_FULL` is returned and nothing is sent.
+int bounded_try_send(BoundedSender* sender, void* message);
+
+// Sends a message through the channel via the channel wrapper without blocking. If
+// the buffer is full, `CHANNEL_FULL` is returned and nothing is sent.
+int bounded_try_send_c(BoundedChannel* channel, void* message);
+
+// Receives a message from the channel via the receiver without blocking. The
+// message is stored in `message`. If `CHANNEL_EMPTY` is returned, no message
+// was available; if `CHANNEL_CLOSED` is returned, the sender was destroyed
+// and every message has been received.
+int bounded_try_recv(BoundedReceiver* receiver, void** message);
+
+// Receives a message from the channel via the channel wrapper without blocking. The
+// message is stored in `message`. If `CHANNEL_EMPTY` is returned, no message
+// was available; if `CHANNEL_CLOSED` is returned, the sender was destroyed
+// and every message has been received.
+int bounded_try_recv_c(BoundedChannel* channel, void** message);
+
+// Sends a batch of messages through the channel via the sender, blocking
+// while the buffer is full. Free slots are filled in as few steps as
+// possible. The number of messages sent is stored in `sent`, which may be
+// NULL. The returned value is an error code.
+int bounded_send_many(BoundedSender* sender, void** messages, size_t count, size_t* sent);
+
+// Sends a batch of messages through the channel via the channel wrapper, blocking
+// while the buffer is full. Free slots are filled in as few steps as
+// possible. The number of messages sent is stored in `sent`, which may be
+// NULL. The returned value is an error code.
+int bounded_send_many_c(BoundedChannel* channel, void** messages, size_t count, size_t* sent);
+
+// Sends a batch of messages through the channel via the sender, giving up
+// once `timeout` seconds have passed. If `CHANNEL_TIMEOUT` is returned, only
+// the first `*sent` messages were sent.
+int bounded_send_many_timeout(
+    BoundedSender* sender,
+    void** messages,
+    size_t count,
+    size_t* sent,
+    double timeout);
+
+// Sends a batch of messages through the channel via the channel wrapper, giving up
+// once `timeout` seconds have passed. If `CHANNEL_TIMEOUT` is returned, only
+// the first `*sent` messages were sent.
+int bounded_send_many_timeout_c(
+    BoundedChannel* channel,
+    void** messages,
+    size_t count,
+    size_t* sent,
+    double timeout);
+
+// Receives up to `max` messages from the channel via the receiver, blocking
+// until at least one is available. The number of messages written to
+// `messages` is stored in `received`, which may be NULL. If `CHANNEL_CLOSED` is
+// returned, the sender was destroyed and every message has been received.
+int bounded_recv_many(BoundedReceiver* receiver, void** messages, size_t max, size_t* received);
+
+// Receives up to `max` messages from the channel via the channel wrapper, blocking
+// until at least one is available. The number of messages written to
+// `messages` is stored in `received`, which may be NULL. If `CHANNEL_CLOSED` is
+// returned, the sender was destroyed and every message has been received.
+int bounded_recv_many_c(BoundedChannel* channel, void** messages, size_t max, size_t* received);
+
+// Receives up to `max` messages from the channel via the receiver, like
+// `bounded_recv_many`, but returns `CHANNEL_TIMEOUT` if no message arrives
+// within `timeout` seconds.
+int bounded_recv_many_timeout(
+    BoundedReceiver* receiver,
+    void** messages,
+    size_t max,
+    size_t* received,
+    double timeout);
+
+// Receives up to `max` messages from the channel via the channel wrapper, like
+// `bounded_recv_many`, but returns `CHANNEL_TIMEOUT` if no message arrives
+// within `timeout` seconds.
+int bounded_recv_many_timeout_c(
+    BoundedChannel* channel,
+    void** messages,
+    size_t max,
+    size_t* received,
+    double timeout);
+
 // Frees all memory within the channel, including the sender, receiver, and
 // internal buffer.
 void free_bounded_channel(BoundedChannel* channel);
@@ -178,39 +761,350 @@ void free_bounded_channel(BoundedChannel* channel);
 // and internal buffer will remain allocated.
 void free_bounded_channel_wrapper(BoundedChannel* channel);
 
+// Creates another sender for the channel, for use by another producer. The
+// clone must be freed with `free_bounded_sender` like the original. The
+// channel is only closed to the receiver once every sender has been freed. If
+// the channel is single-producer, NULL is returned.
+BoundedSender* clone_bounded_sender(BoundedSender* sender);
+
 // Frees the memory used by the sending half of the channel. If the receiver
-// is still alive, the internal buffer will remain allocated.
+// or another sender is still alive, the internal buffer will remain
+// allocated. Freeing the last sender closes the channel.
 void free_bounded_sender(BoundedSender* sender);
 
+// Creates another receiver for a channel created by `bounded_channel_mpmc`,
+// or with the `multi_consumer` option. The clone must be freed with
+// `free_bounded_receiver` like the original. If the channel is single-consumer,
+// NULL is returned.
+BoundedReceiver* clone_bounded_receiver(BoundedReceiver* receiver);
+
 // Frees the memory used by the receiving half of the channel. If the sender
-// is still alive, the internal buffer will remain allocated.
+// or another receiver is still alive, the internal buffer will remain
+// allocated.
 void free_bounded_receiver(BoundedReceiver* receiver);
 
-// A message in a bounded channel. This contains a pointer to the message and
-// a pointer to the next message.
+// Closes the channel on behalf of every sender, without freeing any of them.
+// Blocked senders and receivers are woken at once. Later sends fail with
+// `CHANNEL_CLOSED`, while receivers still get every message sent before the
+// channel was closed, and `CHANNEL_CLOSED` once it is drained. A send racing
+// with the close either fails or is delivered like those before it. On a
+// single-producer channel the close must not race with a send, since both
+// go through the one sender. Closing a closed channel does nothing.
+void bounded_close(BoundedSender* sender);
+
+// Closes the channel via the channel wrapper, like `bounded_close`.
+void bounded_close_c(BoundedChannel* channel);
+
+// Creates a bounded channel that carries values of `element_size` bytes
+// rather than pointers. Sending copies the value into a slot of the ring and
+// receiving copies it out again, so nothing has to be allocated per message
+// and the value does not need to outlive the send. The channel is otherwise
+// like one created by `bounded_channel`, and is freed, cloned and separated
+// into its halves with the same functions. Neither the capacity nor the
+// element size can be zero, or NULL will be returned.
+//
+// Values are sent and received with the `*_value` and `*_values` functions
+// below. The functions for pointers, including the select cases, must not
+// be used with a sized channel, nor the functions for values with any other
+// channel. `CHANNEL_DEFINE_BOUNDED` defines wrappers for a particular type
+// that prevent such mistakes.
+BoundedChannel* bounded_channel_sized(size_t capacity, size_t element_size);
+
+// Creates a sized bounded channel, like `bounded_channel_sized`, with the
+// given options. The options have the same effect as for `bounded_channel_with`.
+BoundedChannel* bounded_channel_sized_with(size_t capacity, size_t element_size, const ChannelOptions* options);
+
+// Sends a copy of the value `value` points to through a sized channel via the
+// sender. The returned value is an error code.
+int bounded_send_value(BoundedSender* sender, const void* value);
+
+// Sends a copy of the value `value` points to through a sized channel via the
+// channel wrapper. The returned value is an error code.
+int bounded_send_value_c(BoundedChannel* channel, const void* value);
+
+// Receives a value from a sized channel via the receiver and copies it to
+// `value`. If `CHANNEL_CLOSED` is returned, the sender was destroyed and every
+// value has been received.
+int bounded_recv_value(BoundedReceiver* receiver, void* value);
+
+// Receives a value from a sized channel via the channel wrapper and copies it
+// to `value`. If `CHANNEL_CLOSED` is returned, the sender was destroyed and
+// every value has been received.
+int bounded_recv_value_c(BoundedChannel* channel, void* value);
+
+// Sends a value through a sized channel via the sender, like
+// `bounded_send_value`, but gives up and returns `CHANNEL_TIMEOUT` if the
+// value has not been sent within `timeout` seconds.
+int bounded_send_value_timeout(BoundedSender* sender, const void* value, double timeout);
+
+// Sends a value through a sized channel via the channel wrapper, like
+// `bounded_send_value`, but gives up and returns `CHANNEL_TIMEOUT` if the
+// value has not been sent within `timeout` seconds.
+int bounded_send_value_timeout_c(BoundedChannel* channel, const void* value, double timeout);
+
+// Receives a value from a sized channel via the receiver, like
+// `bounded_recv_value`, but gives up and returns `CHANNEL_TIMEOUT` if no
+// value arrives within `timeout` seconds.
+int bounded_recv_value_timeout(BoundedReceiver* receiver, void* value, double timeout);
+
+// Receives a value from a sized channel via the channel wrapper, like
+// `bounded_recv_value`, but gives up and returns `CHANNEL_TIMEOUT` if no
+// value arrives within `timeout` seconds.
+int bounded_recv_value_timeout_c(BoundedChannel* channel, void* value, double timeout);
+
+// Sends a value through a sized channel via the sender, like
+// `bounded_send_value_timeout`, but with an absolute deadline on the
+// monotonic clock, in nanoseconds.
+int bounded_send_value_deadline(BoundedSender* sender, const void* value, uint64_t deadline);
+
+// Sends a value through a sized channel via the channel wrapper, like
+// `bounded_send_value_timeout`, but with an absolute deadline on the
+// monotonic clock, in nanoseconds.
+int bounded_send_value_deadline_c(BoundedChannel* channel, const void* value, uint64_t deadline);
+
+// Receives a value from a sized channel via the receiver, like
+// `bounded_recv_value_timeout`, but with an absolute deadline on the
+// monotonic clock, in nanoseconds.
+int bounded_recv_value_deadline(BoundedReceiver* receiver, void* value, uint64_t deadline);
+
+// Receives a value from a sized channel via the channel wrapper, like
+// `bounded_recv_value_timeout`, but with an absolute deadline on the
+// monotonic clock, in nanoseconds.
+int bounded_recv_value_deadline_c(BoundedChannel* channel, void* value, uint64_t deadline);
+
+// Sends a value through a sized channel via the sender without blocking. If
+// the buffer is full, `CHANNEL_FULL` is returned and nothing is sent.
+int bounded_try_send_value(BoundedSender* sender, const void* value);
+
+// Sends a value through a sized channel via the channel wrapper without
+// blocking. If the buffer is full, `CHANNEL_FULL` is returned and nothing is
+// sent.
+int bounded_try_send_value_c(BoundedChannel* channel, const void* value);
+
+// Receives a value from a sized channel via the receiver without blocking.
+// If `CHANNEL_EMPTY` is returned, no value was available; if `CHANNEL_CLOSED`
+// is returned, the sender was destroyed and every value has been received.
+int bounded_try_recv_value(BoundedReceiver* receiver, void* value);
+
+// Receives a value from a sized channel via the channel wrapper without
+// blocking. If `CHANNEL_EMPTY` is returned, no value was available; if
+// `CHANNEL_CLOSED` is returned, the sender was destroyed and every value has
+// been received.
+int bounded_try_recv_value_c(BoundedChannel* channel, void* value);
+
+// Sends a batch of `count` consecutive values through a sized channel via the
+// sender, blocking while the buffer is full, like `bounded_send_many`. The
+// number of values sent is stored in `sent`, which may be NULL.
+int bounded_send_values(BoundedSender* sender, const void* values, size_t count, size_t* sent);
+
+// Sends a batch of `count` consecutive values through a sized channel via the
+// channel wrapper, blocking while the buffer is full, like
+// `bounded_send_many`. The number of values sent is stored in `sent`, which
+// may be NULL.
+int bounded_send_values_c(BoundedChannel* channel, const void* values, size_t count, size_t* sent);
+
+// Receives up to `max` values from a sized channel via the receiver into the
+// array `values`, blocking until at least one is available, like
+// `bounded_recv_many`. The number of values received is stored in
+// `received`, which may be NULL.
+int bounded_recv_values(BoundedReceiver* receiver, void* values, size_t max, size_t* received);
+
+// Receives up to `max` values from a sized channel via the channel wrapper
+// into the array `values`, blocking until at least one is available, like
+// `bounded_recv_many`. The number of values received is stored in
+// `received`, which may be NULL.
+int bounded_recv_values_c(BoundedChannel* channel, void* values, size_t max, size_t* received);
+
+// Defines a bounded channel type for values of type `T`. `Name##Sender` and
+// `Name##Receiver` wrap the halves of a sized channel, and `Name##Channel`
+// holds both. The functions defined along with them mirror the functions for
+// sized channels, taking and returning values of type `T`, so the compiler
+// checks that only values of that type go through the channel:
+//
+//     CHANNEL_DEFINE_BOUNDED(Point, struct point)
+//
+//     PointChannel channel = Point_channel(64);
+//     Point_send(channel.sender, (struct point){ 1, 2 });
+//     struct point received;
+//     Point_recv(channel.receiver, &received);
+//     Point_free_sender(channel.sender);
+//     Point_free_receiver(channel.receiver);
+//
+// `Name##_channel` returns halves holding NULL if the channel cannot be
+// created.
+#define CHANNEL_DEFINE_BOUNDED(Name, T) \
+    typedef struct Name##Sender_ { BoundedSender* half; } Name##Sender; \
+    typedef struct Name##Receiver_ { BoundedReceiver* half; } Name##Receiver; \
+    typedef struct Name##Channel_ { Name##Sender sender; Name##Receiver receiver; } Name##Channel; \
+    static inline Name##Channel Name##_channel_with(size_t capacity, const ChannelOptions* options) \
+    { \
+        Name##Channel typed = { { NULL }, { NULL } }; \
+        BoundedChannel* channel = bounded_channel_sized_with(capacity, sizeof(T), options); \
+        if (channel != NULL) { \
+            typed.sender.half = channel->sender; \
+            typed.receiver.half = channel->receiver; \
+            free_bounded_channel_wrapper(channel); \
+        } \
+        return typed; \
+    } \
+    static inline Name##Channel Name##_channel(size_t capacity) \
+    { \
+        return Name##_channel_with(capacity, NULL); \
+    } \
+    static inline int Name##_send(Name##Sender sender, T value) \
+    { \
+        return bounded_send_value(sender.half, &value); \
+    } \
+    static inline int Name##_recv(Name##Receiver receiver, T* value) \
+    { \
+        return bounded_recv_value(receiver.half, value); \
+    } \
+    static inline int Name##_send_timeout(Name##Sender sender, T value, double timeout) \
+    { \
+        return bounded_send_value_timeout(sender.half, &value, timeout); \
+    } \
+    static inline int Name##_recv_timeout(Name##Receiver receiver, T* value, double timeout) \
+    { \
+        return bounded_recv_value_timeout(receiver.half, value, timeout); \
+    } \
+    static inline int Name##_try_send(Name##Sender sender, T value) \
+    { \
+        return bounded_try_send_value(sender.half, &value); \
+    } \
+    static inline int Name##_try_recv(Name##Receiver receiver, T* value) \
+    { \
+        return bounded_try_recv_value(receiver.half, value); \
+    } \
+    static inline int Name##_send_many(Name##Sender sender, const T* values, size_t count, size_t* sent) \
+    { \
+        return bounded_send_values(sender.half, values, count, sent); \
+    } \
+    static inline int Name##_recv_many(Name##Receiver receiver, T* values, size_t max, size_t* received) \
+    { \
+        return bounded_recv_values(receiver.half, values, max, received); \
+    } \
+    static inline Name##Sender Name##_clone_sender(Name##Sender sender) \
+    { \
+        Name##Sender clone = { clone_bounded_sender(sender.half) }; \
+        return clone; \
+    } \
+    static inline Name##Receiver Name##_clone_receiver(Name##Receiver receiver) \
+    { \
+        Name##Receiver clone = { clone_bounded_receiver(receiver.half) }; \
+        return clone; \
+    } \
+    static inline void Name##_free_sender(Name##Sender sender) \
+    { \
+        free_bounded_sender(sender.half); \
+    } \
+    static inline void Name##_free_receiver(Name##Receiver receiver) \
+    { \
+        free_bounded_receiver(receiver.half); \
+    }
+
+// A message in an unbounded channel. This contains a pointer to the message,
+// a pointer to the next message and the time the message was sent, which is
+// zero unless the channel traces latency.
 typedef struct UnboundedMessage_ {
     void* message;
     struct UnboundedMessage_* next;
+    uint64_t sent_at;
 } UnboundedMessage;
 
-// The internal message buffer of an unbounded channel.
+// The number of free nodes the receiver of an unbounded channel gathers
+// before passing them to the senders in one go.
+#define UNBOUNDED_NODE_BATCH 64
+
+// The number of batches of free nodes an unbounded channel keeps around for
+// reuse.
+#define UNBOUNDED_SPARE_NODE_BATCHES 4
+
+// Free message nodes kept by one half of an unbounded channel. Senders take
+// nodes from their cache and receivers put the nodes of received messages in
+// theirs, so most messages neither allocate nor free memory. Full batches
+// travel from the receivers to the senders through the channel buffer, which
+// is the only place the two sides meet. `busy` is set while a thread uses the
+// cache; a thread that finds it set, because it shares the half with another
+// thread, goes to the allocator instead.
+typedef struct UnboundedNodeCache_ {
+    atomic_flag busy;
+    size_t count;
+    UnboundedMessage* first;
+} UnboundedNodeCache;
+
+// The number of message slots in each block of a lock-free unbounded channel.
+#define UNBOUNDED_BLOCK_CAPACITY 63
+
+// The number of positions per block. The extra position marks a block whose
+// successor is still being installed.
+#define UNBOUNDED_BLOCK_LAP (UNBOUNDED_BLOCK_CAPACITY + 1)
+
+// The number of retired blocks a lock-free unbounded channel keeps around for
+// reuse.
+#define UNBOUNDED_SPARE_BLOCKS 4
+
+// A slot in a block of a lock-free unbounded channel. `sent_at` is zero
+// unless the channel traces latency.
+typedef struct UnboundedSlot_ {
+    void* message;
+    uint64_t sent_at;
+    atomic_bool ready;
+} UnboundedSlot;
+
+// A block of message slots in a lock-free unbounded channel. Blocks form a
+// singly linked list from the receiver to the senders.
+typedef struct UnboundedBlock_ {
+    _Atomic(struct UnboundedBlock_*) next;
+    UnboundedSlot slots[UNBOUNDED_BLOCK_CAPACITY];
+} UnboundedBlock;
+
+// The internal message buffer of an unbounded channel. Lock-free channels use
+// the block fields; all other channels use the message list under the mutex,
+// with nodes recycled through `spare_nodes`, each entry of which is a chain of
+// `UNBOUNDED_NODE_BATCH` free nodes. Closing a lock-free channel sets
+// `CHANNEL_TAIL_CLOSED` in `tail`. `event_fd` is the descriptor returned by
+// `unbounded_receiver_fd`, or -1 until it is first asked for.
+//
+// Like that of a bounded channel, the buffer is cache-aligned and its fields
+// are grouped by writer on separate cache lines: the fields that only change
+// when a half is created or freed, the head and wait state written by the
+// receiver, the tail written by senders, the spare blocks and nodes passed
+// from the receiver to senders, the mutex together with the message list it
+// protects, and the wait queue.
 typedef struct UnboundedChannelBuffer_ {
+    bool lockfree;
+    bool multi_consumer;
+    bool single_producer;
+    ChannelLatencyHistogram* latency;
+    atomic_int event_fd;
+    ChannelAllocator allocator;
+    atomic_uint_fast64_t state;
+    _Alignas(CHANNEL_CACHE_LINE) size_t head;
+    UnboundedBlock* head_block;
+    ChannelWaitState recv_wait;
+    _Alignas(CHANNEL_CACHE_LINE) atomic_size_t tail;
+    _Atomic(UnboundedBlock*) tail_block;
+    _Alignas(CHANNEL_CACHE_LINE) _Atomic(UnboundedBlock*) spare_blocks[UNBOUNDED_SPARE_BLOCKS];
+    _Atomic(UnboundedMessage*) spare_nodes[UNBOUNDED_SPARE_NODE_BATCHES];
+    _Alignas(CHANNEL_CACHE_LINE) Mutex mutex;
     size_t size;
     UnboundedMessage* first_message;
     UnboundedMessage* last_message;
-    bool sender_alive;
-    bool receiver_alive;
-    Mutex* mutex;
+    _Alignas(CHANNEL_CACHE_LINE) WaitQueue recv_waiters;
+    _Alignas(CHANNEL_CACHE_LINE) ChannelCounters send_counters;
+    _Alignas(CHANNEL_CACHE_LINE) ChannelCounters recv_counters;
 } UnboundedChannelBuffer;
 
 // The sending half of an unbounded channel.
 typedef struct UnboundedSender_ {
     UnboundedChannelBuffer* buffer;
+    UnboundedNodeCache nodes;
 } UnboundedSender;
 
 // The receiving half of an unbounded channel.
 typedef struct UnboundedReceiver_ {
     UnboundedChannelBuffer* buffer;
+    UnboundedNodeCache nodes;
 } UnboundedReceiver;
 
 // Both halves of an unbounded channel.
@@ -237,8 +1131,46 @@ typedef struct UnboundedChannel_ {
 // simultaneously, but there can only ever be one receiver. Attempting to
 // receive from a single channel via two or more threads at the same time will
 // introduce a race condition.
+//
+// Each message is stored in a node of its own. Nodes are recycled from the
+// receiver to the senders in batches of `UNBOUNDED_NODE_BATCH`, so a steady
+// stream of messages stops allocating memory once the first few batches
+// have been received. Senders that each use their own clone, rather than
+// sharing one, make the most of this.
 UnboundedChannel* unbounded_channel(void);
 
+// Creates a lock-free unbounded channel. The channel behaves exactly like one
+// created by `unbounded_channel` and is used through the same functions, but
+// messages are stored in blocks of `UNBOUNDED_BLOCK_CAPACITY` slots rather
+// than in individually allocated nodes. Sending a message costs a couple of
+// atomic operations, and a block is only allocated once every
+// `UNBOUNDED_BLOCK_CAPACITY` messages. Blocks drained by the receiver are
+// recycled for later messages.
+//
+// The channel is multi-producer, single-consumer, like `unbounded_channel`.
+UnboundedChannel* unbounded_channel_lockfree(void);
+
+// Creates a multi-producer, multi-consumer unbounded channel. The channel is
+// used through the same functions as one created by `unbounded_channel`, but
+// any number of threads may receive from it at the same time. Each message is
+// received by exactly one receiver. Additional receivers are created with
+// `clone_unbounded_receiver`, and the channel counts as closed to senders once
+// every receiver has been freed.
+UnboundedChannel* unbounded_channel_mpmc(void);
+
+// Creates a single-producer, single-consumer unbounded channel. The channel
+// stores messages in blocks like one created by `unbounded_channel_lockfree`
+// and is used through the same functions, but there can only ever be one
+// sender and one receiver, so `clone_unbounded_sender` returns NULL. In
+// exchange, sending is a plain store per message with no atomic
+// read-modify-write, and a block is only allocated once every
+// `UNBOUNDED_BLOCK_CAPACITY` messages.
+UnboundedChannel* spsc_unbounded_channel(void);
+
+// Creates an unbounded channel, like `unbounded_channel`, with the given
+// options. NULL is returned if the options are not supported.
+UnboundedChannel* unbounded_channel_with(const ChannelOptions* options);
+
 // Sends a message through the channel via the sender. The message must be
 // kept alive at at least long enough to be received. The returned value is an
 // error code.
@@ -257,6 +1189,90 @@ void* unbounded_recv(UnboundedReceiver* receiver);
 // returned, the sender was destroyed.
 void* unbounded_recv_c(UnboundedChannel* channel);
 
+// Receives a message from the channel via the receiver, blocking for at most
+// `timeout` seconds. The message is stored in `message`. The returned value
+// is `CHANNEL_SUCCESS`, `CHANNEL_CLOSED` if the sender was destroyed, or
+// `CHANNEL_TIMEOUT`.
+int unbounded_recv_timeout(UnboundedReceiver* receiver, void** message, double timeout);
+
+// Receives a message from the channel via the channel wrapper, blocking for at most
+// `timeout` seconds. The message is stored in `message`. The returned value
+// is `CHANNEL_SUCCESS`, `CHANNEL_CLOSED` if the sender was destroyed, or
+// `CHANNEL_TIMEOUT`.
+int unbounded_recv_timeout_c(UnboundedChannel* channel, void** message, double timeout);
+
+// Receives a message from the channel via the receiver, like
+// `unbounded_recv_timeout`, but with an absolute deadline on the monotonic
+// clock, in nanoseconds, as returned by `channel_now` or `channel_deadline`.
+int unbounded_recv_deadline(UnboundedReceiver* receiver, void** message, uint64_t deadline);
+
+// Receives a message from the channel via the channel wrapper, like
+// `unbounded_recv_timeout`, but with an absolute deadline on the monotonic
+// clock, in nanoseconds, as returned by `channel_now` or `channel_deadline`.
+int unbounded_recv_deadline_c(UnboundedChannel* channel, void** message, uint64_t deadline);
+
+// Sends a message through the channel via the sender. Sending through an
+// unbounded channel never blocks, so this is the same as `unbounded_send`.
+int unbounded_try_send(UnboundedSender* sender, void* message);
+
+// Sends a message through the channel via the channel wrapper. Sending through an
+// unbounded channel never blocks, so this is the same as `unbounded_send`.
+int unbounded_try_send_c(UnboundedChannel* channel, void* message);
+
+// Receives a message from the channel via the receiver without blocking. The
+// message is stored in `message`. If `CHANNEL_EMPTY` is returned, no message
+// was available; if `CHANNEL_CLOSED` is returned, the sender was destroyed
+// and every message has been received.
+int unbounded_try_recv(UnboundedReceiver* receiver, void** message);
+
+// Receives a message from the channel via the channel wrapper without blocking. The
+// message is stored in `message`. If `CHANNEL_EMPTY` is returned, no message
+// was available; if `CHANNEL_CLOSED` is returned, the sender was destroyed
+// and every message has been received.
+int unbounded_try_recv_c(UnboundedChannel* channel, void** message);
+
+// Sends a batch of messages through the channel via the sender. The whole
+// batch is appended at once. The number of messages sent is stored in
+// `sent`, which may be NULL. The returned value is an error code.
+int unbounded_send_many(UnboundedSender* sender, void** messages, size_t count, size_t* sent);
+
+// Sends a batch of messages through the channel via the channel wrapper. The whole
+// batch is appended at once. The number of messages sent is stored in
+// `sent`, which may be NULL. The returned value is an error code.
+int unbounded_send_many_c(UnboundedChannel* channel, void** messages, size_t count, size_t* sent);
+
+// Receives up to `max` messages from the channel via the receiver, blocking
+// until at least one is available. The number of messages written to
+// `messages` is stored in `received`, which may be NULL. If `CHANNEL_CLOSED` is
+// returned, the sender was destroyed and every message has been received.
+int unbounded_recv_many(UnboundedReceiver* receiver, void** messages, size_t max, size_t* received);
+
+// Receives up to `max` messages from the channel via the channel wrapper, blocking
+// until at least one is available. The number of messages written to
+// `messages` is stored in `received`, which may be NULL. If `CHANNEL_CLOSED` is
+// returned, the sender was destroyed and every message has been received.
+int unbounded_recv_many_c(UnboundedChannel* channel, void** messages, size_t max, size_t* received);
+
+// Receives up to `max` messages from the channel via the receiver, like
+// `unbounded_recv_many`, but returns `CHANNEL_TIMEOUT` if no message arrives
+// within `timeout` seconds.
+int unbounded_recv_many_timeout(
+    UnboundedReceiver* receiver,
+    void** messages,
+    size_t max,
+    size_t* received,
+    double timeout);
+
+// Receives up to `max` messages from the channel via the channel wrapper, like
+// `unbounded_recv_many`, but returns `CHANNEL_TIMEOUT` if no message arrives
+// within `timeout` seconds.
+int unbounded_recv_many_timeout_c(
+    UnboundedChannel* channel,
+    void** messages,
+    size_t max,
+    size_t* received,
+    double timeout);
+
 // Frees all memory within the channel, including the sender, receiver, and
 // internal buffer.
 void free_unbounded_channel(UnboundedChannel* channel);
@@ -265,12 +1281,397 @@ void free_unbounded_channel(UnboundedChannel* channel);
 // and internal buffer will remain allocated.
 void free_unbounded_channel_wrapper(UnboundedChannel* channel);
 
+// Creates another sender for the channel, for use by another producer. The
+// clone must be freed with `free_unbounded_sender` like the original. The
+// channel is only closed to the receiver once every sender has been freed. If
+// the channel is single-producer, NULL is returned.
+UnboundedSender* clone_unbounded_sender(UnboundedSender* sender);
+
 // Frees the memory used by the sending half of the channel. If the receiver
-// is still alive, the internal buffer will remain allocated.
+// or another sender is still alive, the internal buffer will remain
+// allocated. Freeing the last sender closes the channel.
 void free_unbounded_sender(UnboundedSender* sender);
 
+// Creates another receiver for a channel created by `unbounded_channel_mpmc`,
+// or with the `multi_consumer` option. The clone must be freed with
+// `free_unbounded_receiver` like the original. If the channel is single-consumer,
+// NULL is returned.
+UnboundedReceiver* clone_unbounded_receiver(UnboundedReceiver* receiver);
+
 // Frees the memory used by the receiving half of the channel. If the sender
-// is still alive, the internal buffer will remain allocated.
+// or another receiver is still alive, the internal buffer will remain
+// allocated.
 void free_unbounded_receiver(UnboundedReceiver* receiver);
 
+// Closes the channel on behalf of every sender, without freeing any of them,
+// like `bounded_close`. Receivers are woken at once, get every message sent
+// before the channel was closed, and `CHANNEL_CLOSED` once it is drained.
+void unbounded_close(UnboundedSender* sender);
+
+// Closes the channel via the channel wrapper, like `unbounded_close`.
+void unbounded_close_c(UnboundedChannel* channel);
+
+// The alignment of the records in the ring of a byte channel, which is also
+// the size of the header in front of each record that holds its length.
+#define BYTE_RECORD_ALIGN 8
+
+// The internal ring of a byte channel. Records are stored back to back in
+// `bytes`, each as a length header followed by the record itself, padded to
+// a multiple of `BYTE_RECORD_ALIGN`. A record never wraps around: if it does
+// not fit before the end of the ring, the sender marks the rest of the ring
+// as padding and starts the record at the beginning. `head` and `tail` are
+// byte positions that only ever grow, and as in a single-producer bounded
+// channel, each side keeps a copy of the other side's position that it only
+// refreshes when the ring looks full or empty.
+//
+// `reserved` is the position of the record reserved by the sender and
+// `reserved_size` its size, while `reserving` is set. `held` is the room
+// taken by the record last read by the receiver, or zero once released.
+//
+// The fields are grouped by writer on separate cache lines, like those of a
+// bounded channel.
+typedef struct ByteChannelBuffer_ {
+    size_t capacity;
+    unsigned char* bytes;
+    ChannelAllocator allocator;
+    atomic_uint_fast64_t state;
+    _Alignas(CHANNEL_CACHE_LINE) atomic_size_t tail;
+    size_t cached_head;
+    size_t reserved;
+    size_t reserved_size;
+    bool reserving;
+    ChannelWaitState send_wait;
+    _Alignas(CHANNEL_CACHE_LINE) atomic_size_t head;
+    size_t cached_tail;
+    size_t held;
+    ChannelWaitState recv_wait;
+    _Alignas(CHANNEL_CACHE_LINE) WaitQueue send_waiters;
+    _Alignas(CHANNEL_CACHE_LINE) WaitQueue recv_waiters;
+    _Alignas(CHANNEL_CACHE_LINE) ChannelCounters send_counters;
+    _Alignas(CHANNEL_CACHE_LINE) ChannelCounters recv_counters;
+} ByteChannelBuffer;
+
+// The sending half of a byte channel.
+typedef struct ByteSender_ {
+    ByteChannelBuffer* buffer;
+} ByteSender;
+
+// The receiving half of a byte channel.
+typedef struct ByteReceiver_ {
+    ByteChannelBuffer* buffer;
+} ByteReceiver;
+
+// A channel that carries records of bytes, with its sending and receiving
+// halves.
+typedef struct ByteChannel_ {
+    ByteSender* sender;
+    ByteReceiver* receiver;
+} ByteChannel;
+
+// Creates a byte channel with a ring of `capacity` bytes, rounded up to a
+// multiple of `BYTE_RECORD_ALIGN`. A byte channel carries records of any
+// length without allocating or copying them: the sender reserves room for a
+// record in the ring with `byte_reserve`, writes the record in place and
+// publishes it with `byte_commit`, and the receiver reads it in place with
+// `byte_read` and hands the room back with `byte_release`. Each record takes
+// its size plus a header of `BYTE_RECORD_ALIGN` bytes, rounded up to a
+// multiple of `BYTE_RECORD_ALIGN`, and may take at most half the ring, which
+// keeps a record that has to skip the end of the ring from ever needing more
+// room than the ring has.
+//
+// The channel is single-producer, single-consumer: the sender and receiver
+// cannot be cloned, and each may only be used by one thread at a time. NULL
+// is returned if the capacity is zero.
+ByteChannel* byte_channel(size_t capacity);
+
+// Creates a byte channel, like `byte_channel`, with the given options. The
+// lock and lock-free options are ignored, since the ring is always lock-free.
+// NULL is returned if the capacity is zero, or if `multi_consumer` or
+// `trace_latency` is set.
+ByteChannel* byte_channel_with(size_t capacity, const ChannelOptions* options);
+
+// Reserves room for a record of `size` bytes in the ring via the sender,
+// blocking until there is enough room or the receiver is destroyed, and
+// stores the address of the record in `data`. The record is written there
+// and published with `byte_commit`, which must happen before the next
+// reservation. The address is aligned to `BYTE_RECORD_ALIGN`. If the record
+// can never fit in the ring, `CHANNEL_FULL` is returned. The returned value
+// is an error code.
+int byte_reserve(ByteSender* sender, size_t size, void** data);
+
+// Reserves room for a record via the channel wrapper, like `byte_reserve`.
+int byte_reserve_c(ByteChannel* channel, size_t size, void** data);
+
+// Reserves room for a record via the sender, like `byte_reserve`, but gives
+// up with `CHANNEL_TIMEOUT` after `timeout` seconds.
+int byte_reserve_timeout(ByteSender* sender, size_t size, void** data, double timeout);
+
+// Reserves room for a record with a timeout via the channel wrapper, like
+// `byte_reserve_timeout`.
+int byte_reserve_timeout_c(ByteChannel* channel, size_t size, void** data, double timeout);
+
+// Reserves room for a record via the sender, like `byte_reserve`, but gives
+// up with `CHANNEL_TIMEOUT` once the monotonic clock reaches `deadline`, as
+// returned by `channel_deadline`.
+int byte_reserve_deadline(ByteSender* sender, size_t size, void** data, uint64_t deadline);
+
+// Reserves room for a record with a deadline via the channel wrapper, like
+// `byte_reserve_deadline`.
+int byte_reserve_deadline_c(ByteChannel* channel, size_t size, void** data, uint64_t deadline);
+
+// Reserves room for a record via the sender without blocking. If the ring
+// does not have enough room, `CHANNEL_FULL` is returned.
+int byte_try_reserve(ByteSender* sender, size_t size, void** data);
+
+// Reserves room for a record without blocking via the channel wrapper, like
+// `byte_try_reserve`.
+int byte_try_reserve_c(ByteChannel* channel, size_t size, void** data);
+
+// Publishes the record reserved last via the sender, with its final size,
+// which may be smaller than the size reserved but not larger; a larger size
+// is cut down to the size reserved. Nothing happens if no record is reserved.
+void byte_commit(ByteSender* sender, size_t size);
+
+// Publishes the record reserved last via the channel wrapper, like
+// `byte_commit`.
+void byte_commit_c(ByteChannel* channel, size_t size);
+
+// Reads the next record via the receiver, blocking until there is one or the
+// channel is closed, and stores its address in `data` and its size in
+// `size`. The record stays in the ring, and must be handed back with
+// `byte_release` before the next one can be read; until then, reading again
+// yields the same record. The returned value is an error code.
+int byte_read(ByteReceiver* receiver, const void** data, size_t* size);
+
+// Reads the next record via the channel wrapper, like `byte_read`.
+int byte_read_c(ByteChannel* channel, const void** data, size_t* size);
+
+// Reads the next record via the receiver, like `byte_read`, but gives up with
+// `CHANNEL_TIMEOUT` after `timeout` seconds.
+int byte_read_timeout(ByteReceiver* receiver, const void** data, size_t* size, double timeout);
+
+// Reads the next record with a timeout via the channel wrapper, like
+// `byte_read_timeout`.
+int byte_read_timeout_c(ByteChannel* channel, const void** data, size_t* size, double timeout);
+
+// Reads the next record via the receiver, like `byte_read`, but gives up with
+// `CHANNEL_TIMEOUT` once the monotonic clock reaches `deadline`.
+int byte_read_deadline(ByteReceiver* receiver, const void** data, size_t* size, uint64_t deadline);
+
+// Reads the next record with a deadline via the channel wrapper, like
+// `byte_read_deadline`.
+int byte_read_deadline_c(ByteChannel* channel, const void** data, size_t* size, uint64_t deadline);
+
+// Reads the next record via the receiver without blocking. If there is none,
+// `CHANNEL_EMPTY` is returned.
+int byte_try_read(ByteReceiver* receiver, const void** data, size_t* size);
+
+// Reads the next record without blocking via the channel wrapper, like
+// `byte_try_read`.
+int byte_try_read_c(ByteChannel* channel, const void** data, size_t* size);
+
+// Hands the room taken by the record read last back to the sender via the
+// receiver. The record must not be touched afterwards. Nothing happens if no
+// record is held.
+void byte_release(ByteReceiver* receiver);
+
+// Hands the room taken by the record read last back via the channel wrapper,
+// like `byte_release`.
+void byte_release_c(ByteChannel* channel);
+
+// Frees the memory used by the channel, including the sender, receiver, and
+// internal buffer.
+void free_byte_channel(ByteChannel* channel);
+
+// Frees only the memory used by the channel wrapper. The sender, receiver,
+// and internal buffer will remain allocated.
+void free_byte_channel_wrapper(ByteChannel* channel);
+
+// Frees the memory used by the sending half of the channel. If the receiver
+// is still alive, the internal buffer will remain allocated. Freeing the
+// sender closes the channel.
+void free_byte_sender(ByteSender* sender);
+
+// Frees the memory used by the receiving half of the channel. If the sender
+// is still alive, the internal buffer will remain allocated.
+void free_byte_receiver(ByteReceiver* receiver);
+
+// Closes the channel via the sender, without freeing it, like
+// `bounded_close`. The receiver is woken at once, reads every record
+// committed before the channel was closed, and gets `CHANNEL_CLOSED` once it
+// is drained. A record reserved but not yet committed is dropped.
+void byte_close(ByteSender* sender);
+
+// Closes the channel via the channel wrapper, like `byte_close`.
+void byte_close_c(ByteChannel* channel);
+
+#define CHANNEL_SELECT_RENDEZVOUS_SEND 0
+#define CHANNEL_SELECT_RENDEZVOUS_RECV 1
+#define CHANNEL_SELECT_BOUNDED_SEND    2
+#define CHANNEL_SELECT_BOUNDED_RECV    3
+#define CHANNEL_SELECT_UNBOUNDED_SEND  4
+#define CHANNEL_SELECT_UNBOUNDED_RECV  5
+
+// A single send or receive operation in a select. `operation` is one of the
+// `CHANNEL_SELECT_*` constants and `half` points to the matching sender or
+// receiver. For sends, `message` is the message to send; for receives, the
+// received message is stored in `message`. Cases are best created with the
+// `select_*` functions below.
+typedef struct SelectCase_ {
+    int operation;
+    void* half;
+    void* message;
+} SelectCase;
+
+// Creates a select case that sends a message through a rendezvous channel.
+SelectCase select_rendezvous_send(RendezvousSender* sender, void* message);
+
+// Creates a select case that receives a message from a rendezvous channel.
+SelectCase select_rendezvous_recv(RendezvousReceiver* receiver);
+
+// Creates a select case that sends a message through a bounded channel.
+SelectCase select_bounded_send(BoundedSender* sender, void* message);
+
+// Creates a select case that receives a message from a bounded channel.
+SelectCase select_bounded_recv(BoundedReceiver* receiver);
+
+// Creates a select case that sends a message through an unbounded channel.
+// Such a case is always ready.
+SelectCase select_unbounded_send(UnboundedSender* sender, void* message);
+
+// Creates a select case that receives a message from an unbounded channel.
+SelectCase select_unbounded_recv(UnboundedReceiver* receiver);
+
+// Blocks until one of the `count` cases can complete, then completes exactly
+// that one. The index of the completed case is stored in `selected`, which
+// may be NULL. The returned value is the result of the completed operation:
+// `CHANNEL_CLOSED` counts as completing, so a closed channel is always ready.
+// When several cases are ready, one is picked at random, so no channel is
+// starved. A rendezvous send case only becomes ready once the receiver is
+// waiting for a message.
+//
+// While blocked, the calling thread is registered with the wait queue of
+// every channel involved and parked, so waiting costs no CPU.
+int channel_select(SelectCase* cases, size_t count, size_t* selected);
+
+// Completes one of the cases that can complete without blocking, like
+// `channel_select`. If no case is ready, `CHANNEL_EMPTY` is returned.
+int channel_try_select(SelectCase* cases, size_t count, size_t* selected);
+
+// Completes one of the cases, like `channel_select`, but returns
+// `CHANNEL_TIMEOUT` if none becomes ready within `timeout` seconds.
+int channel_select_timeout(SelectCase* cases, size_t count, size_t* selected, double timeout);
+
+// Completes one of the cases, like `channel_select_timeout`, but with an
+// absolute deadline on the monotonic clock, in nanoseconds.
+int channel_select_deadline(SelectCase* cases, size_t count, size_t* selected, uint64_t deadline);
+
+// Takes a snapshot of the counters of a rendezvous channel. The returned
+// value tells whether the library was built with `CHANNEL_STATS`; if not, the
+// snapshot is all zeros.
+bool rendezvous_channel_stats(RendezvousChannelBuffer* buffer, ChannelStats* stats);
+
+// Takes a snapshot of the counters of a bounded channel, like
+// `rendezvous_channel_stats`.
+bool bounded_channel_stats(BoundedChannelBuffer* buffer, ChannelStats* stats);
+
+// Takes a snapshot of the counters of an unbounded channel, like
+// `rendezvous_channel_stats`.
+bool unbounded_channel_stats(UnboundedChannelBuffer* buffer, ChannelStats* stats);
+
+// Takes a snapshot of the counters of a byte channel, like
+// `rendezvous_channel_stats`. Each record counts as one message.
+bool byte_channel_stats(ByteChannelBuffer* buffer, ChannelStats* stats);
+
+// Takes a snapshot of the counters of the channel a sender or receiver of
+// any kind belongs to, and stores it in `stats`. The returned value tells
+// whether the library was built with `CHANNEL_STATS`.
+#define channel_stats(half, stats) \
+    _Generic((half)->buffer, \
+        RendezvousChannelBuffer*: rendezvous_channel_stats, \
+        BoundedChannelBuffer*: bounded_channel_stats, \
+        UnboundedChannelBuffer*: unbounded_channel_stats, \
+        ByteChannelBuffer*: byte_channel_stats)((half)->buffer, stats)
+
+// Takes a snapshot of the latency histogram of a bounded channel. If the
+// channel was not created with `trace_latency`, `false` is returned and the
+// snapshot is empty.
+bool bounded_channel_latency(BoundedChannelBuffer* buffer, ChannelLatency* latency);
+
+// Takes a snapshot of the latency histogram of an unbounded channel, like
+// `bounded_channel_latency`.
+bool unbounded_channel_latency(UnboundedChannelBuffer* buffer, ChannelLatency* latency);
+
+// Empties the latency histogram of a bounded channel. Messages received
+// while the histogram is being reset may be partly counted.
+void bounded_channel_latency_reset(BoundedChannelBuffer* buffer);
+
+// Empties the latency histogram of an unbounded channel, like
+// `bounded_channel_latency_reset`.
+void unbounded_channel_latency_reset(UnboundedChannelBuffer* buffer);
+
+// Takes a snapshot of the latency histogram of the channel a bounded or
+// unbounded sender or receiver belongs to, and stores it in `latency`. The
+// returned value tells whether the channel traces latencies.
+#define channel_latency(half, latency) \
+    _Generic((half)->buffer, \
+        BoundedChannelBuffer*: bounded_channel_latency, \
+        UnboundedChannelBuffer*: unbounded_channel_latency)((half)->buffer, latency)
+
+// Empties the latency histogram of the channel a bounded or unbounded sender
+// or receiver belongs to.
+#define channel_latency_reset(half) \
+    _Generic((half)->buffer, \
+        BoundedChannelBuffer*: bounded_channel_latency_reset, \
+        UnboundedChannelBuffer*: unbounded_channel_latency_reset)((half)->buffer)
+
+// Returns the smallest latency, in nanoseconds, that falls in the given
+// bucket of a latency histogram.
+uint64_t channel_latency_bucket_min(size_t bucket);
+
+// Returns the latency, in nanoseconds, below which the given percentage of
+// the latencies in a histogram snapshot fall, rounded up to the end of its
+// bucket but never above `max_ns`. An empty snapshot yields zero.
+uint64_t channel_latency_percentile(const ChannelLatency* latency, double percentile);
+
+// Returns a file descriptor that becomes readable when the bounded channel
+// goes from empty to non-empty or is closed, so that the channel can be
+// waited on with epoll, poll or select alongside other descriptors. The
+// descriptor is created by the first call, starts out readable, and belongs
+// to the receiving side of the channel: cloned receivers share it, and it is
+// closed when the channel is freed. Only the transition is signaled, so once
+// the descriptor is readable, messages must be received with
+// `bounded_try_recv`, or with a zero timeout, until `CHANNEL_EMPTY` or
+// `CHANNEL_TIMEOUT` is returned; that result is what makes the descriptor
+// wait for the next transition. Readiness may be spurious. -1 is returned
+// where eventfd is not available, which is everywhere but Linux.
+int bounded_receiver_fd(BoundedReceiver* receiver);
+
+// Returns a file descriptor that becomes readable when the unbounded channel
+// goes from empty to non-empty or is closed, like `bounded_receiver_fd`.
+int unbounded_receiver_fd(UnboundedReceiver* receiver);
+
+// Returns the file descriptor of a bounded or unbounded receiver, like
+// `bounded_receiver_fd`.
+#define channel_receiver_fd(receiver) \
+    _Generic((receiver)->buffer, \
+        BoundedChannelBuffer*: bounded_receiver_fd, \
+        UnboundedChannelBuffer*: unbounded_receiver_fd)(receiver)
+
+// Closes a rendezvous, bounded, unbounded or byte channel on behalf of every
+// sender, like `bounded_close`.
+#define channel_close(sender) \
+    _Generic((sender)->buffer, \
+        RendezvousChannelBuffer*: rendezvous_close, \
+        BoundedChannelBuffer*: bounded_close, \
+        UnboundedChannelBuffer*: unbounded_close, \
+        ByteChannelBuffer*: byte_close)(sender)
+
+// Defining `CHANNEL_HEADER_ONLY` compiles the uncontended cases of the most
+// common bounded and unbounded operations into the caller. See
+// `channel_inline.h` for details.
+#ifdef CHANNEL_HEADER_ONLY
+#  include "channel_inline.h"
+#endif
+
 #endif // CHANNEL_H
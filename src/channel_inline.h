@@ -0,0 +1,486 @@
+#ifndef CHANNEL_INLINE_H
+#define CHANNEL_INLINE_H
+
+#include "channel.h"
+#include "mutex.h"
+#include "park.h"
+
+// Inline fast paths for sending and receiving single messages through
+// bounded and unbounded channels. Each fast path makes one attempt that only
+// succeeds when the operation is uncontended and needs no waiting: a free
+// slot, an available message, a free mutex. Anything else falls back to
+// the regular functions in the library, which handle blocking, timeouts and
+// closed channels. The behaviour is therefore exactly that of the regular
+// functions, only the common case is compiled into the caller.
+//
+// The functions are available under their own names once this header is
+// included. Defining `CHANNEL_HEADER_ONLY` before including `channel.h`
+// includes this header and also redirects calls to `bounded_send`,
+// `bounded_recv`, `unbounded_send`, `unbounded_recv`, their `try` and `_c`
+// variants to the inline versions. Taking the address of one of those
+// functions still yields the library function.
+//
+// The fast paths do no counting, so they are turned off when `CHANNEL_STATS`
+// is defined, and every operation goes through the library. Code including
+// this header must then define it too, or its operations go uncounted.
+// Likewise, channels that trace latency always go through the library.
+
+// The fast paths are forced inline, since leaving the inlining decision to
+// the compiler would defeat their purpose at call sites it deems cold.
+#if defined(__GNUC__) || defined(__clang__)
+#  define CHANNEL_INLINE static inline __attribute__((always_inline))
+#else
+#  define CHANNEL_INLINE static inline
+#endif
+
+#ifdef CHANNEL_STATS
+#  define CHANNEL_INLINE_FAST_PATHS 0
+#else
+#  define CHANNEL_INLINE_FAST_PATHS 1
+#endif
+
+// Takes the mutex of a channel buffer without calling into the library, if
+// it is free. Otherwise `false` is returned, and the caller falls back to the
+// library, which waits for the mutex.
+CHANNEL_INLINE bool channel_inline_lock(Mutex* mutex)
+{
+    if (mutex->kind == CHANNEL_LOCK_SPIN) {
+        unsigned ticket = atomic_load_explicit(&mutex->now_serving, memory_order_acquire);
+
+        return atomic_compare_exchange_strong_explicit(
+            &mutex->next_ticket, &ticket, ticket + 1,
+            memory_order_acquire, memory_order_relaxed);
+    }
+
+#ifdef _WIN32
+    return WaitForSingleObject(mutex->lock, 0) == WAIT_OBJECT_0;
+#else
+    return pthread_mutex_trylock(&mutex->lock) == 0;
+#endif
+}
+
+// Releases the mutex of a channel buffer without calling into the library.
+// Releasing a mutex held by the calling thread cannot fail, and the operation
+// done under it must not be repeated by a fallback anyway.
+CHANNEL_INLINE void channel_inline_release(Mutex* mutex)
+{
+    if (mutex->kind == CHANNEL_LOCK_SPIN) {
+        unsigned serving = atomic_load_explicit(&mutex->now_serving, memory_order_relaxed);
+        atomic_store_explicit(&mutex->now_serving, serving + 1, memory_order_release);
+        return;
+    }
+
+#ifdef _WIN32
+    ReleaseMutex(mutex->lock);
+#else
+    pthread_mutex_unlock(&mutex->lock);
+#endif
+}
+
+// Wakes up to `count` waiters of a wait queue. Only the check for waiters is
+// inlined, since a queue with waiters means a slow path anyway.
+CHANNEL_INLINE void channel_inline_notify(WaitQueue* queue, size_t count)
+{
+    atomic_thread_fence(memory_order_seq_cst);
+
+    if (atomic_load_explicit(&queue->length, memory_order_relaxed) != 0) {
+        wait_queue_notify_many(queue, count);
+    }
+}
+
+// Maps a position in the ring of a bounded channel to a slot index.
+CHANNEL_INLINE size_t channel_inline_bounded_index(const BoundedChannelBuffer* buffer, size_t position)
+{
+    if (buffer->power_of_two) {
+        return position & (buffer->capacity - 1);
+    }
+
+    return position % buffer->capacity;
+}
+
+// Makes a single attempt to push a message into a bounded channel. If `false`
+// is returned, nothing was sent.
+CHANNEL_INLINE bool bounded_inline_push(BoundedChannelBuffer* buffer, void* message)
+{
+    if (!CHANNEL_INLINE_FAST_PATHS || buffer->latency != NULL) {
+        return false;
+    }
+
+    if (buffer->single_producer) {
+        if (atomic_load(&buffer->state) & CHANNEL_STATE_CLOSED) {
+            return false;
+        }
+
+        size_t tail = atomic_load_explicit(&buffer->tail, memory_order_relaxed);
+
+        if (tail - buffer->cached_head == buffer->capacity) {
+            buffer->cached_head = atomic_load_explicit(&buffer->head, memory_order_acquire);
+
+            if (tail - buffer->cached_head == buffer->capacity) {
+                return false;
+            }
+        }
+
+        buffer->messages[channel_inline_bounded_index(buffer, tail)] = message;
+        atomic_store_explicit(&buffer->tail, tail + 1, memory_order_release);
+    }
+    else if (buffer->lockfree) {
+        if (atomic_load(&buffer->state) & CHANNEL_STATE_CLOSED) {
+            return false;
+        }
+
+        size_t position = atomic_load_explicit(&buffer->tail, memory_order_relaxed);
+        BoundedSlot* slot = &buffer->slots[channel_inline_bounded_index(buffer, position)];
+
+        if ((position & CHANNEL_TAIL_CLOSED)
+            || atomic_load_explicit(&slot->sequence, memory_order_acquire) != 2 * position
+            || !atomic_compare_exchange_strong_explicit(
+                &buffer->tail, &position, position + 1,
+                memory_order_relaxed, memory_order_relaxed)) {
+            return false;
+        }
+
+        slot->message = message;
+        atomic_store_explicit(&slot->sequence, 2 * position + 1, memory_order_release);
+    }
+    else {
+        if (!channel_inline_lock(&buffer->mutex)) {
+            return false;
+        }
+
+        bool pushed = buffer->size < buffer->capacity && !(atomic_load(&buffer->state) & CHANNEL_STATE_CLOSED);
+
+        if (pushed) {
+            size_t tail = channel_inline_bounded_index(buffer, buffer->head_offset + buffer->size);
+            buffer->messages[tail] = message;
+            buffer->size++;
+        }
+
+        channel_inline_release(&buffer->mutex);
+
+        if (!pushed) {
+            return false;
+        }
+    }
+
+    channel_inline_notify(&buffer->recv_waiters, 1);
+
+    return true;
+}
+
+// Makes a single attempt to pop a message from a bounded channel. If `false`
+// is returned, nothing was received.
+CHANNEL_INLINE bool bounded_inline_pop(BoundedChannelBuffer* buffer, void** message)
+{
+    if (!CHANNEL_INLINE_FAST_PATHS || buffer->latency != NULL) {
+        return false;
+    }
+
+    if (buffer->single_producer) {
+        size_t head = atomic_load_explicit(&buffer->head, memory_order_relaxed);
+
+        if (buffer->cached_tail == head) {
+            buffer->cached_tail = atomic_load_explicit(&buffer->tail, memory_order_acquire);
+
+            if (buffer->cached_tail == head) {
+                return false;
+            }
+        }
+
+        *message = buffer->messages[channel_inline_bounded_index(buffer, head)];
+        atomic_store_explicit(&buffer->head, head + 1, memory_order_release);
+    }
+    else if (buffer->lockfree) {
+        size_t position = atomic_load_explicit(&buffer->head, memory_order_relaxed);
+        BoundedSlot* slot = &buffer->slots[channel_inline_bounded_index(buffer, position)];
+
+        if (atomic_load_explicit(&slot->sequence, memory_order_acquire) != 2 * position + 1) {
+            return false;
+        }
+
+        if (!buffer->multi_consumer) {
+            atomic_store_explicit(&buffer->head, position + 1, memory_order_relaxed);
+        }
+        else if (!atomic_compare_exchange_strong_explicit(
+                     &buffer->head, &position, position + 1,
+                     memory_order_relaxed, memory_order_relaxed)) {
+            return false;
+        }
+
+        *message = slot->message;
+        atomic_store_explicit(&slot->sequence, 2 * (position + buffer->capacity), memory_order_release);
+    }
+    else {
+        if (!channel_inline_lock(&buffer->mutex)) {
+            return false;
+        }
+
+        bool popped = buffer->size > 0;
+
+        if (popped) {
+            *message = buffer->messages[buffer->head_offset];
+            buffer->head_offset = channel_inline_bounded_index(buffer, buffer->head_offset + 1);
+            buffer->size--;
+        }
+
+        channel_inline_release(&buffer->mutex);
+
+        if (!popped) {
+            return false;
+        }
+    }
+
+    channel_inline_notify(&buffer->send_waiters, 1);
+
+    return true;
+}
+
+// Makes a single attempt to push a message into an unbounded channel. If
+// `false` is returned, nothing was sent.
+CHANNEL_INLINE bool unbounded_inline_push(UnboundedSender* sender, void* message)
+{
+    UnboundedChannelBuffer* buffer = sender->buffer;
+
+    if (!CHANNEL_INLINE_FAST_PATHS
+        || buffer->latency != NULL
+        || (atomic_load(&buffer->state) & CHANNEL_STATE_CLOSED)) {
+        return false;
+    }
+
+    if (buffer->lockfree) {
+        size_t tail = atomic_load_explicit(&buffer->tail, memory_order_acquire);
+        UnboundedBlock* block = atomic_load_explicit(&buffer->tail_block, memory_order_acquire);
+        size_t offset = tail % UNBOUNDED_BLOCK_LAP;
+
+        // The last slot of a block comes with installing the next block, and
+        // a closed channel with failing, both of which are left to the
+        // library.
+        if ((tail & CHANNEL_TAIL_CLOSED)
+            || offset + 1 >= UNBOUNDED_BLOCK_CAPACITY
+            || !atomic_compare_exchange_strong_explicit(
+                &buffer->tail, &tail, tail + 1,
+                memory_order_seq_cst, memory_order_relaxed)) {
+            return false;
+        }
+
+        UnboundedSlot* slot = &block->slots[offset];
+        slot->message = message;
+        atomic_store_explicit(&slot->ready, true, memory_order_release);
+    }
+    else {
+        // Only a node from the cache of the sender is used here. Refilling
+        // the cache or allocating a node is left to the library.
+        UnboundedNodeCache* cache = &sender->nodes;
+
+        if (atomic_flag_test_and_set_explicit(&cache->busy, memory_order_acquire)) {
+            return false;
+        }
+
+        UnboundedMessage* node = cache->first;
+
+        if (node == NULL || !channel_inline_lock(&buffer->mutex)) {
+            atomic_flag_clear_explicit(&cache->busy, memory_order_release);
+            return false;
+        }
+
+        bool pushed = !(atomic_load(&buffer->state) & CHANNEL_STATE_CLOSED);
+
+        if (pushed) {
+            cache->first = node->next;
+            node->message = message;
+            node->next = NULL;
+
+            if (buffer->last_message != NULL) {
+                buffer->last_message->next = node;
+            }
+            else {
+                buffer->first_message = node;
+            }
+
+            buffer->last_message = node;
+            buffer->size++;
+        }
+
+        channel_inline_release(&buffer->mutex);
+        atomic_flag_clear_explicit(&cache->busy, memory_order_release);
+
+        if (!pushed) {
+            return false;
+        }
+    }
+
+    channel_inline_notify(&buffer->recv_waiters, 1);
+
+    return true;
+}
+
+// Makes a single attempt to pop a message from an unbounded channel. If
+// `false` is returned, nothing was received.
+CHANNEL_INLINE bool unbounded_inline_pop(UnboundedReceiver* receiver, void** message)
+{
+    UnboundedChannelBuffer* buffer = receiver->buffer;
+
+    if (!CHANNEL_INLINE_FAST_PATHS || buffer->latency != NULL) {
+        return false;
+    }
+
+    if (buffer->lockfree) {
+        size_t offset = buffer->head % UNBOUNDED_BLOCK_LAP;
+        UnboundedSlot* slot = &buffer->head_block->slots[offset];
+
+        // Reading the last slot of a block retires the block, which is left to
+        // the library.
+        if (offset + 1 >= UNBOUNDED_BLOCK_CAPACITY
+            || !atomic_load_explicit(&slot->ready, memory_order_acquire)) {
+            return false;
+        }
+
+        *message = slot->message;
+        atomic_store_explicit(&slot->ready, false, memory_order_relaxed);
+        buffer->head++;
+
+        return true;
+    }
+
+    // The node goes to the cache of the receiver. Passing a full batch on to
+    // the senders is left to the library.
+    UnboundedNodeCache* cache = &receiver->nodes;
+
+    if (atomic_flag_test_and_set_explicit(&cache->busy, memory_order_acquire)) {
+        return false;
+    }
+
+    if (cache->count + 1 >= UNBOUNDED_NODE_BATCH || !channel_inline_lock(&buffer->mutex)) {
+        atomic_flag_clear_explicit(&cache->busy, memory_order_release);
+        return false;
+    }
+
+    UnboundedMessage* node = buffer->first_message;
+
+    if (node != NULL) {
+        buffer->first_message = node->next;
+        buffer->size--;
+
+        if (buffer->first_message == NULL) {
+            buffer->last_message = NULL;
+        }
+    }
+
+    channel_inline_release(&buffer->mutex);
+
+    if (node != NULL) {
+        *message = node->message;
+        node->next = cache->first;
+        cache->first = node;
+        cache->count++;
+    }
+
+    atomic_flag_clear_explicit(&cache->busy, memory_order_release);
+
+    return node != NULL;
+}
+
+// Sends a message like `bounded_send`, inlining the uncontended case.
+CHANNEL_INLINE int bounded_send_inline(BoundedSender* sender, void* message)
+{
+    if (bounded_inline_push(sender->buffer, message)) {
+        return CHANNEL_SUCCESS;
+    }
+
+    return bounded_send(sender, message);
+}
+
+// Receives a message like `bounded_recv`, inlining the uncontended case.
+CHANNEL_INLINE void* bounded_recv_inline(BoundedReceiver* receiver)
+{
+    void* message;
+
+    if (bounded_inline_pop(receiver->buffer, &message)) {
+        return message;
+    }
+
+    return bounded_recv(receiver);
+}
+
+// Sends a message like `bounded_try_send`, inlining the uncontended case.
+CHANNEL_INLINE int bounded_try_send_inline(BoundedSender* sender, void* message)
+{
+    if (bounded_inline_push(sender->buffer, message)) {
+        return CHANNEL_SUCCESS;
+    }
+
+    return bounded_try_send(sender, message);
+}
+
+// Receives a message like `bounded_try_recv`, inlining the uncontended case.
+CHANNEL_INLINE int bounded_try_recv_inline(BoundedReceiver* receiver, void** message)
+{
+    if (bounded_inline_pop(receiver->buffer, message)) {
+        return CHANNEL_SUCCESS;
+    }
+
+    return bounded_try_recv(receiver, message);
+}
+
+// Sends a message like `unbounded_send`, inlining the uncontended case.
+CHANNEL_INLINE int unbounded_send_inline(UnboundedSender* sender, void* message)
+{
+    if (unbounded_inline_push(sender, message)) {
+        return CHANNEL_SUCCESS;
+    }
+
+    return unbounded_send(sender, message);
+}
+
+// Receives a message like `unbounded_recv`, inlining the uncontended case.
+CHANNEL_INLINE void* unbounded_recv_inline(UnboundedReceiver* receiver)
+{
+    void* message;
+
+    if (unbounded_inline_pop(receiver, &message)) {
+        return message;
+    }
+
+    return unbounded_recv(receiver);
+}
+
+// Sends a message like `unbounded_try_send`, inlining the uncontended case.
+CHANNEL_INLINE int unbounded_try_send_inline(UnboundedSender* sender, void* message)
+{
+    if (unbounded_inline_push(sender, message)) {
+        return CHANNEL_SUCCESS;
+    }
+
+    return unbounded_try_send(sender, message);
+}
+
+// Receives a message like `unbounded_try_recv`, inlining the uncontended case.
+CHANNEL_INLINE int unbounded_try_recv_inline(UnboundedReceiver* receiver, void** message)
+{
+    if (unbounded_inline_pop(receiver, message)) {
+        return CHANNEL_SUCCESS;
+    }
+
+    return unbounded_try_recv(receiver, message);
+}
+
+#ifdef CHANNEL_HEADER_ONLY
+#  define bounded_send(sender, message) bounded_send_inline(sender, message)
+#  define bounded_send_c(channel, message) bounded_send_inline((channel)->sender, message)
+#  define bounded_recv(receiver) bounded_recv_inline(receiver)
+#  define bounded_recv_c(channel) bounded_recv_inline((channel)->receiver)
+#  define bounded_try_send(sender, message) bounded_try_send_inline(sender, message)
+#  define bounded_try_send_c(channel, message) bounded_try_send_inline((channel)->sender, message)
+#  define bounded_try_recv(receiver, message) bounded_try_recv_inline(receiver, message)
+#  define bounded_try_recv_c(channel, message) bounded_try_recv_inline((channel)->receiver, message)
+#  define unbounded_send(sender, message) unbounded_send_inline(sender, message)
+#  define unbounded_send_c(channel, message) unbounded_send_inline((channel)->sender, message)
+#  define unbounded_recv(receiver) unbounded_recv_inline(receiver)
+#  define unbounded_recv_c(channel) unbounded_recv_inline((channel)->receiver)
+#  define unbounded_try_send(sender, message) unbounded_try_send_inline(sender, message)
+#  define unbounded_try_send_c(channel, message) unbounded_try_send_inline((channel)->sender, message)
+#  define unbounded_try_recv(receiver, message) unbounded_try_recv_inline(receiver, message)
+#  define unbounded_try_recv_c(channel, message) unbounded_try_recv_inline((channel)->receiver, message)
+#endif
+
+#endif // CHANNEL_INLINE_H
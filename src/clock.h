@@ -0,0 +1,16 @@
+#ifndef CHANNEL_CLOCK_H
+#define CHANNEL_CLOCK_H
+
+#include <stdint.h>
+
+// The deadline that never passes.
+#define CHANNEL_NO_DEADLINE UINT64_MAX
+
+// Returns the current time of the monotonic clock, in nanoseconds.
+uint64_t channel_now(void);
+
+// Returns the monotonic time the provided number of seconds from now, in
+// nanoseconds. Negative timeouts are treated as zero.
+uint64_t channel_deadline(double seconds);
+
+#endif // CHANNEL_CLOCK_H
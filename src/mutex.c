@@ -1,20 +1,72 @@
+#ifndef _GNU_SOURCE
+#  define _GNU_SOURCE
+#endif
+
 #include "mutex.h"
 #include "util.h"
 
-Mutex* new_mutex(void)
+// The number of times a thread waiting for a ticket spinlock polls it before
+// it starts yielding its time slice to the holder.
+#define MUTEX_SPIN_LIMIT 128
+
+void mutex_init(Mutex* mutex, int kind)
 {
-    Mutex* mutex = NEW(Mutex);
+    mutex->kind = kind == CHANNEL_LOCK_SPIN || kind == CHANNEL_LOCK_ADAPTIVE ? kind : CHANNEL_LOCK_DEFAULT;
+    atomic_init(&mutex->next_ticket, 0);
+    atomic_init(&mutex->now_serving, 0);
 #ifdef _WIN32
     mutex->lock = CreateMutex(NULL, FALSE, NULL);
 #else
-    pthread_mutex_init(&mutex->lock, NULL);
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+#  ifdef PTHREAD_ADAPTIVE_MUTEX_INITIALIZER_NP
+    if (mutex->kind == CHANNEL_LOCK_ADAPTIVE) {
+        pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_ADAPTIVE_NP);
+    }
+#  endif
+    pthread_mutex_init(&mutex->lock, &attr);
+    pthread_mutexattr_destroy(&attr);
+#endif
+}
+
+void mutex_destroy(Mutex* mutex)
+{
+#ifdef _WIN32
+    CloseHandle(mutex->lock);
+#else
+    pthread_mutex_destroy(&mutex->lock);
 #endif
+}
+
+Mutex* new_mutex(void)
+{
+    Mutex* mutex = NEW(Mutex);
+    mutex_init(mutex, CHANNEL_LOCK_DEFAULT);
 
     return mutex;
 }
 
 int mutex_lock(Mutex* mutex)
 {
+    if (mutex->kind == CHANNEL_LOCK_SPIN) {
+        unsigned ticket = atomic_fetch_add_explicit(&mutex->next_ticket, 1, memory_order_relaxed);
+
+        for (unsigned spins = 0;
+             atomic_load_explicit(&mutex->now_serving, memory_order_acquire) != ticket;
+             spins++) {
+            // Yielding keeps a preempted holder from being starved by the
+            // threads waiting for it.
+            if (spins < MUTEX_SPIN_LIMIT) {
+                channel_pause();
+            }
+            else {
+                channel_yield();
+            }
+        }
+
+        return CHANNEL_MUTEX_SUCCESS;
+    }
+
 #ifdef _WIN32
     if (WaitForSingleObject(mutex->lock, INFINITE) == WAIT_OBJECT_0) {
         return CHANNEL_MUTEX_SUCCESS;
@@ -32,8 +84,36 @@ int mutex_lock(Mutex* mutex)
 #endif
 }
 
+bool mutex_try_lock(Mutex* mutex)
+{
+    if (mutex->kind == CHANNEL_LOCK_SPIN) {
+        unsigned ticket = atomic_load_explicit(&mutex->now_serving, memory_order_acquire);
+
+        // A ticket can only be taken without waiting if it is the one being
+        // served.
+        return atomic_compare_exchange_strong_explicit(
+            &mutex->next_ticket, &ticket, ticket + 1,
+            memory_order_acquire, memory_order_relaxed);
+    }
+
+#ifdef _WIN32
+    return WaitForSingleObject(mutex->lock, 0) == WAIT_OBJECT_0;
+#else
+    return pthread_mutex_trylock(&mutex->lock) == 0;
+#endif
+}
+
 int mutex_release(Mutex* mutex)
 {
+    if (mutex->kind == CHANNEL_LOCK_SPIN) {
+        // Only the holder writes `now_serving`, so no read-modify-write is
+        // needed.
+        unsigned serving = atomic_load_explicit(&mutex->now_serving, memory_order_relaxed);
+        atomic_store_explicit(&mutex->now_serving, serving + 1, memory_order_release);
+
+        return CHANNEL_MUTEX_SUCCESS;
+    }
+
 #ifdef _WIN32
     if (ReleaseMutex(mutex->lock)) {
         return CHANNEL_MUTEX_SUCCESS;
@@ -53,11 +133,6 @@ int mutex_release(Mutex* mutex)
 
 void free_mutex(Mutex* mutex)
 {
-#ifdef _WIN32
-    CloseHandle(mutex->lock);
-#else
-    pthread_mutex_destroy(&mutex->lock);
-#endif
-
+    mutex_destroy(mutex);
     free(mutex);
 }
@@ -1,6 +1,9 @@
 #ifndef CHANNEL_MUTEX_H
 #define CHANNEL_MUTEX_H
 
+#include <stdatomic.h>
+#include <stdbool.h>
+
 #ifdef _WIN32
 #  include <Windows.h>
 #else
@@ -10,7 +13,21 @@
 #define CHANNEL_MUTEX_SUCCESS 0
 #define CHANNEL_MUTEX_FAILURE 1
 
+// The lock backends a mutex can use. `CHANNEL_LOCK_DEFAULT` is the operating
+// system mutex. `CHANNEL_LOCK_SPIN` is a ticket spinlock, which hands the lock
+// to waiting threads in arrival order and never enters the kernel; it suits
+// critical sections of a few instructions, as long as there are not many
+// more contending threads than cores. `CHANNEL_LOCK_ADAPTIVE` is a mutex that
+// spins briefly before sleeping, `PTHREAD_MUTEX_ADAPTIVE_NP` on glibc, and
+// the default mutex where that is not available.
+#define CHANNEL_LOCK_DEFAULT  0
+#define CHANNEL_LOCK_SPIN     1
+#define CHANNEL_LOCK_ADAPTIVE 2
+
 typedef struct Mutex_ {
+    int kind;
+    atomic_uint next_ticket;
+    atomic_uint now_serving;
 #ifdef _WIN32
     HANDLE lock;
 #else
@@ -18,12 +35,23 @@ typedef struct Mutex_ {
 #endif
 } Mutex;
 
+// Initializes a mutex in place, using one of the `CHANNEL_LOCK_*` backends.
+// Unknown backends are treated as `CHANNEL_LOCK_DEFAULT`.
+void mutex_init(Mutex* mutex, int kind);
+
+// Releases any resources held by a mutex initialized with `mutex_init`.
+void mutex_destroy(Mutex* mutex);
+
 // Creates a new mutex object.
 Mutex* new_mutex(void);
 
 // Gets a lock on the mutex.
 int mutex_lock(Mutex* mutex);
 
+// Gets a lock on the mutex if it is free, without waiting. The returned
+// value tells whether the lock was taken.
+bool mutex_try_lock(Mutex* mutex);
+
 // Releases a lock on the mutex.
 int mutex_release(Mutex* mutex);
 
@@ -0,0 +1,367 @@
+#include "park.h"
+#include "mutex.h"
+#include "util.h"
+
+#ifdef __linux__
+#  include <linux/futex.h>
+#  include <sys/syscall.h>
+#  include <time.h>
+#  include <unistd.h>
+#elif !defined(_WIN32)
+#  include <errno.h>
+#  include <time.h>
+#endif
+
+#define PARKER_PARKED   -1
+#define PARKER_EMPTY     0
+#define PARKER_NOTIFIED  1
+
+#ifdef __linux__
+// Blocks while `*address == expected`, or until woken or the deadline passes.
+static void futex_wait(atomic_int* address, int expected, uint64_t deadline)
+{
+    if (deadline == CHANNEL_NO_DEADLINE) {
+        syscall(SYS_futex, address, FUTEX_WAIT_PRIVATE, expected, NULL, NULL, 0);
+    }
+    else {
+        // The bitset variant takes an absolute time on the monotonic clock.
+        struct timespec ts;
+        ts.tv_sec = (time_t)(deadline / 1000000000);
+        ts.tv_nsec = (long)(deadline % 1000000000);
+        syscall(
+            SYS_futex, address, FUTEX_WAIT_BITSET_PRIVATE, expected, &ts, NULL,
+            FUTEX_BITSET_MATCH_ANY);
+    }
+}
+
+// Wakes one thread blocked on the address.
+static void futex_wake(atomic_int* address)
+{
+    syscall(SYS_futex, address, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+}
+#endif
+
+void parker_init(Parker* parker)
+{
+    atomic_init(&parker->state, PARKER_EMPTY);
+#ifdef _WIN32
+    InitializeSRWLock(&parker->lock);
+    InitializeConditionVariable(&parker->cond);
+#elif !defined(__linux__)
+    pthread_mutex_init(&parker->lock, NULL);
+#  ifdef __APPLE__
+    pthread_cond_init(&parker->cond, NULL);
+#  else
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&parker->cond, &attr);
+    pthread_condattr_destroy(&attr);
+#  endif
+#endif
+}
+
+void parker_park(Parker* parker)
+{
+    parker_park_until(parker, CHANNEL_NO_DEADLINE);
+}
+
+bool parker_park_until(Parker* parker, uint64_t deadline)
+{
+#ifdef __linux__
+    // Consume the token if one is present, otherwise announce that we are
+    // about to sleep.
+    if (atomic_fetch_sub(&parker->state, 1) == PARKER_NOTIFIED) {
+        return true;
+    }
+
+    while (deadline == CHANNEL_NO_DEADLINE || channel_now() < deadline) {
+        futex_wait(&parker->state, PARKER_PARKED, deadline);
+
+        int notified = PARKER_NOTIFIED;
+
+        if (atomic_compare_exchange_strong(&parker->state, &notified, PARKER_EMPTY)) {
+            return true;
+        }
+    }
+
+    // An unpark may have raced with the deadline.
+    return atomic_exchange(&parker->state, PARKER_EMPTY) == PARKER_NOTIFIED;
+#elif defined(_WIN32)
+    AcquireSRWLockExclusive(&parker->lock);
+
+    while (atomic_load(&parker->state) != PARKER_NOTIFIED) {
+        DWORD milliseconds = INFINITE;
+
+        if (deadline != CHANNEL_NO_DEADLINE) {
+            uint64_t now = channel_now();
+
+            if (now >= deadline) {
+                break;
+            }
+
+            milliseconds = (DWORD)((deadline - now + 999999) / 1000000);
+        }
+
+        SleepConditionVariableSRW(&parker->cond, &parker->lock, milliseconds, 0);
+    }
+
+    bool notified = atomic_exchange(&parker->state, PARKER_EMPTY) == PARKER_NOTIFIED;
+    ReleaseSRWLockExclusive(&parker->lock);
+
+    return notified;
+#else
+    pthread_mutex_lock(&parker->lock);
+
+    while (atomic_load(&parker->state) != PARKER_NOTIFIED) {
+        if (deadline == CHANNEL_NO_DEADLINE) {
+            pthread_cond_wait(&parker->cond, &parker->lock);
+            continue;
+        }
+
+        uint64_t now = channel_now();
+
+        if (now >= deadline) {
+            break;
+        }
+
+        struct timespec ts;
+#  ifdef __APPLE__
+        ts.tv_sec = (time_t)((deadline - now) / 1000000000);
+        ts.tv_nsec = (long)((deadline - now) % 1000000000);
+        pthread_cond_timedwait_relative_np(&parker->cond, &parker->lock, &ts);
+#  else
+        ts.tv_sec = (time_t)(deadline / 1000000000);
+        ts.tv_nsec = (long)(deadline % 1000000000);
+        pthread_cond_timedwait(&parker->cond, &parker->lock, &ts);
+#  endif
+    }
+
+    bool notified = atomic_exchange(&parker->state, PARKER_EMPTY) == PARKER_NOTIFIED;
+    pthread_mutex_unlock(&parker->lock);
+
+    return notified;
+#endif
+}
+
+void parker_unpark(Parker* parker)
+{
+#ifdef __linux__
+    if (atomic_exchange(&parker->state, PARKER_NOTIFIED) == PARKER_PARKED) {
+        futex_wake(&parker->state);
+    }
+#elif defined(_WIN32)
+    AcquireSRWLockExclusive(&parker->lock);
+    atomic_store(&parker->state, PARKER_NOTIFIED);
+    WakeConditionVariable(&parker->cond);
+    ReleaseSRWLockExclusive(&parker->lock);
+#else
+    pthread_mutex_lock(&parker->lock);
+    atomic_store(&parker->state, PARKER_NOTIFIED);
+    pthread_cond_signal(&parker->cond);
+    pthread_mutex_unlock(&parker->lock);
+#endif
+}
+
+void parker_destroy(Parker* parker)
+{
+#if !defined(_WIN32) && !defined(__linux__)
+    pthread_mutex_destroy(&parker->lock);
+    pthread_cond_destroy(&parker->cond);
+#else
+    (void)parker;
+#endif
+}
+
+void wait_queue_init(WaitQueue* queue)
+{
+    atomic_init(&queue->length, 0);
+    mutex_init(&queue->mutex, CHANNEL_LOCK_DEFAULT);
+    queue->head = NULL;
+    queue->tail = NULL;
+    queue->event_fd = -1;
+    queue->event_armed = false;
+}
+
+// Unlinks a waiter from the queue. The queue mutex must be held.
+static void wait_queue_unlink(WaitQueue* queue, Waiter* waiter)
+{
+    if (waiter->prev != NULL) {
+        waiter->prev->next = waiter->next;
+    }
+    else {
+        queue->head = waiter->next;
+    }
+
+    if (waiter->next != NULL) {
+        waiter->next->prev = waiter->prev;
+    }
+    else {
+        queue->tail = waiter->prev;
+    }
+
+    waiter->prev = NULL;
+    waiter->next = NULL;
+    waiter->queued = false;
+    atomic_fetch_sub(&queue->length, 1);
+}
+
+void wait_queue_register(WaitQueue* queue, Waiter* waiter)
+{
+    mutex_lock(&queue->mutex);
+
+    waiter->prev = queue->tail;
+    waiter->next = NULL;
+    waiter->queued = true;
+
+    if (queue->tail != NULL) {
+        queue->tail->next = waiter;
+    }
+    else {
+        queue->head = waiter;
+    }
+
+    queue->tail = waiter;
+    atomic_fetch_add(&queue->length, 1);
+
+    mutex_release(&queue->mutex);
+
+    // Order the registration before the caller rechecks its condition.
+    atomic_thread_fence(memory_order_seq_cst);
+}
+
+bool wait_queue_unregister(WaitQueue* queue, Waiter* waiter)
+{
+    // The lock is taken even if the waiter has already been dequeued, so that
+    // a notifier still inside `parker_unpark` is done touching the waiter
+    // before its stack frame goes away.
+    mutex_lock(&queue->mutex);
+
+    bool notified = !waiter->queued;
+
+    if (waiter->queued) {
+        wait_queue_unlink(queue, waiter);
+    }
+
+    mutex_release(&queue->mutex);
+
+    return notified;
+}
+
+void wait_queue_notify_one(WaitQueue* queue)
+{
+    wait_queue_notify_many(queue, 1);
+}
+
+void wait_queue_notify_many(WaitQueue* queue, size_t count)
+{
+    // Pairs with the fence in `wait_queue_register`, so that a waiter which
+    // registered before rechecking its condition is seen here.
+    atomic_thread_fence(memory_order_seq_cst);
+
+    if (atomic_load_explicit(&queue->length, memory_order_relaxed) == 0) {
+        return;
+    }
+
+    mutex_lock(&queue->mutex);
+
+    if (queue->event_armed) {
+        queue->event_armed = false;
+        atomic_fetch_sub(&queue->length, 1);
+#ifdef __linux__
+        uint64_t one = 1;
+        ssize_t written = write(queue->event_fd, &one, sizeof(one));
+        (void)written;
+#endif
+    }
+
+    for (size_t i = 0; i < count && queue->head != NULL; i++) {
+        Waiter* waiter = queue->head;
+        wait_queue_unlink(queue, waiter);
+        parker_unpark(waiter->parker);
+    }
+
+    mutex_release(&queue->mutex);
+}
+
+void wait_queue_notify_all(WaitQueue* queue)
+{
+    wait_queue_notify_many(queue, SIZE_MAX);
+}
+
+bool wait_queue_arm_event(WaitQueue* queue, int fd)
+{
+#ifdef __linux__
+    mutex_lock(&queue->mutex);
+
+    bool armed = !queue->event_armed;
+
+    if (armed) {
+        // The descriptor is non-blocking, so draining an unsignaled one just
+        // fails.
+        uint64_t count;
+        ssize_t drained = read(fd, &count, sizeof(count));
+        (void)drained;
+
+        queue->event_fd = fd;
+        queue->event_armed = true;
+        atomic_fetch_add(&queue->length, 1);
+    }
+
+    mutex_release(&queue->mutex);
+
+    // Order the arming before the caller rechecks its condition.
+    atomic_thread_fence(memory_order_seq_cst);
+
+    return armed;
+#else
+    (void)queue;
+    (void)fd;
+
+    return false;
+#endif
+}
+
+int wait_queue_wait(WaitQueue* queue, Mutex* mutex, uint64_t deadline)
+{
+    // Don't bother registering if the deadline has already passed, so that
+    // callers polling with a zero timeout never touch the queue.
+    if (deadline != CHANNEL_NO_DEADLINE && channel_now() >= deadline) {
+        return CHANNEL_WAIT_TIMEOUT;
+    }
+
+    Parker parker;
+    parker_init(&parker);
+
+    Waiter waiter;
+    waiter.parker = &parker;
+
+    wait_queue_register(queue, &waiter);
+
+    if (mutex_release(mutex) != CHANNEL_MUTEX_SUCCESS) {
+        wait_queue_unregister(queue, &waiter);
+        parker_destroy(&parker);
+        return CHANNEL_MUTEX_FAILURE;
+    }
+
+    bool unparked = parker_park_until(&parker, deadline);
+    bool notified = wait_queue_unregister(queue, &waiter);
+    parker_destroy(&parker);
+
+    if (mutex_lock(mutex) != CHANNEL_MUTEX_SUCCESS) {
+        return CHANNEL_MUTEX_FAILURE;
+    }
+
+    // A notification that raced with the deadline still counts, since the
+    // caller is about to recheck its condition anyway.
+    if (!unparked && !notified) {
+        return CHANNEL_WAIT_TIMEOUT;
+    }
+
+    return CHANNEL_MUTEX_SUCCESS;
+}
+
+void wait_queue_destroy(WaitQueue* queue)
+{
+    mutex_destroy(&queue->mutex);
+}
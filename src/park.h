@@ -0,0 +1,115 @@
+#ifndef CHANNEL_PARK_H
+#define CHANNEL_PARK_H
+
+#include "mutex.h"
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+#ifdef _WIN32
+#  include <Windows.h>
+#elif !defined(__linux__)
+#  include <pthread.h>
+#endif
+
+#define CHANNEL_WAIT_TIMEOUT 2
+
+// A parking spot for a single thread. A parker holds at most one wake-up
+// token: unparking a thread that is not yet parked makes its next park return
+// immediately. On Linux the parker is a single futex word and needs no other
+// resources; elsewhere it falls back to a lock and condition variable.
+typedef struct Parker_ {
+    atomic_int state;
+#ifdef _WIN32
+    SRWLOCK lock;
+    CONDITION_VARIABLE cond;
+#elif !defined(__linux__)
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+#endif
+} Parker;
+
+// An entry in a wait queue. Waiters live on the stack of the blocked thread
+// and must be unregistered before that stack frame is left.
+typedef struct Waiter_ {
+    Parker* parker;
+    struct Waiter_* prev;
+    struct Waiter_* next;
+    bool queued;
+} Waiter;
+
+// A queue of threads blocked on some condition of a channel buffer. Notifying
+// an empty queue costs a single atomic load and never enters the kernel.
+//
+// Besides threads, the queue can hold an event file descriptor, which is
+// written to by the next notification once armed and is then disarmed. An
+// armed event counts towards `length` but does not take the place of a
+// thread in a notification.
+typedef struct WaitQueue_ {
+    atomic_size_t length;
+    Mutex mutex;
+    Waiter* head;
+    Waiter* tail;
+    int event_fd;
+    bool event_armed;
+} WaitQueue;
+
+// Initializes a parker with no wake-up token.
+void parker_init(Parker* parker);
+
+// Blocks the calling thread until the parker is unparked, consuming the
+// wake-up token.
+void parker_park(Parker* parker);
+
+// Blocks the calling thread until the parker is unparked or the monotonic
+// clock reaches the deadline, given in nanoseconds. If `true` is returned, the
+// wake-up token was consumed; otherwise the deadline passed first.
+bool parker_park_until(Parker* parker, uint64_t deadline);
+
+// Wakes the thread parked on the parker, or leaves a wake-up token for it if
+// it is not parked yet.
+void parker_unpark(Parker* parker);
+
+// Releases any resources held by the parker.
+void parker_destroy(Parker* parker);
+
+// Initializes an empty wait queue.
+void wait_queue_init(WaitQueue* queue);
+
+// Adds a waiter to the back of the queue.
+void wait_queue_register(WaitQueue* queue, Waiter* waiter);
+
+// Removes a waiter from the queue. If `true` is returned, the waiter had
+// already been removed by a notification.
+bool wait_queue_unregister(WaitQueue* queue, Waiter* waiter);
+
+// Wakes the waiter at the front of the queue, if there is one.
+void wait_queue_notify_one(WaitQueue* queue);
+
+// Wakes up to `count` waiters from the front of the queue.
+void wait_queue_notify_many(WaitQueue* queue, size_t count);
+
+// Wakes every waiter in the queue.
+void wait_queue_notify_all(WaitQueue* queue);
+
+// Arms an event file descriptor, so that the next notification of the queue
+// writes to it. The descriptor is drained first, so that it only becomes
+// readable again through that notification. If `false` is returned, the
+// event was armed already and has not been drained. Only Linux eventfd
+// descriptors are supported; elsewhere this does nothing.
+bool wait_queue_arm_event(WaitQueue* queue, int fd);
+
+// Parks the calling thread on the queue until it is notified or the monotonic
+// clock reaches the deadline, given in nanoseconds. The mutex must be held by
+// the caller; it is released while the thread is parked and reacquired before
+// returning. Spurious wake-ups are possible, so the caller must recheck its
+// condition. The returned value is a mutex error code, or
+// `CHANNEL_WAIT_TIMEOUT` if the deadline passed, in which case the mutex is
+// held again as well.
+int wait_queue_wait(WaitQueue* queue, Mutex* mutex, uint64_t deadline);
+
+// Frees the resources used by the wait queue. The queue must be empty.
+void wait_queue_destroy(WaitQueue* queue);
+
+#endif // CHANNEL_PARK_H
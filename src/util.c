@@ -2,10 +2,73 @@
 
 #ifdef _WIN32
 #  include <Windows.h>
+#  include <malloc.h>
 #else
+#  include <sched.h>
 #  include <time.h>
 #endif
 
+#ifdef _WIN32
+#  define CHANNEL_THREAD_LOCAL __declspec(thread)
+#else
+#  define CHANNEL_THREAD_LOCAL _Thread_local
+#endif
+
+void* channel_aligned_alloc(size_t alignment, size_t size)
+{
+#ifdef _WIN32
+    return _aligned_malloc(size, alignment);
+#else
+    void* pointer;
+
+    if (posix_memalign(&pointer, alignment, size) != 0) {
+        return NULL;
+    }
+
+    return pointer;
+#endif
+}
+
+void channel_aligned_free(void* pointer)
+{
+#ifdef _WIN32
+    _aligned_free(pointer);
+#else
+    free(pointer);
+#endif
+}
+
+uint64_t channel_now(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (uint64_t)(counter.QuadPart / frequency.QuadPart) * 1000000000
+        + (uint64_t)(counter.QuadPart % frequency.QuadPart) * 1000000000 / (uint64_t)frequency.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+uint64_t channel_deadline(double seconds)
+{
+    uint64_t now = channel_now();
+
+    if (!(seconds > 0)) {
+        return now;
+    }
+
+    if (seconds >= (double)(CHANNEL_NO_DEADLINE - now) / 1e9) {
+        return CHANNEL_NO_DEADLINE;
+    }
+
+    return now + (uint64_t)(seconds * 1e9);
+}
+
 void channel_sleep(double seconds)
 {
 #ifdef _WIN32
@@ -18,7 +81,39 @@ void channel_sleep(double seconds)
 #endif
 }
 
-void channel_wait(void)
+void channel_yield(void)
+{
+#ifdef _WIN32
+    SwitchToThread();
+#else
+    sched_yield();
+#endif
+}
+
+void channel_pause(void)
 {
-    channel_sleep(CHANNEL_SLEEP_TIME);
+#ifdef _WIN32
+    YieldProcessor();
+#elif defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+uint32_t channel_random(void)
+{
+    static CHANNEL_THREAD_LOCAL uint32_t state = 0;
+
+    if (state == 0) {
+        // Seed from the clock and the address of the state, which differs
+        // between threads.
+        state = (uint32_t)(channel_now() ^ (uintptr_t)&state) | 1;
+    }
+
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+
+    return state;
 }
@@ -1,17 +1,34 @@
 #ifndef CHANNEL_UTIL_H
 #define CHANNEL_UTIL_H
 
+#include "clock.h"
 #include <stdlib.h>
+#include <stdint.h>
 
 #define NEW(T) ((T*)malloc(sizeof(T)))
 #define NEW_N(T, n) ((T*)malloc((n) * sizeof(T)))
 
-#define CHANNEL_SLEEP_TIME 0.001
+#define CHANNEL_MIN(a, b) ((a) < (b) ? (a) : (b))
+
+// Allocates memory aligned to the given power-of-two alignment. The memory
+// must be freed with `channel_aligned_free`.
+void* channel_aligned_alloc(size_t alignment, size_t size);
+
+// Frees memory allocated by `channel_aligned_alloc`.
+void channel_aligned_free(void* pointer);
 
 // Sleeps for the provided number of seconds.
 void channel_sleep(double seconds);
 
-// Sleeps for the number of seconds specified by `CHANNEL_SLEEP_TIME`.
-void channel_wait(void);
+// Gives up the rest of the calling thread's time slice.
+void channel_yield(void);
+
+// Tells the processor that the calling thread is spinning on a memory
+// location, which saves power and frees resources for a sibling hyperthread.
+void channel_pause(void);
+
+// Returns a pseudo-random number from a generator local to the calling
+// thread. This is cheap and not suitable for anything but load balancing.
+uint32_t channel_random(void);
 
 #endif // CHANNEL_UTIL_H
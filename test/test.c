@@ -1,6 +1,9 @@
 #include "../src/channel.h"
+#include "../src/channel_inline.h"
+#include "../src/util.h"
 #include "threading.h"
 #include <stdio.h>
+#include <string.h>
 
 #ifdef _WIN32
 #  include <Windows.h>
@@ -8,6 +11,11 @@
 #  include <time.h>
 #endif
 
+#ifdef __linux__
+#  include <poll.h>
+#  include <unistd.h>
+#endif
+
 #define STR_SIZE(s) ((strlen(s) + 1) * sizeof(char))
 
 #define MIN(a, b) (((a) < (b)) ? (a) : (b))
@@ -405,6 +413,224 @@ void test_rendezvous_multiple_senders(void)
     free_rendezvous_receiver(receiver);
 }
 
+// Helper for `test_rendezvous_ping_pong`.
+void test_rendezvous_ping_pong_helper(void* channels_vp)
+{
+    RendezvousChannel** channels = (RendezvousChannel**)channels_vp;
+
+    for (int i = 0; i < 10000; i++) {
+        void* msg = rendezvous_recv_c(channels[0]);
+
+        TEST_ASSERT(msg != NULL);
+        TEST_ASSERT_INT_EQ(rendezvous_send_c(channels[1], msg), CHANNEL_SUCCESS);
+    }
+}
+
+// Test rendezvous channel round trips between threads.
+void test_rendezvous_ping_pong(void)
+{
+    RendezvousChannel* channels[2] = { rendezvous_channel(), rendezvous_channel() };
+
+    JoinHandle* handle = thread_spawn(test_rendezvous_ping_pong_helper, channels);
+
+    int msg = 5;
+
+    for (int i = 0; i < 10000; i++) {
+        TEST_ASSERT_INT_EQ(rendezvous_send_c(channels[0], &msg), CHANNEL_SUCCESS);
+        TEST_ASSERT(rendezvous_recv_c(channels[1]) == &msg);
+    }
+
+    thread_join(handle);
+
+    free_rendezvous_channel(channels[0]);
+    free_rendezvous_channel(channels[1]);
+}
+
+// Helper for `test_rendezvous_batch`.
+void test_rendezvous_batch_helper(void* sender_vp)
+{
+    RendezvousSender* sender = (RendezvousSender*)sender_vp;
+    void* msgs[10];
+
+    for (size_t batch = 0; batch < 10; batch++) {
+        for (size_t i = 0; i < 10; i++) {
+            msgs[i] = (void*)(batch * 10 + i + 1);
+        }
+
+        size_t sent = 0;
+        TEST_ASSERT_INT_EQ(rendezvous_send_many(sender, msgs, 10, &sent), CHANNEL_SUCCESS);
+        TEST_ASSERT(sent == (size_t)10);
+    }
+}
+
+// Test sending and receiving batches through a rendezvous channel.
+void test_rendezvous_batch(void)
+{
+    RendezvousChannel* channel = rendezvous_channel();
+    RendezvousSender* sender = channel->sender;
+    RendezvousReceiver* receiver = channel->receiver;
+    free_rendezvous_channel_wrapper(channel);
+
+    void* recv[3];
+    size_t received = 0;
+
+    TEST_ASSERT_INT_EQ(rendezvous_recv_many_timeout(receiver, recv, 3, &received, 0.01), CHANNEL_TIMEOUT);
+    TEST_ASSERT(received == (size_t)0);
+
+    JoinHandle* handle = thread_spawn(test_rendezvous_batch_helper, sender);
+
+    size_t expected = 1;
+
+    while (expected <= 100) {
+        TEST_ASSERT_INT_EQ(rendezvous_recv_many(receiver, recv, 3, &received), CHANNEL_SUCCESS);
+        TEST_ASSERT(received > 0 && received <= 3);
+
+        for (size_t i = 0; i < received; i++) {
+            TEST_ASSERT((size_t)recv[i] == expected);
+            expected++;
+        }
+    }
+
+    thread_join(handle);
+
+    free_rendezvous_sender(sender);
+
+    TEST_ASSERT_INT_EQ(rendezvous_recv_many(receiver, recv, 3, &received), CHANNEL_CLOSED);
+
+    free_rendezvous_receiver(receiver);
+}
+
+// Helper for `test_rendezvous_try`.
+void test_rendezvous_try_helper(void* receiver_vp)
+{
+    RendezvousReceiver* receiver = (RendezvousReceiver*)receiver_vp;
+
+    void* recv = rendezvous_recv(receiver);
+
+    TEST_ASSERT(recv != NULL);
+    TEST_ASSERT_INT_EQ(*((int*)(recv)), 5);
+}
+
+// Test non-blocking rendezvous channel operations.
+void test_rendezvous_try(void)
+{
+    RendezvousChannel* channel = rendezvous_channel();
+    RendezvousSender* sender = channel->sender;
+    RendezvousReceiver* receiver = channel->receiver;
+    free_rendezvous_channel_wrapper(channel);
+
+    int msg = 5;
+    void* recv = NULL;
+
+    TEST_ASSERT_INT_EQ(rendezvous_try_send(sender, &msg), CHANNEL_FULL);
+    TEST_ASSERT_INT_EQ(rendezvous_try_recv(receiver, &recv), CHANNEL_EMPTY);
+
+    JoinHandle* handle = thread_spawn(test_rendezvous_try_helper, receiver);
+
+    int result;
+
+    while ((result = rendezvous_try_send(sender, &msg)) == CHANNEL_FULL) {
+        test_sleep(0.001);
+    }
+
+    TEST_ASSERT_INT_EQ(result, CHANNEL_SUCCESS);
+
+    thread_join(handle);
+
+    free_rendezvous_sender(sender);
+
+    TEST_ASSERT_INT_EQ(rendezvous_try_recv(receiver, &recv), CHANNEL_CLOSED);
+
+    free_rendezvous_receiver(receiver);
+}
+
+// Helper for `test_rendezvous_timeout`.
+void test_rendezvous_timeout_helper(void* sender_vp)
+{
+    RendezvousSender* sender = (RendezvousSender*)sender_vp;
+    int* msg = NEW(int);
+    *msg = 5;
+
+    test_sleep(0.05);
+    TEST_ASSERT_INT_EQ(rendezvous_send(sender, msg), CHANNEL_SUCCESS);
+}
+
+// Test rendezvous channel operations with timeouts and deadlines.
+void test_rendezvous_timeout(void)
+{
+    RendezvousChannel* channel = rendezvous_channel();
+    RendezvousSender* sender = channel->sender;
+    RendezvousReceiver* receiver = channel->receiver;
+    free_rendezvous_channel_wrapper(channel);
+
+    int msg = 5;
+    void* recv = NULL;
+    uint64_t start = channel_now();
+
+    TEST_ASSERT_INT_EQ(rendezvous_send_timeout(sender, &msg, 0.02), CHANNEL_TIMEOUT);
+    TEST_ASSERT(channel_now() - start >= 20000000);
+    TEST_ASSERT_INT_EQ(rendezvous_recv_deadline(receiver, &recv, channel_deadline(0.02)), CHANNEL_TIMEOUT);
+
+    JoinHandle* handle = thread_spawn(test_rendezvous_timeout_helper, sender);
+
+    TEST_ASSERT_INT_EQ(rendezvous_recv_timeout(receiver, &recv, 5.0), CHANNEL_SUCCESS);
+    TEST_ASSERT_INT_EQ(*((int*)(recv)), 5);
+    free(recv);
+
+    thread_join(handle);
+
+    free_rendezvous_sender(sender);
+
+    TEST_ASSERT_INT_EQ(rendezvous_recv_timeout(receiver, &recv, 5.0), CHANNEL_CLOSED);
+
+    free_rendezvous_receiver(receiver);
+}
+
+// Helper for `test_rendezvous_cloned_senders`.
+void test_rendezvous_cloned_senders_helper(void* sender_vp)
+{
+    RendezvousSender* sender = (RendezvousSender*)sender_vp;
+
+    for (size_t i = 1; i <= 1000; i++) {
+        TEST_ASSERT_INT_EQ(rendezvous_send(sender, (void*)i), CHANNEL_SUCCESS);
+    }
+
+    free_rendezvous_sender(sender);
+}
+
+// Test that a rendezvous channel stays open until every cloned sender is freed.
+void test_rendezvous_cloned_senders(void)
+{
+    RendezvousChannel* channel = rendezvous_channel();
+    RendezvousSender* sender = channel->sender;
+    RendezvousReceiver* receiver = channel->receiver;
+    free_rendezvous_channel_wrapper(channel);
+
+    JoinHandle* handles[4];
+
+    for (size_t i = 0; i < 4; i++) {
+        handles[i] = thread_spawn(test_rendezvous_cloned_senders_helper, clone_rendezvous_sender(sender));
+    }
+
+    // Freeing the original sender first must not close the channel.
+    free_rendezvous_sender(sender);
+
+    size_t total = 0;
+    void* recv;
+
+    while ((recv = rendezvous_recv(receiver)) != NULL) {
+        total += (size_t)recv;
+    }
+
+    TEST_ASSERT(total == (size_t)4 * 1000 * 1001 / 2);
+
+    for (size_t i = 0; i < 4; i++) {
+        thread_join(handles[i]);
+    }
+
+    free_rendezvous_receiver(receiver);
+}
+
 // Test general bounded channel operations.
 void test_bounded_channel(void)
 {
@@ -669,154 +895,522 @@ void test_bounded_multiple_senders(void)
     free_bounded_receiver(receiver);
 }
 
-// Test general unbounded channel operations.
-void test_unbounded_channel(void)
+// Test bounded channel ring wrap-around with various capacities.
+void test_bounded_wraparound(void)
 {
-    UnboundedChannel* channel = unbounded_channel();
+    size_t capacities[4] = { 1, 4, 5, 64 };
+    int msgs[300];
+
+    for (int i = 0; i < 300; i++) {
+        msgs[i] = i;
+    }
+
+    for (size_t c = 0; c < 4; c++) {
+        for (int lockfree = 0; lockfree < 2; lockfree++) {
+            BoundedChannel* channel = lockfree
+                ? bounded_channel_lockfree(capacities[c])
+                : bounded_channel(capacities[c]);
+            int sent = 0;
+            int received = 0;
+
+            while (received < 300) {
+                while (sent < 300 && (size_t)(sent - received) < capacities[c]) {
+                    TEST_ASSERT_INT_EQ(bounded_send_c(channel, &msgs[sent]), CHANNEL_SUCCESS);
+                    sent++;
+                }
+
+                void* recv = bounded_recv_c(channel);
+                TEST_ASSERT(recv != NULL);
+                TEST_ASSERT_INT_EQ(*((int*)(recv)), received);
+                received++;
+            }
+
+            free_bounded_channel(channel);
+        }
+    }
+}
+
+// Test general lock-free bounded channel operations.
+void test_bounded_lockfree_channel(void)
+{
+    BoundedChannel* channel = bounded_channel_lockfree(3);
+    BoundedSender* sender = channel->sender;
+    BoundedReceiver* receiver = channel->receiver;
+    free_bounded_channel_wrapper(channel);
 
     int msg1 = 5;
     int msg2 = 6;
     int msg3 = 7;
-    int msg4 = 8;
-    int msg5 = 9;
 
-    TEST_ASSERT_INT_EQ(unbounded_send_c(channel, &msg1), CHANNEL_SUCCESS);
-    TEST_ASSERT_INT_EQ(unbounded_send_c(channel, &msg2), CHANNEL_SUCCESS);
-    TEST_ASSERT_INT_EQ(unbounded_send_c(channel, &msg3), CHANNEL_SUCCESS);
-    TEST_ASSERT_INT_EQ(unbounded_send_c(channel, &msg4), CHANNEL_SUCCESS);
-    TEST_ASSERT_INT_EQ(unbounded_send_c(channel, &msg5), CHANNEL_SUCCESS);
+    TEST_ASSERT_INT_EQ(bounded_send(sender, &msg1), CHANNEL_SUCCESS);
+    TEST_ASSERT_INT_EQ(bounded_send(sender, &msg2), CHANNEL_SUCCESS);
+    TEST_ASSERT_INT_EQ(bounded_send(sender, &msg3), CHANNEL_SUCCESS);
 
-    void* recv1 = unbounded_recv_c(channel);
-    void* recv2 = unbounded_recv_c(channel);
-    void* recv3 = unbounded_recv_c(channel);
-    void* recv4 = unbounded_recv_c(channel);
-    void* recv5 = unbounded_recv_c(channel);
+    free_bounded_sender(sender);
+
+    void* recv1 = bounded_recv(receiver);
+    void* recv2 = bounded_recv(receiver);
+    void* recv3 = bounded_recv(receiver);
+    void* recv4 = bounded_recv(receiver);
 
     TEST_ASSERT(recv1 != NULL);
     TEST_ASSERT(recv2 != NULL);
     TEST_ASSERT(recv3 != NULL);
-    TEST_ASSERT(recv4 != NULL);
-    TEST_ASSERT(recv5 != NULL);
+    TEST_ASSERT(recv4 == NULL);
     TEST_ASSERT_INT_EQ(*((int*)(recv1)), msg1);
     TEST_ASSERT_INT_EQ(*((int*)(recv2)), msg2);
     TEST_ASSERT_INT_EQ(*((int*)(recv3)), msg3);
-    TEST_ASSERT_INT_EQ(*((int*)(recv4)), msg4);
-    TEST_ASSERT_INT_EQ(*((int*)(recv5)), msg5);
 
-    free_unbounded_channel(channel);
+    free_bounded_receiver(receiver);
 }
 
-// Test general unbounded channel operations, using sender and receiver.
-void test_unbounded_sender_receiver(void)
+// Helper for `test_bounded_lockfree_multiple_senders`.
+void test_bounded_lockfree_multiple_senders_helper(void* sender_vp)
 {
-    UnboundedChannel* channel = unbounded_channel();
-    UnboundedSender* sender = channel->sender;
-    UnboundedReceiver* receiver = channel->receiver;
-    free_unbounded_channel_wrapper(channel);
-
-    int msg1 = 5;
-    int msg2 = 6;
-    int msg3 = 7;
-    int msg4 = 8;
-    int msg5 = 9;
+    BoundedSender* sender = (BoundedSender*)sender_vp;
 
-    TEST_ASSERT_INT_EQ(unbounded_send(sender, &msg1), CHANNEL_SUCCESS);
-    TEST_ASSERT_INT_EQ(unbounded_send(sender, &msg2), CHANNEL_SUCCESS);
-    TEST_ASSERT_INT_EQ(unbounded_send(sender, &msg3), CHANNEL_SUCCESS);
-    TEST_ASSERT_INT_EQ(unbounded_send(sender, &msg4), CHANNEL_SUCCESS);
-    TEST_ASSERT_INT_EQ(unbounded_send(sender, &msg5), CHANNEL_SUCCESS);
+    for (size_t i = 1; i <= 10000; i++) {
+        TEST_ASSERT_INT_EQ(bounded_send(sender, (void*)i), CHANNEL_SUCCESS);
+    }
+}
 
-    void* recv1 = unbounded_recv(receiver);
-    void* recv2 = unbounded_recv(receiver);
-    void* recv3 = unbounded_recv(receiver);
-    void* recv4 = unbounded_recv(receiver);
-    void* recv5 = unbounded_recv(receiver);
+// Test lock-free bounded channel with many concurrent senders.
+void test_bounded_lockfree_multiple_senders(void)
+{
+    BoundedChannel* channel = bounded_channel_lockfree(16);
+    BoundedSender* sender = channel->sender;
+    BoundedReceiver* receiver = channel->receiver;
+    free_bounded_channel_wrapper(channel);
 
-    TEST_ASSERT(recv1 != NULL);
-    TEST_ASSERT(recv2 != NULL);
-    TEST_ASSERT(recv3 != NULL);
-    TEST_ASSERT(recv4 != NULL);
-    TEST_ASSERT(recv5 != NULL);
-    TEST_ASSERT_INT_EQ(*((int*)(recv1)), msg1);
-    TEST_ASSERT_INT_EQ(*((int*)(recv2)), msg2);
-    TEST_ASSERT_INT_EQ(*((int*)(recv3)), msg3);
-    TEST_ASSERT_INT_EQ(*((int*)(recv4)), msg4);
-    TEST_ASSERT_INT_EQ(*((int*)(recv5)), msg5);
+    JoinHandle* handles[8];
 
-    free_unbounded_sender(sender);
-    free_unbounded_receiver(receiver);
-}
+    for (size_t i = 0; i < 8; i++) {
+        handles[i] = thread_spawn(test_bounded_lockfree_multiple_senders_helper, sender);
+    }
 
-// Test unbounded channel sender closing detection.
-void test_unbounded_sender_closed(void)
-{
-    UnboundedChannel* channel = unbounded_channel();
-    UnboundedSender* sender = channel->sender;
-    UnboundedReceiver* receiver = channel->receiver;
-    free_unbounded_channel_wrapper(channel);
+    size_t total = 0;
 
-    int msg1 = 5;
-    int msg2 = 6;
-    int msg3 = 7;
+    for (size_t i = 0; i < 8 * 10000; i++) {
+        void* recv = bounded_recv(receiver);
+        TEST_ASSERT(recv != NULL);
+        total += (size_t)recv;
+    }
 
-    TEST_ASSERT_INT_EQ(unbounded_send(sender, &msg1), CHANNEL_SUCCESS);
-    TEST_ASSERT_INT_EQ(unbounded_send(sender, &msg2), CHANNEL_SUCCESS);
-    TEST_ASSERT_INT_EQ(unbounded_send(sender, &msg3), CHANNEL_SUCCESS);
+    for (size_t i = 0; i < 8; i++) {
+        thread_join(handles[i]);
+    }
 
-    free_unbounded_sender(sender);
+    TEST_ASSERT(total == (size_t)8 * 10000 * 10001 / 2);
 
-    void* recv1 = unbounded_recv(receiver);
-    void* recv2 = unbounded_recv(receiver);
-    void* recv3 = unbounded_recv(receiver);
+    free_bounded_sender(sender);
+    free_bounded_receiver(receiver);
+}
 
-    TEST_ASSERT(recv1 != NULL);
-    TEST_ASSERT(recv2 != NULL);
-    TEST_ASSERT(recv3 != NULL);
-    TEST_ASSERT_INT_EQ(*((int*)(recv1)), msg1);
-    TEST_ASSERT_INT_EQ(*((int*)(recv2)), msg2);
-    TEST_ASSERT_INT_EQ(*((int*)(recv3)), msg3);
+// Helper for `test_bounded_batch`.
+void test_bounded_batch_helper(void* sender_vp)
+{
+    BoundedSender* sender = (BoundedSender*)sender_vp;
+    void* msgs[7];
 
-    void* recv4 = unbounded_recv(receiver);
+    for (size_t batch = 0; batch < 100; batch++) {
+        for (size_t i = 0; i < 7; i++) {
+            msgs[i] = (void*)(batch * 7 + i + 1);
+        }
 
-    TEST_ASSERT(recv4 == NULL);
+        size_t sent = 0;
+        TEST_ASSERT_INT_EQ(bounded_send_many(sender, msgs, 7, &sent), CHANNEL_SUCCESS);
+        TEST_ASSERT(sent == (size_t)7);
+    }
 
-    free_unbounded_receiver(receiver);
+    free_bounded_sender(sender);
 }
 
-// Test unbounded channel receiver closing detection.
-void test_unbounded_receiver_closed(void)
+// Test sending and receiving batches that wrap around the ring of a bounded
+// channel.
+void test_bounded_batch(void)
 {
-    UnboundedChannel* channel = unbounded_channel();
-    UnboundedSender* sender = channel->sender;
-    UnboundedReceiver* receiver = channel->receiver;
-    free_unbounded_channel_wrapper(channel);
+    for (int lockfree = 0; lockfree < 2; lockfree++) {
+        BoundedChannel* channel = lockfree ? bounded_channel_lockfree(5) : bounded_channel(5);
+        BoundedSender* sender = channel->sender;
+        BoundedReceiver* receiver = channel->receiver;
+        free_bounded_channel_wrapper(channel);
 
-    int msg1 = 5;
-    int msg2 = 6;
-    int msg3 = 7;
+        void* recv[4];
+        size_t received = 0;
 
-    TEST_ASSERT_INT_EQ(unbounded_send(sender, &msg1), CHANNEL_SUCCESS);
-    TEST_ASSERT_INT_EQ(unbounded_send(sender, &msg2), CHANNEL_SUCCESS);
-    TEST_ASSERT_INT_EQ(unbounded_send(sender, &msg3), CHANNEL_SUCCESS);
+        TEST_ASSERT_INT_EQ(bounded_recv_many_timeout(receiver, recv, 4, &received, 0.01), CHANNEL_TIMEOUT);
+        TEST_ASSERT(received == (size_t)0);
 
-    void* recv1 = unbounded_recv(receiver);
-    void* recv2 = unbounded_recv(receiver);
-    void* recv3 = unbounded_recv(receiver);
+        JoinHandle* handle = thread_spawn(test_bounded_batch_helper, sender);
 
-    TEST_ASSERT(recv1 != NULL);
-    TEST_ASSERT(recv2 != NULL);
-    TEST_ASSERT(recv3 != NULL);
-    TEST_ASSERT_INT_EQ(*((int*)(recv1)), msg1);
-    TEST_ASSERT_INT_EQ(*((int*)(recv2)), msg2);
-    TEST_ASSERT_INT_EQ(*((int*)(recv3)), msg3);
+        size_t expected = 1;
+        int result;
 
-    free_unbounded_receiver(receiver);
+        while ((result = bounded_recv_many(receiver, recv, 4, &received)) == CHANNEL_SUCCESS) {
+            TEST_ASSERT(received > 0 && received <= 4);
 
-    int msg4 = 8;
+            for (size_t i = 0; i < received; i++) {
+                TEST_ASSERT((size_t)recv[i] == expected);
+                expected++;
+            }
+        }
 
-    TEST_ASSERT_INT_EQ(unbounded_send(sender, &msg4), CHANNEL_CLOSED);
+        TEST_ASSERT_INT_EQ(result, CHANNEL_CLOSED);
+        TEST_ASSERT(expected == (size_t)701);
 
-    free_unbounded_sender(sender);
+        thread_join(handle);
+
+        // A full buffer times out part of the way through a batch.
+        channel = lockfree ? bounded_channel_lockfree(5) : bounded_channel(5);
+        size_t sent = 0;
+
+        TEST_ASSERT_INT_EQ(bounded_send_many_timeout_c(channel, recv, 4, &sent, 0.01), CHANNEL_SUCCESS);
+        TEST_ASSERT(sent == (size_t)4);
+        TEST_ASSERT_INT_EQ(bounded_send_many_timeout_c(channel, recv, 4, &sent, 0.01), CHANNEL_TIMEOUT);
+        TEST_ASSERT(sent == (size_t)1);
+
+        free_bounded_channel(channel);
+        free_bounded_receiver(receiver);
+    }
+}
+
+// Test non-blocking bounded channel operations.
+void test_bounded_try(void)
+{
+    for (int lockfree = 0; lockfree < 2; lockfree++) {
+        BoundedChannel* channel = lockfree ? bounded_channel_lockfree(2) : bounded_channel(2);
+
+        int msg1 = 5;
+        int msg2 = 6;
+        int msg3 = 7;
+        void* recv = NULL;
+
+        TEST_ASSERT_INT_EQ(bounded_try_recv_c(channel, &recv), CHANNEL_EMPTY);
+        TEST_ASSERT_INT_EQ(bounded_try_send_c(channel, &msg1), CHANNEL_SUCCESS);
+        TEST_ASSERT_INT_EQ(bounded_try_send_c(channel, &msg2), CHANNEL_SUCCESS);
+        TEST_ASSERT_INT_EQ(bounded_try_send_c(channel, &msg3), CHANNEL_FULL);
+        TEST_ASSERT_INT_EQ(bounded_try_recv_c(channel, &recv), CHANNEL_SUCCESS);
+        TEST_ASSERT_INT_EQ(*((int*)(recv)), msg1);
+        TEST_ASSERT_INT_EQ(bounded_try_send_c(channel, &msg3), CHANNEL_SUCCESS);
+
+        BoundedReceiver* receiver = channel->receiver;
+        free_bounded_sender(channel->sender);
+        free_bounded_channel_wrapper(channel);
+
+        TEST_ASSERT_INT_EQ(bounded_try_recv(receiver, &recv), CHANNEL_SUCCESS);
+        TEST_ASSERT_INT_EQ(*((int*)(recv)), msg2);
+        TEST_ASSERT_INT_EQ(bounded_try_recv(receiver, &recv), CHANNEL_SUCCESS);
+        TEST_ASSERT_INT_EQ(*((int*)(recv)), msg3);
+        TEST_ASSERT_INT_EQ(bounded_try_recv(receiver, &recv), CHANNEL_CLOSED);
+
+        free_bounded_receiver(receiver);
+    }
+}
+
+// Helper for `test_bounded_timeout`.
+void test_bounded_timeout_helper(void* receiver_vp)
+{
+    BoundedReceiver* receiver = (BoundedReceiver*)receiver_vp;
+    void* recv = NULL;
+
+    test_sleep(0.05);
+    TEST_ASSERT_INT_EQ(bounded_recv_timeout(receiver, &recv, 5.0), CHANNEL_SUCCESS);
+}
+
+// Test bounded channel operations with timeouts and deadlines.
+void test_bounded_timeout(void)
+{
+    for (int lockfree = 0; lockfree < 2; lockfree++) {
+        BoundedChannel* channel = lockfree ? bounded_channel_lockfree(1) : bounded_channel(1);
+
+        int msg = 5;
+        void* recv = NULL;
+        uint64_t start = channel_now();
+
+        TEST_ASSERT_INT_EQ(bounded_recv_timeout_c(channel, &recv, 0.02), CHANNEL_TIMEOUT);
+        TEST_ASSERT(channel_now() - start >= 20000000);
+        TEST_ASSERT_INT_EQ(bounded_send_timeout_c(channel, &msg, 0.02), CHANNEL_SUCCESS);
+        TEST_ASSERT_INT_EQ(bounded_send_deadline_c(channel, &msg, channel_deadline(0.02)), CHANNEL_TIMEOUT);
+
+        // A receiver frees up the slot before the deadline.
+        JoinHandle* handle = thread_spawn(test_bounded_timeout_helper, channel->receiver);
+
+        TEST_ASSERT_INT_EQ(bounded_send_timeout_c(channel, &msg, 5.0), CHANNEL_SUCCESS);
+
+        thread_join(handle);
+
+        TEST_ASSERT_INT_EQ(bounded_recv_deadline_c(channel, &recv, channel_deadline(0.02)), CHANNEL_SUCCESS);
+        TEST_ASSERT_INT_EQ(*((int*)(recv)), msg);
+
+        free_bounded_channel(channel);
+    }
+}
+
+// A receiver in a multi-consumer bounded channel test, along with the total of
+// the messages it received.
+typedef struct BoundedMpmcWorker_ {
+    BoundedReceiver* receiver;
+    size_t total;
+} BoundedMpmcWorker;
+
+// Helper for `test_bounded_mpmc`.
+void test_bounded_mpmc_sender_helper(void* sender_vp)
+{
+    BoundedSender* sender = (BoundedSender*)sender_vp;
+
+    for (size_t i = 1; i <= 10000; i++) {
+        TEST_ASSERT_INT_EQ(bounded_send(sender, (void*)i), CHANNEL_SUCCESS);
+    }
+}
+
+// Helper for `test_bounded_mpmc`.
+void test_bounded_mpmc_receiver_helper(void* worker_vp)
+{
+    BoundedMpmcWorker* worker = (BoundedMpmcWorker*)worker_vp;
+    void* recv;
+
+    while ((recv = bounded_recv(worker->receiver)) != NULL) {
+        worker->total += (size_t)recv;
+    }
+
+    free_bounded_receiver(worker->receiver);
+}
+
+// Test a bounded channel with many senders and many receivers.
+void test_bounded_mpmc(void)
+{
+    BoundedChannel* single = bounded_channel_lockfree(8);
+    TEST_ASSERT(clone_bounded_receiver(single->receiver) == NULL);
+    free_bounded_channel(single);
+
+    BoundedChannel* channel = bounded_channel_mpmc(8);
+    BoundedSender* sender = channel->sender;
+    BoundedMpmcWorker workers[4];
+    JoinHandle* receiver_handles[4];
+    JoinHandle* sender_handles[4];
+
+    for (size_t i = 0; i < 4; i++) {
+        workers[i].receiver = i == 0 ? channel->receiver : clone_bounded_receiver(channel->receiver);
+        workers[i].total = 0;
+        TEST_ASSERT(workers[i].receiver != NULL);
+    }
+
+    free_bounded_channel_wrapper(channel);
+
+    for (size_t i = 0; i < 4; i++) {
+        receiver_handles[i] = thread_spawn(test_bounded_mpmc_receiver_helper, &workers[i]);
+        sender_handles[i] = thread_spawn(test_bounded_mpmc_sender_helper, sender);
+    }
+
+    for (size_t i = 0; i < 4; i++) {
+        thread_join(sender_handles[i]);
+    }
+
+    free_bounded_sender(sender);
+
+    size_t total = 0;
+
+    for (size_t i = 0; i < 4; i++) {
+        thread_join(receiver_handles[i]);
+        total += workers[i].total;
+    }
+
+    TEST_ASSERT(total == (size_t)4 * 10000 * 10001 / 2);
+}
+
+// Helper for `test_bounded_cloned_senders`.
+void test_bounded_cloned_senders_helper(void* sender_vp)
+{
+    BoundedSender* sender = (BoundedSender*)sender_vp;
+
+    for (size_t i = 1; i <= 1000; i++) {
+        TEST_ASSERT_INT_EQ(bounded_send(sender, (void*)i), CHANNEL_SUCCESS);
+    }
+
+    free_bounded_sender(sender);
+}
+
+// Test that a bounded channel stays open until every cloned sender is freed.
+void test_bounded_cloned_senders(void)
+{
+    BoundedChannel* channel = bounded_channel_lockfree(8);
+    BoundedSender* sender = channel->sender;
+    BoundedReceiver* receiver = channel->receiver;
+    free_bounded_channel_wrapper(channel);
+
+    JoinHandle* handles[4];
+
+    for (size_t i = 0; i < 4; i++) {
+        handles[i] = thread_spawn(test_bounded_cloned_senders_helper, clone_bounded_sender(sender));
+    }
+
+    // Freeing the original sender first must not close the channel.
+    free_bounded_sender(sender);
+
+    size_t total = 0;
+    void* recv;
+
+    while ((recv = bounded_recv(receiver)) != NULL) {
+        total += (size_t)recv;
+    }
+
+    TEST_ASSERT(total == (size_t)4 * 1000 * 1001 / 2);
+
+    for (size_t i = 0; i < 4; i++) {
+        thread_join(handles[i]);
+    }
+
+    free_bounded_receiver(receiver);
+}
+
+// Test general unbounded channel operations.
+void test_unbounded_channel(void)
+{
+    UnboundedChannel* channel = unbounded_channel();
+
+    int msg1 = 5;
+    int msg2 = 6;
+    int msg3 = 7;
+    int msg4 = 8;
+    int msg5 = 9;
+
+    TEST_ASSERT_INT_EQ(unbounded_send_c(channel, &msg1), CHANNEL_SUCCESS);
+    TEST_ASSERT_INT_EQ(unbounded_send_c(channel, &msg2), CHANNEL_SUCCESS);
+    TEST_ASSERT_INT_EQ(unbounded_send_c(channel, &msg3), CHANNEL_SUCCESS);
+    TEST_ASSERT_INT_EQ(unbounded_send_c(channel, &msg4), CHANNEL_SUCCESS);
+    TEST_ASSERT_INT_EQ(unbounded_send_c(channel, &msg5), CHANNEL_SUCCESS);
+
+    void* recv1 = unbounded_recv_c(channel);
+    void* recv2 = unbounded_recv_c(channel);
+    void* recv3 = unbounded_recv_c(channel);
+    void* recv4 = unbounded_recv_c(channel);
+    void* recv5 = unbounded_recv_c(channel);
+
+    TEST_ASSERT(recv1 != NULL);
+    TEST_ASSERT(recv2 != NULL);
+    TEST_ASSERT(recv3 != NULL);
+    TEST_ASSERT(recv4 != NULL);
+    TEST_ASSERT(recv5 != NULL);
+    TEST_ASSERT_INT_EQ(*((int*)(recv1)), msg1);
+    TEST_ASSERT_INT_EQ(*((int*)(recv2)), msg2);
+    TEST_ASSERT_INT_EQ(*((int*)(recv3)), msg3);
+    TEST_ASSERT_INT_EQ(*((int*)(recv4)), msg4);
+    TEST_ASSERT_INT_EQ(*((int*)(recv5)), msg5);
+
+    free_unbounded_channel(channel);
+}
+
+// Test general unbounded channel operations, using sender and receiver.
+void test_unbounded_sender_receiver(void)
+{
+    UnboundedChannel* channel = unbounded_channel();
+    UnboundedSender* sender = channel->sender;
+    UnboundedReceiver* receiver = channel->receiver;
+    free_unbounded_channel_wrapper(channel);
+
+    int msg1 = 5;
+    int msg2 = 6;
+    int msg3 = 7;
+    int msg4 = 8;
+    int msg5 = 9;
+
+    TEST_ASSERT_INT_EQ(unbounded_send(sender, &msg1), CHANNEL_SUCCESS);
+    TEST_ASSERT_INT_EQ(unbounded_send(sender, &msg2), CHANNEL_SUCCESS);
+    TEST_ASSERT_INT_EQ(unbounded_send(sender, &msg3), CHANNEL_SUCCESS);
+    TEST_ASSERT_INT_EQ(unbounded_send(sender, &msg4), CHANNEL_SUCCESS);
+    TEST_ASSERT_INT_EQ(unbounded_send(sender, &msg5), CHANNEL_SUCCESS);
+
+    void* recv1 = unbounded_recv(receiver);
+    void* recv2 = unbounded_recv(receiver);
+    void* recv3 = unbounded_recv(receiver);
+    void* recv4 = unbounded_recv(receiver);
+    void* recv5 = unbounded_recv(receiver);
+
+    TEST_ASSERT(recv1 != NULL);
+    TEST_ASSERT(recv2 != NULL);
+    TEST_ASSERT(recv3 != NULL);
+    TEST_ASSERT(recv4 != NULL);
+    TEST_ASSERT(recv5 != NULL);
+    TEST_ASSERT_INT_EQ(*((int*)(recv1)), msg1);
+    TEST_ASSERT_INT_EQ(*((int*)(recv2)), msg2);
+    TEST_ASSERT_INT_EQ(*((int*)(recv3)), msg3);
+    TEST_ASSERT_INT_EQ(*((int*)(recv4)), msg4);
+    TEST_ASSERT_INT_EQ(*((int*)(recv5)), msg5);
+
+    free_unbounded_sender(sender);
+    free_unbounded_receiver(receiver);
+}
+
+// Test unbounded channel sender closing detection.
+void test_unbounded_sender_closed(void)
+{
+    UnboundedChannel* channel = unbounded_channel();
+    UnboundedSender* sender = channel->sender;
+    UnboundedReceiver* receiver = channel->receiver;
+    free_unbounded_channel_wrapper(channel);
+
+    int msg1 = 5;
+    int msg2 = 6;
+    int msg3 = 7;
+
+    TEST_ASSERT_INT_EQ(unbounded_send(sender, &msg1), CHANNEL_SUCCESS);
+    TEST_ASSERT_INT_EQ(unbounded_send(sender, &msg2), CHANNEL_SUCCESS);
+    TEST_ASSERT_INT_EQ(unbounded_send(sender, &msg3), CHANNEL_SUCCESS);
+
+    free_unbounded_sender(sender);
+
+    void* recv1 = unbounded_recv(receiver);
+    void* recv2 = unbounded_recv(receiver);
+    void* recv3 = unbounded_recv(receiver);
+
+    TEST_ASSERT(recv1 != NULL);
+    TEST_ASSERT(recv2 != NULL);
+    TEST_ASSERT(recv3 != NULL);
+    TEST_ASSERT_INT_EQ(*((int*)(recv1)), msg1);
+    TEST_ASSERT_INT_EQ(*((int*)(recv2)), msg2);
+    TEST_ASSERT_INT_EQ(*((int*)(recv3)), msg3);
+
+    void* recv4 = unbounded_recv(receiver);
+
+    TEST_ASSERT(recv4 == NULL);
+
+    free_unbounded_receiver(receiver);
+}
+
+// Test unbounded channel receiver closing detection.
+void test_unbounded_receiver_closed(void)
+{
+    UnboundedChannel* channel = unbounded_channel();
+    UnboundedSender* sender = channel->sender;
+    UnboundedReceiver* receiver = channel->receiver;
+    free_unbounded_channel_wrapper(channel);
+
+    int msg1 = 5;
+    int msg2 = 6;
+    int msg3 = 7;
+
+    TEST_ASSERT_INT_EQ(unbounded_send(sender, &msg1), CHANNEL_SUCCESS);
+    TEST_ASSERT_INT_EQ(unbounded_send(sender, &msg2), CHANNEL_SUCCESS);
+    TEST_ASSERT_INT_EQ(unbounded_send(sender, &msg3), CHANNEL_SUCCESS);
+
+    void* recv1 = unbounded_recv(receiver);
+    void* recv2 = unbounded_recv(receiver);
+    void* recv3 = unbounded_recv(receiver);
+
+    TEST_ASSERT(recv1 != NULL);
+    TEST_ASSERT(recv2 != NULL);
+    TEST_ASSERT(recv3 != NULL);
+    TEST_ASSERT_INT_EQ(*((int*)(recv1)), msg1);
+    TEST_ASSERT_INT_EQ(*((int*)(recv2)), msg2);
+    TEST_ASSERT_INT_EQ(*((int*)(recv3)), msg3);
+
+    free_unbounded_receiver(receiver);
+
+    int msg4 = 8;
+
+    TEST_ASSERT_INT_EQ(unbounded_send(sender, &msg4), CHANNEL_CLOSED);
+
+    free_unbounded_sender(sender);
 }
 
 // Helper for `test_unbounded_threaded`.
@@ -953,6 +1547,1973 @@ void test_unbounded_multiple_senders(void)
     free_unbounded_receiver(receiver);
 }
 
+// Helper for `test_unbounded_blocked_sender_closed`.
+void test_unbounded_blocked_sender_closed_helper(void* receiver_vp)
+{
+    UnboundedReceiver* receiver = (UnboundedReceiver*)receiver_vp;
+
+    void* recv = unbounded_recv(receiver);
+
+    TEST_ASSERT(recv == NULL);
+}
+
+// Test that a blocked receiver is woken when the sender is destroyed.
+void test_unbounded_blocked_sender_closed(void)
+{
+    UnboundedChannel* channel = unbounded_channel();
+    UnboundedSender* sender = channel->sender;
+    UnboundedReceiver* receiver = channel->receiver;
+    free_unbounded_channel_wrapper(channel);
+
+    JoinHandle* handle = thread_spawn(test_unbounded_blocked_sender_closed_helper, receiver);
+
+    test_sleep(0.1);
+
+    free_unbounded_sender(sender);
+
+    thread_join(handle);
+
+    free_unbounded_receiver(receiver);
+}
+
+// Test general lock-free unbounded channel operations.
+void test_unbounded_lockfree_channel(void)
+{
+    UnboundedChannel* channel = unbounded_channel_lockfree();
+    UnboundedSender* sender = channel->sender;
+    UnboundedReceiver* receiver = channel->receiver;
+    free_unbounded_channel_wrapper(channel);
+
+    int msgs[200];
+
+    for (int i = 0; i < 200; i++) {
+        msgs[i] = i;
+        TEST_ASSERT_INT_EQ(unbounded_send(sender, &msgs[i]), CHANNEL_SUCCESS);
+    }
+
+    for (int i = 0; i < 150; i++) {
+        void* recv = unbounded_recv(receiver);
+        TEST_ASSERT(recv != NULL);
+        TEST_ASSERT_INT_EQ(*((int*)(recv)), i);
+    }
+
+    free_unbounded_sender(sender);
+
+    for (int i = 150; i < 200; i++) {
+        void* recv = unbounded_recv(receiver);
+        TEST_ASSERT(recv != NULL);
+        TEST_ASSERT_INT_EQ(*((int*)(recv)), i);
+    }
+
+    TEST_ASSERT(unbounded_recv(receiver) == NULL);
+
+    free_unbounded_receiver(receiver);
+}
+
+// Helper for `test_unbounded_lockfree_multiple_senders`.
+void test_unbounded_lockfree_multiple_senders_helper(void* sender_vp)
+{
+    UnboundedSender* sender = (UnboundedSender*)sender_vp;
+
+    for (size_t i = 1; i <= 10000; i++) {
+        TEST_ASSERT_INT_EQ(unbounded_send(sender, (void*)i), CHANNEL_SUCCESS);
+    }
+}
+
+// Test lock-free unbounded channel with many concurrent senders.
+void test_unbounded_lockfree_multiple_senders(void)
+{
+    UnboundedChannel* channel = unbounded_channel_lockfree();
+    UnboundedSender* sender = channel->sender;
+    UnboundedReceiver* receiver = channel->receiver;
+    free_unbounded_channel_wrapper(channel);
+
+    JoinHandle* handles[8];
+
+    for (size_t i = 0; i < 8; i++) {
+        handles[i] = thread_spawn(test_unbounded_lockfree_multiple_senders_helper, sender);
+    }
+
+    size_t total = 0;
+
+    for (size_t i = 0; i < 8 * 10000; i++) {
+        void* recv = unbounded_recv(receiver);
+        TEST_ASSERT(recv != NULL);
+        total += (size_t)recv;
+    }
+
+    for (size_t i = 0; i < 8; i++) {
+        thread_join(handles[i]);
+    }
+
+    TEST_ASSERT(total == (size_t)8 * 10000 * 10001 / 2);
+
+    free_unbounded_sender(sender);
+    free_unbounded_receiver(receiver);
+}
+
+// Test sending and receiving batches through an unbounded channel.
+void test_unbounded_batch(void)
+{
+    for (int lockfree = 0; lockfree < 2; lockfree++) {
+        UnboundedChannel* channel = lockfree ? unbounded_channel_lockfree() : unbounded_channel();
+        UnboundedSender* sender = channel->sender;
+        UnboundedReceiver* receiver = channel->receiver;
+        free_unbounded_channel_wrapper(channel);
+
+        void* msgs[50];
+        size_t sent = 0;
+        size_t received = 0;
+
+        TEST_ASSERT_INT_EQ(unbounded_recv_many_timeout(receiver, msgs, 50, &received, 0.01), CHANNEL_TIMEOUT);
+        TEST_ASSERT(received == (size_t)0);
+
+        // Batches of 50 cross the block boundaries of lock-free channels.
+        for (size_t batch = 0; batch < 6; batch++) {
+            for (size_t i = 0; i < 50; i++) {
+                msgs[i] = (void*)(batch * 50 + i + 1);
+            }
+
+            TEST_ASSERT_INT_EQ(unbounded_send_many(sender, msgs, 50, &sent), CHANNEL_SUCCESS);
+            TEST_ASSERT(sent == (size_t)50);
+        }
+
+        free_unbounded_sender(sender);
+
+        size_t expected = 1;
+
+        while (expected <= 300) {
+            TEST_ASSERT_INT_EQ(unbounded_recv_many(receiver, msgs, 40, &received), CHANNEL_SUCCESS);
+            TEST_ASSERT(received > 0 && received <= 40);
+
+            for (size_t i = 0; i < received; i++) {
+                TEST_ASSERT((size_t)msgs[i] == expected);
+                expected++;
+            }
+        }
+
+        TEST_ASSERT_INT_EQ(unbounded_recv_many(receiver, msgs, 40, &received), CHANNEL_CLOSED);
+        TEST_ASSERT(received == (size_t)0);
+
+        free_unbounded_receiver(receiver);
+    }
+}
+
+// Test non-blocking unbounded channel operations.
+void test_unbounded_try(void)
+{
+    for (int lockfree = 0; lockfree < 2; lockfree++) {
+        UnboundedChannel* channel = lockfree ? unbounded_channel_lockfree() : unbounded_channel();
+
+        int msg1 = 5;
+        int msg2 = 6;
+        void* recv = NULL;
+
+        TEST_ASSERT_INT_EQ(unbounded_try_recv_c(channel, &recv), CHANNEL_EMPTY);
+        TEST_ASSERT_INT_EQ(unbounded_try_send_c(channel, &msg1), CHANNEL_SUCCESS);
+        TEST_ASSERT_INT_EQ(unbounded_try_send_c(channel, &msg2), CHANNEL_SUCCESS);
+        TEST_ASSERT_INT_EQ(unbounded_try_recv_c(channel, &recv), CHANNEL_SUCCESS);
+        TEST_ASSERT_INT_EQ(*((int*)(recv)), msg1);
+
+        UnboundedSender* sender = channel->sender;
+        free_unbounded_receiver(channel->receiver);
+        free_unbounded_channel_wrapper(channel);
+
+        TEST_ASSERT_INT_EQ(unbounded_try_send(sender, &msg1), CHANNEL_CLOSED);
+
+        free_unbounded_sender(sender);
+    }
+}
+
+// Helper for `test_unbounded_timeout`.
+void test_unbounded_timeout_helper(void* sender_vp)
+{
+    UnboundedSender* sender = (UnboundedSender*)sender_vp;
+
+    test_sleep(0.05);
+    TEST_ASSERT_INT_EQ(unbounded_send(sender, sender_vp), CHANNEL_SUCCESS);
+    free_unbounded_sender(sender);
+}
+
+// Test unbounded channel operations with timeouts and deadlines.
+void test_unbounded_timeout(void)
+{
+    for (int lockfree = 0; lockfree < 2; lockfree++) {
+        UnboundedChannel* channel = lockfree ? unbounded_channel_lockfree() : unbounded_channel();
+        UnboundedSender* sender = channel->sender;
+        UnboundedReceiver* receiver = channel->receiver;
+        free_unbounded_channel_wrapper(channel);
+
+        void* recv = NULL;
+        uint64_t start = channel_now();
+
+        TEST_ASSERT_INT_EQ(unbounded_recv_timeout(receiver, &recv, 0.02), CHANNEL_TIMEOUT);
+        TEST_ASSERT(channel_now() - start >= 20000000);
+        TEST_ASSERT_INT_EQ(unbounded_recv_deadline(receiver, &recv, channel_now()), CHANNEL_TIMEOUT);
+
+        JoinHandle* handle = thread_spawn(test_unbounded_timeout_helper, sender);
+
+        TEST_ASSERT_INT_EQ(unbounded_recv_timeout(receiver, &recv, 5.0), CHANNEL_SUCCESS);
+        TEST_ASSERT(recv == (void*)sender);
+        TEST_ASSERT_INT_EQ(unbounded_recv_timeout(receiver, &recv, 5.0), CHANNEL_CLOSED);
+
+        thread_join(handle);
+
+        free_unbounded_receiver(receiver);
+    }
+}
+
+// A receiver in a multi-consumer unbounded channel test, along with the total of
+// the messages it received.
+typedef struct UnboundedMpmcWorker_ {
+    UnboundedReceiver* receiver;
+    size_t total;
+} UnboundedMpmcWorker;
+
+// Helper for `test_unbounded_mpmc`.
+void test_unbounded_mpmc_sender_helper(void* sender_vp)
+{
+    UnboundedSender* sender = (UnboundedSender*)sender_vp;
+
+    for (size_t i = 1; i <= 10000; i++) {
+        TEST_ASSERT_INT_EQ(unbounded_send(sender, (void*)i), CHANNEL_SUCCESS);
+    }
+}
+
+// Helper for `test_unbounded_mpmc`.
+void test_unbounded_mpmc_receiver_helper(void* worker_vp)
+{
+    UnboundedMpmcWorker* worker = (UnboundedMpmcWorker*)worker_vp;
+    void* recv;
+
+    while ((recv = unbounded_recv(worker->receiver)) != NULL) {
+        worker->total += (size_t)recv;
+    }
+
+    free_unbounded_receiver(worker->receiver);
+}
+
+// Test a unbounded channel with many senders and many receivers.
+void test_unbounded_mpmc(void)
+{
+    UnboundedChannel* single = unbounded_channel_lockfree();
+    TEST_ASSERT(clone_unbounded_receiver(single->receiver) == NULL);
+    free_unbounded_channel(single);
+
+    UnboundedChannel* channel = unbounded_channel_mpmc();
+    UnboundedSender* sender = channel->sender;
+    UnboundedMpmcWorker workers[4];
+    JoinHandle* receiver_handles[4];
+    JoinHandle* sender_handles[4];
+
+    for (size_t i = 0; i < 4; i++) {
+        workers[i].receiver = i == 0 ? channel->receiver : clone_unbounded_receiver(channel->receiver);
+        workers[i].total = 0;
+        TEST_ASSERT(workers[i].receiver != NULL);
+    }
+
+    free_unbounded_channel_wrapper(channel);
+
+    for (size_t i = 0; i < 4; i++) {
+        receiver_handles[i] = thread_spawn(test_unbounded_mpmc_receiver_helper, &workers[i]);
+        sender_handles[i] = thread_spawn(test_unbounded_mpmc_sender_helper, sender);
+    }
+
+    for (size_t i = 0; i < 4; i++) {
+        thread_join(sender_handles[i]);
+    }
+
+    free_unbounded_sender(sender);
+
+    size_t total = 0;
+
+    for (size_t i = 0; i < 4; i++) {
+        thread_join(receiver_handles[i]);
+        total += workers[i].total;
+    }
+
+    TEST_ASSERT(total == (size_t)4 * 10000 * 10001 / 2);
+}
+
+// Helper for `test_unbounded_cloned_senders`.
+void test_unbounded_cloned_senders_helper(void* sender_vp)
+{
+    UnboundedSender* sender = (UnboundedSender*)sender_vp;
+
+    for (size_t i = 1; i <= 1000; i++) {
+        TEST_ASSERT_INT_EQ(unbounded_send(sender, (void*)i), CHANNEL_SUCCESS);
+    }
+
+    free_unbounded_sender(sender);
+}
+
+// Test that a unbounded channel stays open until every cloned sender is freed.
+void test_unbounded_cloned_senders(void)
+{
+    UnboundedChannel* channel = unbounded_channel();
+    UnboundedSender* sender = channel->sender;
+    UnboundedReceiver* receiver = channel->receiver;
+    free_unbounded_channel_wrapper(channel);
+
+    JoinHandle* handles[4];
+
+    for (size_t i = 0; i < 4; i++) {
+        handles[i] = thread_spawn(test_unbounded_cloned_senders_helper, clone_unbounded_sender(sender));
+    }
+
+    // Freeing the original sender first must not close the channel.
+    free_unbounded_sender(sender);
+
+    size_t total = 0;
+    void* recv;
+
+    while ((recv = unbounded_recv(receiver)) != NULL) {
+        total += (size_t)recv;
+    }
+
+    TEST_ASSERT(total == (size_t)4 * 1000 * 1001 / 2);
+
+    for (size_t i = 0; i < 4; i++) {
+        thread_join(handles[i]);
+    }
+
+    free_unbounded_receiver(receiver);
+}
+
+// Helper for `test_inline_fast_paths`.
+void test_inline_fast_paths_bounded_helper(void* sender_vp)
+{
+    BoundedSender* sender = (BoundedSender*)sender_vp;
+
+    for (size_t i = 1; i <= 10000; i++) {
+        TEST_ASSERT_INT_EQ(bounded_send_inline(sender, (void*)i), CHANNEL_SUCCESS);
+    }
+
+    free_bounded_sender(sender);
+}
+
+// Helper for `test_inline_fast_paths`.
+void test_inline_fast_paths_unbounded_helper(void* sender_vp)
+{
+    UnboundedSender* sender = (UnboundedSender*)sender_vp;
+
+    for (size_t i = 1; i <= 10000; i++) {
+        TEST_ASSERT_INT_EQ(unbounded_send_inline(sender, (void*)i), CHANNEL_SUCCESS);
+    }
+
+    free_unbounded_sender(sender);
+}
+
+// Test that the inline fast paths behave like the library functions, both
+// when they complete on their own and when they fall back.
+void test_inline_fast_paths(void)
+{
+    BoundedChannel* bounded_channels[3] = {
+        bounded_channel(3),
+        bounded_channel_lockfree(3),
+        bounded_channel_mpmc(4),
+    };
+
+    for (size_t c = 0; c < 3; c++) {
+        BoundedSender* sender = bounded_channels[c]->sender;
+        BoundedReceiver* receiver = bounded_channels[c]->receiver;
+        free_bounded_channel_wrapper(bounded_channels[c]);
+        void* recv;
+
+        TEST_ASSERT_INT_EQ(bounded_try_recv_inline(receiver, &recv), CHANNEL_EMPTY);
+
+        for (size_t lap = 0; lap < 10; lap++) {
+            size_t sent = 0;
+
+            while (bounded_try_send_inline(sender, (void*)(sent + 1)) == CHANNEL_SUCCESS) {
+                sent++;
+            }
+
+            TEST_ASSERT(sent == receiver->buffer->capacity);
+
+            for (size_t i = 1; i <= sent; i++) {
+                TEST_ASSERT(bounded_recv_inline(receiver) == (void*)i);
+            }
+        }
+
+        JoinHandle* handles[2];
+
+        for (size_t i = 0; i < 2; i++) {
+            handles[i] = thread_spawn(test_inline_fast_paths_bounded_helper, clone_bounded_sender(sender));
+        }
+
+        free_bounded_sender(sender);
+
+        size_t total = 0;
+
+        while ((recv = bounded_recv_inline(receiver)) != NULL) {
+            total += (size_t)recv;
+        }
+
+        TEST_ASSERT(total == (size_t)2 * 10000 * 10001 / 2);
+        TEST_ASSERT_INT_EQ(bounded_try_recv_inline(receiver, &recv), CHANNEL_CLOSED);
+
+        for (size_t i = 0; i < 2; i++) {
+            thread_join(handles[i]);
+        }
+
+        free_bounded_receiver(receiver);
+    }
+
+    UnboundedChannel* unbounded_channels[3] = {
+        unbounded_channel(),
+        unbounded_channel_lockfree(),
+        unbounded_channel_mpmc(),
+    };
+
+    for (size_t c = 0; c < 3; c++) {
+        UnboundedSender* sender = unbounded_channels[c]->sender;
+        UnboundedReceiver* receiver = unbounded_channels[c]->receiver;
+        free_unbounded_channel_wrapper(unbounded_channels[c]);
+        void* recv;
+
+        TEST_ASSERT_INT_EQ(unbounded_try_recv_inline(receiver, &recv), CHANNEL_EMPTY);
+
+        // Cross several block boundaries of the lock-free channel.
+        for (size_t i = 1; i <= 200; i++) {
+            TEST_ASSERT_INT_EQ(unbounded_try_send_inline(sender, (void*)i), CHANNEL_SUCCESS);
+        }
+
+        for (size_t i = 1; i <= 200; i++) {
+            TEST_ASSERT_INT_EQ(unbounded_try_recv_inline(receiver, &recv), CHANNEL_SUCCESS);
+            TEST_ASSERT(recv == (void*)i);
+        }
+
+        JoinHandle* handles[2];
+
+        for (size_t i = 0; i < 2; i++) {
+            handles[i] = thread_spawn(test_inline_fast_paths_unbounded_helper, clone_unbounded_sender(sender));
+        }
+
+        free_unbounded_sender(sender);
+
+        size_t total = 0;
+
+        while ((recv = unbounded_recv_inline(receiver)) != NULL) {
+            total += (size_t)recv;
+        }
+
+        TEST_ASSERT(total == (size_t)2 * 10000 * 10001 / 2);
+
+        for (size_t i = 0; i < 2; i++) {
+            thread_join(handles[i]);
+        }
+
+        free_unbounded_receiver(receiver);
+    }
+
+    // A closed channel is reported by the fallback.
+    UnboundedChannel* channel = unbounded_channel_lockfree();
+    UnboundedSender* sender = channel->sender;
+    free_unbounded_receiver(channel->receiver);
+    free_unbounded_channel_wrapper(channel);
+    TEST_ASSERT_INT_EQ(unbounded_send_inline(sender, NULL), CHANNEL_CLOSED);
+    free_unbounded_sender(sender);
+}
+
+// Helper for `test_lock_backends`.
+void test_lock_backends_bounded_helper(void* sender_vp)
+{
+    BoundedSender* sender = (BoundedSender*)sender_vp;
+
+    for (size_t i = 1; i <= 10000; i++) {
+        TEST_ASSERT_INT_EQ(bounded_send(sender, (void*)i), CHANNEL_SUCCESS);
+    }
+
+    free_bounded_sender(sender);
+}
+
+// Helper for `test_lock_backends`.
+void test_lock_backends_unbounded_helper(void* sender_vp)
+{
+    UnboundedSender* sender = (UnboundedSender*)sender_vp;
+
+    for (size_t i = 1; i <= 10000; i++) {
+        TEST_ASSERT_INT_EQ(unbounded_send(sender, (void*)i), CHANNEL_SUCCESS);
+    }
+
+    free_unbounded_sender(sender);
+}
+
+// Helper for `test_lock_backends`.
+void test_lock_backends_rendezvous_helper(void* sender_vp)
+{
+    RendezvousSender* sender = (RendezvousSender*)sender_vp;
+
+    for (size_t i = 1; i <= 100; i++) {
+        TEST_ASSERT_INT_EQ(rendezvous_send(sender, (void*)i), CHANNEL_SUCCESS);
+    }
+
+    free_rendezvous_sender(sender);
+}
+
+// Test channels created with each lock backend, and the options the
+// constructors reject.
+void test_lock_backends(void)
+{
+    int locks[3] = { CHANNEL_LOCK_DEFAULT, CHANNEL_LOCK_SPIN, CHANNEL_LOCK_ADAPTIVE };
+
+    for (size_t l = 0; l < 3; l++) {
+        ChannelOptions options = { locks[l], false, true };
+
+        // Several receivers share a mutex-protected ring.
+        BoundedChannel* bounded = bounded_channel_with(8, &options);
+        BoundedSender* bounded_sender = bounded->sender;
+        BoundedReceiver* bounded_receivers[2] = { bounded->receiver, clone_bounded_receiver(bounded->receiver) };
+        free_bounded_channel_wrapper(bounded);
+        TEST_ASSERT(bounded_receivers[1] != NULL);
+
+        JoinHandle* handles[3];
+
+        for (size_t i = 0; i < 3; i++) {
+            handles[i] = thread_spawn(test_lock_backends_bounded_helper, clone_bounded_sender(bounded_sender));
+        }
+
+        free_bounded_sender(bounded_sender);
+
+        size_t total = 0;
+        size_t turn = 0;
+        void* recv;
+
+        while ((recv = bounded_recv(bounded_receivers[turn++ % 2])) != NULL) {
+            total += (size_t)recv;
+        }
+
+        // The other receiver sees the channel closed as well.
+        TEST_ASSERT(bounded_recv(bounded_receivers[turn % 2]) == NULL);
+        TEST_ASSERT(total == (size_t)3 * 10000 * 10001 / 2);
+
+        for (size_t i = 0; i < 3; i++) {
+            thread_join(handles[i]);
+        }
+
+        free_bounded_receiver(bounded_receivers[0]);
+        free_bounded_receiver(bounded_receivers[1]);
+
+        options.multi_consumer = false;
+        UnboundedChannel* unbounded = unbounded_channel_with(&options);
+        UnboundedSender* unbounded_sender = unbounded->sender;
+        UnboundedReceiver* unbounded_receiver = unbounded->receiver;
+        free_unbounded_channel_wrapper(unbounded);
+
+        for (size_t i = 0; i < 3; i++) {
+            handles[i] = thread_spawn(test_lock_backends_unbounded_helper, clone_unbounded_sender(unbounded_sender));
+        }
+
+        free_unbounded_sender(unbounded_sender);
+        total = 0;
+
+        while ((recv = unbounded_recv(unbounded_receiver)) != NULL) {
+            total += (size_t)recv;
+        }
+
+        TEST_ASSERT(total == (size_t)3 * 10000 * 10001 / 2);
+
+        for (size_t i = 0; i < 3; i++) {
+            thread_join(handles[i]);
+        }
+
+        free_unbounded_receiver(unbounded_receiver);
+
+        RendezvousChannel* rendezvous = rendezvous_channel_with(&options);
+        RendezvousReceiver* rendezvous_receiver = rendezvous->receiver;
+        handles[0] = thread_spawn(test_lock_backends_rendezvous_helper, rendezvous->sender);
+        free_rendezvous_channel_wrapper(rendezvous);
+        total = 0;
+
+        while ((recv = rendezvous_recv(rendezvous_receiver)) != NULL) {
+            total += (size_t)recv;
+        }
+
+        TEST_ASSERT(total == (size_t)100 * 101 / 2);
+        thread_join(handles[0]);
+        free_rendezvous_receiver(rendezvous_receiver);
+    }
+
+    ChannelOptions unsupported = { CHANNEL_LOCK_DEFAULT, true, true };
+    TEST_ASSERT(unbounded_channel_with(&unsupported) == NULL);
+    TEST_ASSERT(rendezvous_channel_with(&unsupported) == NULL);
+    TEST_ASSERT(bounded_channel_with(0, NULL) == NULL);
+}
+
+// Helper for `test_spsc_bounded`.
+void test_spsc_bounded_helper(void* sender_vp)
+{
+    BoundedSender* sender = (BoundedSender*)sender_vp;
+    void* batch[5];
+
+    for (size_t i = 1; i <= 100000; i += 10) {
+        // Alternate between single sends, inline sends and batches.
+        for (size_t j = 0; j < 5; j++) {
+            TEST_ASSERT_INT_EQ(
+                j % 2 == 0 ? bounded_send(sender, (void*)(i + j)) : bounded_send_inline(sender, (void*)(i + j)),
+                CHANNEL_SUCCESS);
+            batch[j] = (void*)(i + 5 + j);
+        }
+
+        size_t sent;
+        TEST_ASSERT_INT_EQ(bounded_send_many(sender, batch, 5, &sent), CHANNEL_SUCCESS);
+        TEST_ASSERT(sent == 5);
+    }
+
+    free_bounded_sender(sender);
+}
+
+// Test that a single-producer bounded channel delivers every message in
+// order, and detects either side closing.
+void test_spsc_bounded(void)
+{
+    BoundedChannel* channel = spsc_bounded_channel(3);
+    BoundedSender* sender = channel->sender;
+    BoundedReceiver* receiver = channel->receiver;
+    free_bounded_channel_wrapper(channel);
+
+    TEST_ASSERT(spsc_bounded_channel(0) == NULL);
+    TEST_ASSERT(clone_bounded_sender(sender) == NULL);
+
+    void* recv;
+    TEST_ASSERT_INT_EQ(bounded_try_recv(receiver, &recv), CHANNEL_EMPTY);
+
+    for (size_t i = 1; i <= 3; i++) {
+        TEST_ASSERT_INT_EQ(bounded_try_send(sender, (void*)i), CHANNEL_SUCCESS);
+    }
+
+    TEST_ASSERT_INT_EQ(bounded_try_send(sender, (void*)4), CHANNEL_FULL);
+    TEST_ASSERT_INT_EQ(bounded_send_timeout(sender, (void*)4, 0.01), CHANNEL_TIMEOUT);
+
+    for (size_t i = 1; i <= 3; i++) {
+        TEST_ASSERT_INT_EQ(bounded_try_recv(receiver, &recv), CHANNEL_SUCCESS);
+        TEST_ASSERT(recv == (void*)i);
+    }
+
+    JoinHandle* handle = thread_spawn(test_spsc_bounded_helper, sender);
+    size_t expected = 1;
+    void* batch[4];
+    size_t received;
+
+    while (expected <= 100000) {
+        if (expected % 3 == 0) {
+            TEST_ASSERT_INT_EQ(bounded_recv_many(receiver, batch, 4, &received), CHANNEL_SUCCESS);
+
+            for (size_t i = 0; i < received; i++) {
+                TEST_ASSERT(batch[i] == (void*)expected);
+                expected++;
+            }
+        }
+        else {
+            recv = expected % 3 == 1 ? bounded_recv(receiver) : bounded_recv_inline(receiver);
+            TEST_ASSERT(recv == (void*)expected);
+            expected++;
+        }
+    }
+
+    TEST_ASSERT(bounded_recv(receiver) == NULL);
+    TEST_ASSERT_INT_EQ(bounded_try_recv(receiver, &recv), CHANNEL_CLOSED);
+    thread_join(handle);
+    free_bounded_receiver(receiver);
+
+    channel = spsc_bounded_channel(4);
+    free_bounded_receiver(channel->receiver);
+    TEST_ASSERT_INT_EQ(bounded_send_c(channel, NULL), CHANNEL_CLOSED);
+    free_bounded_sender(channel->sender);
+    free_bounded_channel_wrapper(channel);
+}
+
+// Helper for `test_spsc_unbounded`.
+void test_spsc_unbounded_helper(void* sender_vp)
+{
+    UnboundedSender* sender = (UnboundedSender*)sender_vp;
+    void* batch[100];
+
+    for (size_t i = 1; i <= 100000; i += 200) {
+        for (size_t j = 0; j < 100; j++) {
+            TEST_ASSERT_INT_EQ(
+                j % 2 == 0 ? unbounded_send(sender, (void*)(i + j)) : unbounded_send_inline(sender, (void*)(i + j)),
+                CHANNEL_SUCCESS);
+            batch[j] = (void*)(i + 100 + j);
+        }
+
+        TEST_ASSERT_INT_EQ(unbounded_send_many(sender, batch, 100, NULL), CHANNEL_SUCCESS);
+    }
+
+    free_unbounded_sender(sender);
+}
+
+// Test that a single-producer unbounded channel delivers every message in
+// order across many blocks, and detects either side closing.
+void test_spsc_unbounded(void)
+{
+    UnboundedChannel* channel = spsc_unbounded_channel();
+    UnboundedSender* sender = channel->sender;
+    UnboundedReceiver* receiver = channel->receiver;
+    free_unbounded_channel_wrapper(channel);
+
+    TEST_ASSERT(clone_unbounded_sender(sender) == NULL);
+
+    void* recv;
+    TEST_ASSERT_INT_EQ(unbounded_try_recv(receiver, &recv), CHANNEL_EMPTY);
+
+    JoinHandle* handle = thread_spawn(test_spsc_unbounded_helper, sender);
+    size_t expected = 1;
+    void* batch[50];
+    size_t received;
+
+    while (expected <= 100000) {
+        if (expected % 2 == 0) {
+            TEST_ASSERT_INT_EQ(unbounded_recv_many(receiver, batch, 50, &received), CHANNEL_SUCCESS);
+
+            for (size_t i = 0; i < received; i++) {
+                TEST_ASSERT(batch[i] == (void*)expected);
+                expected++;
+            }
+        }
+        else {
+            recv = unbounded_recv_inline(receiver);
+            TEST_ASSERT(recv == (void*)expected);
+            expected++;
+        }
+    }
+
+    TEST_ASSERT(unbounded_recv(receiver) == NULL);
+    thread_join(handle);
+    free_unbounded_receiver(receiver);
+
+    // Messages left in the channel are freed along with it.
+    channel = spsc_unbounded_channel();
+
+    for (size_t i = 0; i < 1000; i++) {
+        TEST_ASSERT_INT_EQ(unbounded_send_c(channel, NULL), CHANNEL_SUCCESS);
+    }
+
+    free_unbounded_receiver(channel->receiver);
+    TEST_ASSERT_INT_EQ(unbounded_send_c(channel, NULL), CHANNEL_CLOSED);
+    free_unbounded_sender(channel->sender);
+    free_unbounded_channel_wrapper(channel);
+}
+
+// The context of the allocator used by `test_allocator`, which counts the
+// calls made to it and the bytes outstanding.
+typedef struct TestAllocatorCounts_ {
+    atomic_size_t allocations;
+    atomic_size_t deallocations;
+    atomic_size_t bytes;
+} TestAllocatorCounts;
+
+// Helper for `test_allocator`.
+void* test_allocator_allocate(void* counts_vp, size_t size, size_t alignment)
+{
+    TestAllocatorCounts* counts = (TestAllocatorCounts*)counts_vp;
+    atomic_fetch_add(&counts->allocations, 1);
+    atomic_fetch_add(&counts->bytes, size);
+
+    TEST_ASSERT(alignment != 0 && (alignment & (alignment - 1)) == 0 && alignment <= CHANNEL_CACHE_LINE);
+
+    void* pointer = channel_aligned_alloc(alignment < sizeof(void*) ? sizeof(void*) : alignment, size);
+    TEST_ASSERT(pointer != NULL);
+    TEST_ASSERT(((uintptr_t)pointer & (alignment - 1)) == 0);
+
+    return pointer;
+}
+
+// Helper for `test_allocator`.
+void test_allocator_deallocate(void* counts_vp, void* pointer, size_t size)
+{
+    TestAllocatorCounts* counts = (TestAllocatorCounts*)counts_vp;
+    atomic_fetch_add(&counts->deallocations, 1);
+    atomic_fetch_sub(&counts->bytes, size);
+    channel_aligned_free(pointer);
+}
+
+// Helper for `test_allocator`.
+void test_allocator_helper(void* sender_vp)
+{
+    UnboundedSender* sender = (UnboundedSender*)sender_vp;
+
+    for (size_t i = 1; i <= 100000; i++) {
+        TEST_ASSERT_INT_EQ(
+            i % 2 == 0 ? unbounded_send(sender, (void*)i) : unbounded_send_inline(sender, (void*)i),
+            CHANNEL_SUCCESS);
+    }
+
+    free_unbounded_sender(sender);
+}
+
+// Test that every kind of channel allocates the memory it owns with the
+// allocator it was created with, and frees all of it with the right sizes,
+// and that unbounded channels recycle their message nodes.
+void test_allocator(void)
+{
+    TestAllocatorCounts counts;
+    atomic_init(&counts.allocations, 0);
+    atomic_init(&counts.deallocations, 0);
+    atomic_init(&counts.bytes, 0);
+
+    ChannelAllocator allocator = { test_allocator_allocate, test_allocator_deallocate, &counts };
+    bool lockfree[3] = { false, true, false };
+    bool single_producer[3] = { false, false, true };
+    ChannelOptions options = { CHANNEL_LOCK_DEFAULT, false, false, false, &allocator };
+
+    RendezvousChannel* rendezvous = rendezvous_channel_with(&options);
+    TEST_ASSERT(atomic_load(&counts.allocations) == 1);
+    free_rendezvous_channel(rendezvous);
+    TEST_ASSERT(atomic_load(&counts.deallocations) == 1);
+
+    for (size_t k = 0; k < 3; k++) {
+        options.lockfree = lockfree[k];
+        options.single_producer = single_producer[k];
+        size_t before = atomic_load(&counts.allocations);
+
+        BoundedChannel* bounded = bounded_channel_with(5, &options);
+        TEST_ASSERT(atomic_load(&counts.allocations) == before + 2);
+
+        for (size_t i = 1; i <= 20; i++) {
+            TEST_ASSERT_INT_EQ(bounded_send_c(bounded, (void*)i), CHANNEL_SUCCESS);
+            TEST_ASSERT(bounded_recv_c(bounded) == (void*)i);
+        }
+
+        free_bounded_channel(bounded);
+
+        // Messages left in the channel are freed along with it, whether
+        // they are in a block or in nodes of their own.
+        UnboundedChannel* unbounded = unbounded_channel_with(&options);
+
+        for (size_t i = 1; i <= 1000; i++) {
+            TEST_ASSERT_INT_EQ(unbounded_send_c(unbounded, (void*)i), CHANNEL_SUCCESS);
+        }
+
+        for (size_t i = 1; i <= 500; i++) {
+            TEST_ASSERT(unbounded_recv_c(unbounded) == (void*)i);
+        }
+
+        free_unbounded_channel(unbounded);
+
+        TEST_ASSERT(atomic_load(&counts.allocations) == atomic_load(&counts.deallocations));
+        TEST_ASSERT(atomic_load(&counts.bytes) == 0);
+    }
+
+    // Once the first batch of nodes has been received, a steady stream of
+    // messages through an unbounded channel reuses the same nodes.
+    options.lockfree = false;
+    options.single_producer = false;
+    UnboundedChannel* channel = unbounded_channel_with(&options);
+    size_t before = atomic_load(&counts.allocations);
+
+    for (size_t i = 1; i <= 10000; i++) {
+        TEST_ASSERT_INT_EQ(
+            i % 2 == 0 ? unbounded_send_c(channel, (void*)i) : unbounded_send_inline(channel->sender, (void*)i),
+            CHANNEL_SUCCESS);
+        TEST_ASSERT(
+            (i % 3 == 0 ? unbounded_recv_c(channel) : unbounded_recv_inline(channel->receiver)) == (void*)i);
+    }
+
+    TEST_ASSERT(atomic_load(&counts.allocations) - before <= UNBOUNDED_NODE_BATCH);
+
+    // The same holds across threads, and with nodes still in flight when the
+    // halves are freed.
+    JoinHandle* handle = thread_spawn(test_allocator_helper, channel->sender);
+    UnboundedReceiver* receiver = channel->receiver;
+    free_unbounded_channel_wrapper(channel);
+
+    for (size_t i = 1; i <= 90000; i++) {
+        TEST_ASSERT(unbounded_recv(receiver) == (void*)i);
+    }
+
+    thread_join(handle);
+    free_unbounded_receiver(receiver);
+
+    TEST_ASSERT(atomic_load(&counts.allocations) == atomic_load(&counts.deallocations));
+    TEST_ASSERT(atomic_load(&counts.bytes) == 0);
+}
+
+// A value larger than a pointer, for `test_bounded_sized`.
+typedef struct TestPoint_ {
+    size_t index;
+    double position[3];
+    char label[12];
+} TestPoint;
+
+CHANNEL_DEFINE_BOUNDED(TestPoint, TestPoint)
+
+// Helper for `test_bounded_sized`.
+void test_bounded_sized_helper(void* sender_vp)
+{
+    BoundedSender* sender = (BoundedSender*)sender_vp;
+    TestPoint batch[10];
+
+    for (size_t i = 0; i < 10000; i += 20) {
+        for (size_t j = 0; j < 10; j++) {
+            TestPoint point = { i + j, { (double)(i + j), 0.5, -1.0 }, "point" };
+            TEST_ASSERT_INT_EQ(bounded_send_value(sender, &point), CHANNEL_SUCCESS);
+
+            batch[j] = point;
+            batch[j].index += 10;
+        }
+
+        TEST_ASSERT_INT_EQ(bounded_send_values(sender, batch, 10, NULL), CHANNEL_SUCCESS);
+    }
+
+    free_bounded_sender(sender);
+}
+
+// Helper for `test_bounded_sized`.
+void test_bounded_sized_typed_helper(void* sender_vp)
+{
+    TestPointSender sender = { (BoundedSender*)sender_vp };
+
+    for (size_t i = 0; i < 1000; i++) {
+        TestPoint point = { i, { 0.0, 0.0, 0.0 }, "typed" };
+        TEST_ASSERT_INT_EQ(TestPoint_send(sender, point), CHANNEL_SUCCESS);
+    }
+
+    TestPoint_free_sender(sender);
+}
+
+// Test that sized bounded channels copy values through every kind of ring,
+// in order and intact, and that the typed wrappers work.
+void test_bounded_sized(void)
+{
+    TEST_ASSERT(bounded_channel_sized(0, sizeof(TestPoint)) == NULL);
+    TEST_ASSERT(bounded_channel_sized(4, 0) == NULL);
+
+    bool lockfree[4] = { false, true, true, false };
+    bool multi_consumer[4] = { false, false, true, false };
+    bool single_producer[4] = { false, false, false, true };
+
+    for (size_t k = 0; k < 4; k++) {
+        ChannelOptions options = { CHANNEL_LOCK_DEFAULT, lockfree[k], multi_consumer[k], single_producer[k], NULL };
+
+        // A capacity that is not a power of two makes the batches wrap
+        // around the end of the ring at varying offsets.
+        BoundedChannel* channel = bounded_channel_sized_with(7, sizeof(TestPoint), &options);
+        TEST_ASSERT(channel != NULL);
+
+        TestPoint point;
+        TEST_ASSERT_INT_EQ(bounded_try_recv_value_c(channel, &point), CHANNEL_EMPTY);
+        TEST_ASSERT_INT_EQ(bounded_recv_value_timeout_c(channel, &point, 0.01), CHANNEL_TIMEOUT);
+
+        JoinHandle* handle = thread_spawn(test_bounded_sized_helper, channel->sender);
+        BoundedReceiver* receiver = channel->receiver;
+        free_bounded_channel_wrapper(channel);
+
+        size_t expected = 0;
+        TestPoint batch[8];
+        size_t received;
+
+        while (expected < 10000) {
+            if (expected % 3 == 0) {
+                TEST_ASSERT_INT_EQ(bounded_recv_values(receiver, batch, 8, &received), CHANNEL_SUCCESS);
+            }
+            else {
+                TEST_ASSERT_INT_EQ(bounded_recv_value(receiver, &batch[0]), CHANNEL_SUCCESS);
+                received = 1;
+            }
+
+            for (size_t i = 0; i < received; i++) {
+                TEST_ASSERT(batch[i].index == expected);
+                TEST_ASSERT((size_t)batch[i].position[0] == expected - expected % 20 + expected % 10);
+                TEST_ASSERT_STR_EQ(batch[i].label, "point");
+                expected++;
+            }
+        }
+
+        TEST_ASSERT_INT_EQ(bounded_recv_value(receiver, &point), CHANNEL_CLOSED);
+        thread_join(handle);
+        free_bounded_receiver(receiver);
+    }
+
+    // A full channel rejects values without blocking, and the value does not
+    // need to outlive the send.
+    BoundedChannel* channel = bounded_channel_sized(2, sizeof(size_t));
+
+    for (size_t i = 0; i < 2; i++) {
+        size_t value = i + 100;
+        TEST_ASSERT_INT_EQ(bounded_try_send_value_c(channel, &value), CHANNEL_SUCCESS);
+        value = 0;
+    }
+
+    size_t value = 0;
+    TEST_ASSERT_INT_EQ(bounded_try_send_value_c(channel, &value), CHANNEL_FULL);
+    TEST_ASSERT_INT_EQ(bounded_send_value_timeout_c(channel, &value, 0.01), CHANNEL_TIMEOUT);
+    TEST_ASSERT_INT_EQ(bounded_try_recv_value_c(channel, &value), CHANNEL_SUCCESS);
+    TEST_ASSERT(value == 100);
+    TEST_ASSERT_INT_EQ(bounded_recv_value_c(channel, &value), CHANNEL_SUCCESS);
+    TEST_ASSERT(value == 101);
+    free_bounded_channel(channel);
+
+    TestPointChannel typed = TestPoint_channel(16);
+    JoinHandle* handle = thread_spawn(test_bounded_sized_typed_helper, TestPoint_clone_sender(typed.sender).half);
+    TestPoint_free_sender(typed.sender);
+
+    for (size_t i = 0; i < 1000; i++) {
+        TestPoint point;
+        TEST_ASSERT_INT_EQ(TestPoint_recv(typed.receiver, &point), CHANNEL_SUCCESS);
+        TEST_ASSERT(point.index == i);
+        TEST_ASSERT_STR_EQ(point.label, "typed");
+    }
+
+    TestPoint point;
+    TEST_ASSERT_INT_EQ(TestPoint_recv(typed.receiver, &point), CHANNEL_CLOSED);
+    thread_join(handle);
+    TestPoint_free_receiver(typed.receiver);
+}
+
+// Helper for `test_channel_stats`.
+void test_channel_stats_helper(void* sender_vp)
+{
+    RendezvousSender* sender = (RendezvousSender*)sender_vp;
+    TEST_ASSERT_INT_EQ(rendezvous_send(sender, NULL), CHANNEL_SUCCESS);
+}
+
+// Test that the counters of a channel follow its traffic when the library is
+// built with `CHANNEL_STATS`, and stay zero otherwise.
+void test_channel_stats(void)
+{
+    ChannelStats stats;
+    BoundedChannel* bounded = bounded_channel(8);
+
+    for (size_t i = 0; i < 5; i++) {
+        TEST_ASSERT_INT_EQ(bounded_send_c(bounded, NULL), CHANNEL_SUCCESS);
+    }
+
+    void* messages[4];
+    size_t received;
+    TEST_ASSERT_INT_EQ(bounded_recv_many_c(bounded, messages, 2, &received), CHANNEL_SUCCESS);
+    bool counting = channel_stats(bounded->sender, &stats);
+
+    if (counting) {
+        TEST_ASSERT(stats.sent == 5);
+        TEST_ASSERT(stats.received == 2);
+        TEST_ASSERT(stats.depth == 3);
+        TEST_ASSERT(stats.max_depth == 5);
+        TEST_ASSERT(stats.recv_waits == 0);
+    }
+
+    TEST_ASSERT_INT_EQ(bounded_recv_many_c(bounded, messages, 4, &received), CHANNEL_SUCCESS);
+    void* message;
+    TEST_ASSERT_INT_EQ(bounded_recv_timeout_c(bounded, &message, 0.01), CHANNEL_TIMEOUT);
+    TEST_ASSERT(channel_stats(bounded->receiver, &stats) == counting);
+
+    if (counting) {
+        TEST_ASSERT(stats.received == 5);
+        TEST_ASSERT(stats.depth == 0);
+        TEST_ASSERT(stats.recv_waits > 0);
+        TEST_ASSERT(stats.recv_blocked_ns > 0);
+        TEST_ASSERT(stats.send_waits == 0);
+    }
+    else {
+        TEST_ASSERT(stats.sent == 0 && stats.received == 0 && stats.max_depth == 0);
+        TEST_ASSERT(stats.recv_waits == 0 && stats.recv_blocked_ns == 0);
+    }
+
+    free_bounded_channel(bounded);
+
+    // Failed non-blocking calls on a mutex-protected channel never wait.
+    bounded = bounded_channel(1);
+    UnboundedChannel* locked = unbounded_channel();
+    TEST_ASSERT_INT_EQ(bounded_send_c(bounded, NULL), CHANNEL_SUCCESS);
+
+    for (size_t i = 0; i < 5; i++) {
+        TEST_ASSERT_INT_EQ(bounded_try_send_c(bounded, NULL), CHANNEL_FULL);
+        TEST_ASSERT_INT_EQ(unbounded_try_recv_c(locked, &message), CHANNEL_EMPTY);
+    }
+
+    TEST_ASSERT(bounded_recv_c(bounded) == NULL);
+
+    for (size_t i = 0; i < 5; i++) {
+        TEST_ASSERT_INT_EQ(bounded_try_recv_c(bounded, &message), CHANNEL_EMPTY);
+    }
+
+    TEST_ASSERT(channel_stats(bounded->sender, &stats) == counting);
+    TEST_ASSERT(stats.send_waits == 0 && stats.recv_waits == 0);
+    TEST_ASSERT(channel_stats(locked->receiver, &stats) == counting);
+    TEST_ASSERT(stats.recv_waits == 0);
+    free_bounded_channel(bounded);
+    free_unbounded_channel(locked);
+
+    ChannelOptions options = { CHANNEL_LOCK_DEFAULT, true, false, false, NULL };
+    UnboundedChannel* unbounded = unbounded_channel_with(&options);
+
+    for (size_t i = 0; i < 3; i++) {
+        TEST_ASSERT_INT_EQ(unbounded_send_c(unbounded, NULL), CHANNEL_SUCCESS);
+    }
+
+    TEST_ASSERT_INT_EQ(unbounded_try_recv_c(unbounded, &message), CHANNEL_SUCCESS);
+    TEST_ASSERT(channel_stats(unbounded->receiver, &stats) == counting);
+    TEST_ASSERT(stats.sent == (counting ? 3 : 0));
+    TEST_ASSERT(stats.received == (counting ? 1 : 0));
+    TEST_ASSERT(stats.depth == (counting ? 2 : 0));
+    free_unbounded_channel(unbounded);
+
+    // One side of a rendezvous always waits for the other.
+    RendezvousChannel* rendezvous = rendezvous_channel();
+    JoinHandle* handle = thread_spawn(test_channel_stats_helper, rendezvous->sender);
+    TEST_ASSERT_INT_EQ(rendezvous_recv_timeout_c(rendezvous, &message, 1.0), CHANNEL_SUCCESS);
+    thread_join(handle);
+    TEST_ASSERT(channel_stats(rendezvous->sender, &stats) == counting);
+    TEST_ASSERT(stats.sent == (counting ? 1 : 0));
+    TEST_ASSERT(stats.received == (counting ? 1 : 0));
+    TEST_ASSERT(stats.send_waits + stats.recv_waits == (counting ? 1 : 0));
+    free_rendezvous_channel(rendezvous);
+}
+
+// Test that channels created with `trace_latency` time their messages from
+// send to receive, whatever their kind, and that the histograms can be read
+// and reset.
+void test_channel_latency(void)
+{
+    TEST_ASSERT(channel_latency_bucket_min(0) == 0);
+    TEST_ASSERT(channel_latency_bucket_min(CHANNEL_LATENCY_SUB_BUCKETS) == CHANNEL_LATENCY_SUB_BUCKETS);
+    TEST_ASSERT(channel_latency_bucket_min(CHANNEL_LATENCY_BUCKETS - 1) == (uint64_t)15 << 60);
+
+    for (size_t i = 1; i < CHANNEL_LATENCY_BUCKETS; i++) {
+        TEST_ASSERT(channel_latency_bucket_min(i) > channel_latency_bucket_min(i - 1));
+    }
+
+    ChannelOptions traced = { CHANNEL_LOCK_DEFAULT, false, false, false, NULL, true };
+    TEST_ASSERT(rendezvous_channel_with(&traced) == NULL);
+
+    bool lockfree[3] = { false, true, false };
+    bool single_producer[3] = { false, false, true };
+    ChannelLatency latency;
+    void* messages[4];
+    size_t received;
+
+    for (size_t k = 0; k < 3; k++) {
+        ChannelOptions options = { CHANNEL_LOCK_DEFAULT, lockfree[k], false, single_producer[k], NULL, true };
+        BoundedChannel* bounded = bounded_channel_with(3, &options);
+        UnboundedChannel* unbounded = unbounded_channel_with(&options);
+
+        TEST_ASSERT(channel_latency(bounded->sender, &latency));
+        TEST_ASSERT(latency.count == 0);
+
+        // The messages wrap around the end of the ring.
+        TEST_ASSERT_INT_EQ(bounded_send_c(bounded, NULL), CHANNEL_SUCCESS);
+        TEST_ASSERT(bounded_recv_c(bounded) == NULL);
+        TEST_ASSERT_INT_EQ(bounded_send_many_c(bounded, messages, 2, NULL), CHANNEL_SUCCESS);
+        TEST_ASSERT_INT_EQ(bounded_send_inline(bounded->sender, NULL), CHANNEL_SUCCESS);
+        TEST_ASSERT_INT_EQ(unbounded_send_many_c(unbounded, messages, 2, NULL), CHANNEL_SUCCESS);
+        TEST_ASSERT_INT_EQ(unbounded_send_inline(unbounded->sender, NULL), CHANNEL_SUCCESS);
+        test_sleep(0.01);
+
+        TEST_ASSERT_INT_EQ(bounded_recv_many_c(bounded, messages, 4, &received), CHANNEL_SUCCESS);
+        TEST_ASSERT(received == 3);
+        TEST_ASSERT(channel_latency(bounded->receiver, &latency));
+        TEST_ASSERT(latency.count == 4);
+        TEST_ASSERT(latency.max_ns >= 10000000);
+        TEST_ASSERT(latency.min_ns <= latency.max_ns);
+        TEST_ASSERT(latency.total_ns >= 30000000);
+        TEST_ASSERT(channel_latency_percentile(&latency, 25) <= channel_latency_percentile(&latency, 99));
+        TEST_ASSERT(channel_latency_percentile(&latency, 99) >= 10000000);
+        TEST_ASSERT(channel_latency_percentile(&latency, 100) == latency.max_ns);
+
+        TEST_ASSERT_INT_EQ(unbounded_recv_many_c(unbounded, messages, 4, &received), CHANNEL_SUCCESS);
+        TEST_ASSERT(received == 3);
+        TEST_ASSERT(channel_latency(unbounded->sender, &latency));
+        TEST_ASSERT(latency.count == 3);
+        TEST_ASSERT(latency.min_ns >= 10000000);
+        TEST_ASSERT(channel_latency_percentile(&latency, 50) >= latency.min_ns);
+
+        channel_latency_reset(bounded->receiver);
+        channel_latency_reset(unbounded->receiver);
+        TEST_ASSERT(channel_latency(bounded->sender, &latency));
+        TEST_ASSERT(latency.count == 0 && latency.max_ns == 0);
+        TEST_ASSERT(channel_latency_percentile(&latency, 50) == 0);
+        TEST_ASSERT(channel_latency(unbounded->sender, &latency));
+        TEST_ASSERT(latency.count == 0);
+
+        free_bounded_channel(bounded);
+        free_unbounded_channel(unbounded);
+    }
+
+    // Channels that do not trace latency have no histogram.
+    BoundedChannel* bounded = bounded_channel(4);
+    TEST_ASSERT_INT_EQ(bounded_send_c(bounded, NULL), CHANNEL_SUCCESS);
+    TEST_ASSERT(bounded_recv_c(bounded) == NULL);
+    TEST_ASSERT(!channel_latency(bounded->receiver, &latency));
+    TEST_ASSERT(latency.count == 0);
+    channel_latency_reset(bounded->receiver);
+    free_bounded_channel(bounded);
+}
+
+#ifdef __linux__
+// Returns whether a file descriptor is readable, waiting for at most
+// `timeout` seconds. Helper for `test_receiver_fd`.
+bool test_fd_readable(int fd, double timeout)
+{
+    struct pollfd pfd = { fd, POLLIN, 0 };
+
+    return poll(&pfd, 1, (int)(timeout * 1000)) == 1;
+}
+#endif
+
+// Helper for `test_receiver_fd`.
+void test_receiver_fd_bounded_helper(void* sender_vp)
+{
+    BoundedSender* sender = (BoundedSender*)sender_vp;
+    test_sleep(0.05);
+    TEST_ASSERT_INT_EQ(bounded_send(sender, NULL), CHANNEL_SUCCESS);
+}
+
+// Helper for `test_receiver_fd`.
+void test_receiver_fd_unbounded_helper(void* sender_vp)
+{
+    UnboundedSender* sender = (UnboundedSender*)sender_vp;
+    test_sleep(0.05);
+    TEST_ASSERT_INT_EQ(unbounded_send(sender, NULL), CHANNEL_SUCCESS);
+}
+
+// Receives up to `max` messages without waiting from whichever of the two
+// channels is not NULL. Helper for `test_receiver_fd`.
+int test_receiver_fd_recv(BoundedChannel* bounded, UnboundedChannel* unbounded, size_t max, size_t* received)
+{
+    void* messages[4];
+
+    if (bounded != NULL) {
+        return bounded_recv_many_timeout_c(bounded, messages, max, received, 0);
+    }
+
+    return unbounded_recv_many_timeout_c(unbounded, messages, max, received, 0);
+}
+
+// Test that the event descriptor of a receiver is signaled once when the
+// channel becomes non-empty and when it is closed, and is reset by finding
+// the channel empty.
+void test_receiver_fd(void)
+{
+    bool lockfree[3] = { false, true, false };
+    bool single_producer[3] = { false, false, true };
+
+    for (size_t k = 0; k < 6; k++) {
+        ChannelOptions options = { CHANNEL_LOCK_DEFAULT, lockfree[k % 3], false, single_producer[k % 3], NULL };
+        BoundedChannel* bounded = k < 3 ? bounded_channel_with(4, &options) : NULL;
+        UnboundedChannel* unbounded = k < 3 ? NULL : unbounded_channel_with(&options);
+        int fd = bounded != NULL ? channel_receiver_fd(bounded->receiver) : channel_receiver_fd(unbounded->receiver);
+
+#ifdef __linux__
+        TEST_ASSERT(fd >= 0);
+        int again = bounded != NULL ? bounded_receiver_fd(bounded->receiver) : unbounded_receiver_fd(unbounded->receiver);
+        TEST_ASSERT_INT_EQ(again, fd);
+
+        // A new descriptor is readable until the channel is found empty.
+        size_t received;
+        TEST_ASSERT(test_fd_readable(fd, 0));
+        TEST_ASSERT_INT_EQ(test_receiver_fd_recv(bounded, unbounded, 1, &received), CHANNEL_TIMEOUT);
+        TEST_ASSERT(!test_fd_readable(fd, 0));
+
+        // Several messages signal the descriptor once.
+        for (size_t i = 0; i < 3; i++) {
+            if (bounded != NULL) {
+                TEST_ASSERT_INT_EQ(bounded_send_c(bounded, NULL), CHANNEL_SUCCESS);
+            }
+            else {
+                TEST_ASSERT_INT_EQ(unbounded_send_c(unbounded, NULL), CHANNEL_SUCCESS);
+            }
+        }
+
+        uint64_t signals = 0;
+        TEST_ASSERT(test_fd_readable(fd, 0));
+        TEST_ASSERT(read(fd, &signals, sizeof(signals)) == sizeof(signals));
+        TEST_ASSERT(signals == 1);
+
+        TEST_ASSERT_INT_EQ(test_receiver_fd_recv(bounded, unbounded, 4, &received), CHANNEL_SUCCESS);
+        TEST_ASSERT(received == 3);
+        TEST_ASSERT_INT_EQ(test_receiver_fd_recv(bounded, unbounded, 4, &received), CHANNEL_TIMEOUT);
+        TEST_ASSERT(!test_fd_readable(fd, 0));
+
+        // A message sent by another thread wakes a poll on the descriptor.
+        JoinHandle* handle = bounded != NULL
+            ? thread_spawn(test_receiver_fd_bounded_helper, bounded->sender)
+            : thread_spawn(test_receiver_fd_unbounded_helper, unbounded->sender);
+        TEST_ASSERT(test_fd_readable(fd, 5));
+        thread_join(handle);
+        TEST_ASSERT_INT_EQ(test_receiver_fd_recv(bounded, unbounded, 4, &received), CHANNEL_SUCCESS);
+        TEST_ASSERT(received == 1);
+        TEST_ASSERT_INT_EQ(test_receiver_fd_recv(bounded, unbounded, 4, &received), CHANNEL_TIMEOUT);
+        TEST_ASSERT(!test_fd_readable(fd, 0));
+
+        // Closing the channel signals it too.
+        if (bounded != NULL) {
+            free_bounded_sender(bounded->sender);
+        }
+        else {
+            free_unbounded_sender(unbounded->sender);
+        }
+
+        TEST_ASSERT(test_fd_readable(fd, 0));
+        TEST_ASSERT_INT_EQ(test_receiver_fd_recv(bounded, unbounded, 4, &received), CHANNEL_CLOSED);
+
+        if (bounded != NULL) {
+            free_bounded_receiver(bounded->receiver);
+            free_bounded_channel_wrapper(bounded);
+        }
+        else {
+            free_unbounded_receiver(unbounded->receiver);
+            free_unbounded_channel_wrapper(unbounded);
+        }
+#else
+        TEST_ASSERT_INT_EQ(fd, -1);
+
+        if (bounded != NULL) {
+            free_bounded_channel(bounded);
+        }
+        else {
+            free_unbounded_channel(unbounded);
+        }
+#endif
+    }
+}
+
+// The number of messages sent through each channel in `test_wait_policies`.
+#define TEST_WAIT_POLICY_MESSAGES 2000
+
+// Helper for `test_wait_policies`.
+void test_wait_policies_bounded_helper(void* sender_vp)
+{
+    BoundedSender* sender = (BoundedSender*)sender_vp;
+
+    for (size_t i = 1; i <= TEST_WAIT_POLICY_MESSAGES; i++) {
+        TEST_ASSERT_INT_EQ(bounded_send(sender, (void*)i), CHANNEL_SUCCESS);
+    }
+}
+
+// Helper for `test_wait_policies`.
+void test_wait_policies_unbounded_helper(void* sender_vp)
+{
+    UnboundedSender* sender = (UnboundedSender*)sender_vp;
+
+    for (size_t i = 1; i <= TEST_WAIT_POLICY_MESSAGES; i++) {
+        TEST_ASSERT_INT_EQ(unbounded_send(sender, (void*)i), CHANNEL_SUCCESS);
+
+        if (i % 256 == 0) {
+            // Let the receiver catch up and wait for more.
+            test_sleep(0.001);
+        }
+    }
+}
+
+void test_wait_policies(void)
+{
+    int policies[4] = { CHANNEL_WAIT_POWER_SAVING, CHANNEL_WAIT_THROUGHPUT, CHANNEL_WAIT_LATENCY, 42 };
+    bool lockfree[3] = { false, true, false };
+    bool single_producer[3] = { false, false, true };
+
+    for (size_t p = 0; p < 4; p++) {
+        for (size_t k = 0; k < 5; k++) {
+            ChannelOptions options = {
+                CHANNEL_LOCK_DEFAULT, lockfree[k % 3], false, single_producer[k % 3], NULL, false, policies[p]
+            };
+            BoundedChannel* bounded = k < 3 ? bounded_channel_with(4, &options) : NULL;
+            UnboundedChannel* unbounded = k < 3 ? NULL : unbounded_channel_with(&options);
+            JoinHandle* handle = bounded != NULL
+                ? thread_spawn(test_wait_policies_bounded_helper, bounded->sender)
+                : thread_spawn(test_wait_policies_unbounded_helper, unbounded->sender);
+
+            // Every message arrives in order, whether the receiver spun or
+            // parked while waiting for it.
+            for (size_t i = 1; i <= TEST_WAIT_POLICY_MESSAGES; i++) {
+                void* message = bounded != NULL ? bounded_recv(bounded->receiver) : unbounded_recv(unbounded->receiver);
+                TEST_ASSERT(message == (void*)i);
+            }
+
+            thread_join(handle);
+
+            // A receiver waiting with a deadline still times out.
+            void* message = NULL;
+            int result = bounded != NULL
+                ? bounded_recv_timeout(bounded->receiver, &message, 0.01)
+                : unbounded_recv_timeout(unbounded->receiver, &message, 0.01);
+            TEST_ASSERT_INT_EQ(result, CHANNEL_TIMEOUT);
+
+            if (bounded != NULL) {
+                free_bounded_channel(bounded);
+            }
+            else {
+                free_unbounded_channel(unbounded);
+            }
+        }
+    }
+
+    // Rendezvous channels always park.
+    ChannelOptions options = { CHANNEL_LOCK_DEFAULT, false, false, false, NULL, false, CHANNEL_WAIT_THROUGHPUT };
+    TEST_ASSERT(rendezvous_channel_with(&options) == NULL);
+}
+
+// The channel closed by `test_channel_close_helper`, which is one of a
+// bounded, unbounded or rendezvous channel.
+typedef struct TestCloseChannel_ {
+    BoundedChannel* bounded;
+    UnboundedChannel* unbounded;
+    RendezvousChannel* rendezvous;
+} TestCloseChannel;
+
+// A sender in `test_channel_close` that keeps sending until the channel is
+// closed, along with the number of messages it got through.
+typedef struct TestCloseSender_ {
+    BoundedSender* bounded;
+    UnboundedSender* unbounded;
+    size_t sent;
+} TestCloseSender;
+
+// Helper for `test_channel_close`.
+void test_channel_close_helper(void* channel_vp)
+{
+    TestCloseChannel* channel = (TestCloseChannel*)channel_vp;
+    test_sleep(0.05);
+
+    if (channel->bounded != NULL) {
+        bounded_close_c(channel->bounded);
+    }
+    else if (channel->unbounded != NULL) {
+        unbounded_close_c(channel->unbounded);
+    }
+    else {
+        rendezvous_close_c(channel->rendezvous);
+    }
+}
+
+// Helper for `test_channel_close`.
+void test_channel_close_sender_helper(void* sender_vp)
+{
+    TestCloseSender* sender = (TestCloseSender*)sender_vp;
+    int result;
+
+    do {
+        result = sender->bounded != NULL
+            ? bounded_send(sender->bounded, (void*)1)
+            : unbounded_send(sender->unbounded, (void*)1);
+        sender->sent += result == CHANNEL_SUCCESS;
+    } while (result == CHANNEL_SUCCESS);
+
+    TEST_ASSERT_INT_EQ(result, CHANNEL_CLOSED);
+
+    if (sender->bounded != NULL) {
+        free_bounded_sender(sender->bounded);
+    }
+    else {
+        free_unbounded_sender(sender->unbounded);
+    }
+}
+
+// Helper for `test_channel_close`.
+void test_channel_close_free_helper(void* sender_vp)
+{
+    TestCloseSender* sender = (TestCloseSender*)sender_vp;
+    test_sleep(0.01);
+
+    if (sender->bounded != NULL) {
+        free_bounded_sender(sender->bounded);
+    }
+    else {
+        free_unbounded_sender(sender->unbounded);
+    }
+}
+
+// Helper for `test_channel_close`.
+int test_channel_close_recv(TestCloseChannel* channel, void** message, double timeout)
+{
+    if (channel->bounded != NULL) {
+        return bounded_recv_timeout_c(channel->bounded, message, timeout);
+    }
+    else {
+        return unbounded_recv_timeout_c(channel->unbounded, message, timeout);
+    }
+}
+
+// Helper for `test_channel_close`.
+int test_channel_close_send(TestCloseChannel* channel, void* message)
+{
+    if (channel->bounded != NULL) {
+        return bounded_send_c(channel->bounded, message);
+    }
+    else {
+        return unbounded_send_c(channel->unbounded, message);
+    }
+}
+
+void test_channel_close(void)
+{
+    bool lockfree[4] = { false, true, false, true };
+    bool multi_consumer[4] = { false, false, false, true };
+    bool single_producer[4] = { false, false, true, false };
+
+    for (size_t k = 0; k < 8; k++) {
+        // Unbounded multi-consumer channels are never lock-free.
+        bool lockfree_k = lockfree[k % 4] && (k < 4 || !multi_consumer[k % 4]);
+        ChannelOptions options = { CHANNEL_LOCK_DEFAULT, lockfree_k, multi_consumer[k % 4], single_producer[k % 4] };
+        TestCloseChannel channel = {
+            k < 4 ? bounded_channel_with(4, &options) : NULL,
+            k < 4 ? NULL : unbounded_channel_with(&options),
+            NULL,
+        };
+        void* message = NULL;
+
+        // Messages sent before the close are still received, and nothing can
+        // be sent after it.
+        for (size_t i = 1; i <= 3; i++) {
+            TEST_ASSERT_INT_EQ(test_channel_close_send(&channel, (void*)i), CHANNEL_SUCCESS);
+        }
+
+        if (channel.bounded != NULL) {
+            channel_close(channel.bounded->sender);
+        }
+        else {
+            channel_close(channel.unbounded->sender);
+        }
+
+        TEST_ASSERT_INT_EQ(test_channel_close_send(&channel, (void*)4), CHANNEL_CLOSED);
+
+        for (size_t i = 1; i <= 3; i++) {
+            TEST_ASSERT_INT_EQ(test_channel_close_recv(&channel, &message, 1.0), CHANNEL_SUCCESS);
+            TEST_ASSERT(message == (void*)i);
+        }
+
+        TEST_ASSERT_INT_EQ(test_channel_close_recv(&channel, &message, 1.0), CHANNEL_CLOSED);
+
+        if (channel.bounded != NULL) {
+            free_bounded_channel(channel.bounded);
+            channel.bounded = bounded_channel_with(4, &options);
+        }
+        else {
+            free_unbounded_channel(channel.unbounded);
+            channel.unbounded = unbounded_channel_with(&options);
+        }
+
+        // A blocked receiver is woken by the close rather than its deadline.
+        JoinHandle* handle = thread_spawn(test_channel_close_helper, &channel);
+        TEST_ASSERT_INT_EQ(test_channel_close_recv(&channel, &message, 10.0), CHANNEL_CLOSED);
+        thread_join(handle);
+
+        if (channel.bounded != NULL) {
+            free_bounded_channel(channel.bounded);
+        }
+        else {
+            free_unbounded_channel(channel.unbounded);
+        }
+    }
+
+    // Senders racing with the close either fail or have their messages
+    // delivered, and senders blocked on a full channel are woken.
+    for (size_t k = 0; k < 8; k++) {
+        if (single_producer[k % 4]) {
+            continue;
+        }
+
+        bool lockfree_k = lockfree[k % 4] && (k < 4 || !multi_consumer[k % 4]);
+        ChannelOptions options = { CHANNEL_LOCK_DEFAULT, lockfree_k, multi_consumer[k % 4], false };
+        TestCloseChannel channel = {
+            k < 4 ? bounded_channel_with(4, &options) : NULL,
+            k < 4 ? NULL : unbounded_channel_with(&options),
+            NULL,
+        };
+        TestCloseSender senders[2];
+        JoinHandle* handles[2];
+
+        for (size_t i = 0; i < 2; i++) {
+            senders[i].bounded = channel.bounded != NULL ? clone_bounded_sender(channel.bounded->sender) : NULL;
+            senders[i].unbounded = channel.unbounded != NULL ? clone_unbounded_sender(channel.unbounded->sender) : NULL;
+            senders[i].sent = 0;
+            handles[i] = thread_spawn(test_channel_close_sender_helper, &senders[i]);
+        }
+
+        test_sleep(0.01);
+
+        if (channel.bounded != NULL) {
+            bounded_close_c(channel.bounded);
+        }
+        else {
+            unbounded_close_c(channel.unbounded);
+        }
+
+        size_t received = 0;
+        void* message = NULL;
+        int result;
+
+        while ((result = test_channel_close_recv(&channel, &message, 10.0)) == CHANNEL_SUCCESS) {
+            received++;
+        }
+
+        TEST_ASSERT_INT_EQ(result, CHANNEL_CLOSED);
+
+        for (size_t i = 0; i < 2; i++) {
+            thread_join(handles[i]);
+        }
+
+        TEST_ASSERT(received == senders[0].sent + senders[1].sent);
+
+        if (channel.bounded != NULL) {
+            free_bounded_channel(channel.bounded);
+        }
+        else {
+            free_unbounded_channel(channel.unbounded);
+        }
+    }
+
+    // When the last two senders are freed at the same time, exactly one of
+    // them closes the channel and wakes the blocked receiver.
+    for (size_t k = 0; k < 24; k++) {
+        if (single_producer[k % 4]) {
+            continue;
+        }
+
+        bool lockfree_k = lockfree[k % 4] && (k % 8 < 4 || !multi_consumer[k % 4]);
+        ChannelOptions options = { CHANNEL_LOCK_DEFAULT, lockfree_k, multi_consumer[k % 4], false };
+        TestCloseChannel channel = {
+            k % 8 < 4 ? bounded_channel_with(4, &options) : NULL,
+            k % 8 < 4 ? NULL : unbounded_channel_with(&options),
+            NULL,
+        };
+        TestCloseSender senders[2] = {
+            {
+                channel.bounded != NULL ? channel.bounded->sender : NULL,
+                channel.unbounded != NULL ? channel.unbounded->sender : NULL,
+            },
+            {
+                channel.bounded != NULL ? clone_bounded_sender(channel.bounded->sender) : NULL,
+                channel.unbounded != NULL ? clone_unbounded_sender(channel.unbounded->sender) : NULL,
+            },
+        };
+        JoinHandle* handles[2];
+
+        for (size_t i = 0; i < 2; i++) {
+            handles[i] = thread_spawn(test_channel_close_free_helper, &senders[i]);
+        }
+
+        void* message = NULL;
+        TEST_ASSERT_INT_EQ(test_channel_close_recv(&channel, &message, 10.0), CHANNEL_CLOSED);
+
+        for (size_t i = 0; i < 2; i++) {
+            thread_join(handles[i]);
+        }
+
+        if (channel.bounded != NULL) {
+            free_bounded_receiver(channel.bounded->receiver);
+            free_bounded_channel_wrapper(channel.bounded);
+        }
+        else {
+            free_unbounded_receiver(channel.unbounded->receiver);
+            free_unbounded_channel_wrapper(channel.unbounded);
+        }
+    }
+
+    // The halves of a closed channel can still be freed in either order.
+    BoundedChannel* bounded = bounded_channel_lockfree(4);
+    TEST_ASSERT_INT_EQ(bounded_send_c(bounded, (void*)1), CHANNEL_SUCCESS);
+    bounded_close_c(bounded);
+    free_bounded_sender(bounded->sender);
+    TEST_ASSERT(bounded_recv_c(bounded) == (void*)1);
+    TEST_ASSERT(bounded_recv_c(bounded) == NULL);
+    free_bounded_receiver(bounded->receiver);
+    free_bounded_channel_wrapper(bounded);
+
+    // A blocked rendezvous receiver is woken too.
+    TestCloseChannel channel = { NULL, NULL, rendezvous_channel() };
+    void* message = NULL;
+    JoinHandle* handle = thread_spawn(test_channel_close_helper, &channel);
+    TEST_ASSERT_INT_EQ(rendezvous_recv_timeout_c(channel.rendezvous, &message, 10.0), CHANNEL_CLOSED);
+    thread_join(handle);
+    TEST_ASSERT_INT_EQ(rendezvous_send_c(channel.rendezvous, (void*)1), CHANNEL_CLOSED);
+    free_rendezvous_receiver(channel.rendezvous->receiver);
+    free_rendezvous_sender(channel.rendezvous->sender);
+    free_rendezvous_channel_wrapper(channel.rendezvous);
+}
+
+// The number of records sent through the channel in `test_byte_channel`.
+#define TEST_BYTE_RECORDS 10000
+
+// Helper for `test_byte_channel`.
+void test_byte_channel_helper(void* sender_vp)
+{
+    ByteSender* sender = (ByteSender*)sender_vp;
+
+    for (size_t i = 0; i < TEST_BYTE_RECORDS; i++) {
+        void* data = NULL;
+        size_t size = i % 50 + 1;
+        TEST_ASSERT_INT_EQ(byte_reserve(sender, size, &data), CHANNEL_SUCCESS);
+        memset(data, (int)(i & 0xff), size);
+        byte_commit(sender, size);
+    }
+
+    free_byte_sender(sender);
+}
+
+void test_byte_channel(void)
+{
+    ChannelOptions options = { CHANNEL_LOCK_DEFAULT, false, true, false };
+    TEST_ASSERT(byte_channel(0) == NULL);
+    TEST_ASSERT(byte_channel_with(64, &options) == NULL);
+
+    ByteChannel* channel = byte_channel(60);
+    void* data = NULL;
+    const void* record = NULL;
+    size_t size = 0;
+
+    // Records may take at most half the ring, which is rounded up to 64.
+    TEST_ASSERT_INT_EQ(byte_try_reserve_c(channel, 25, &data), CHANNEL_FULL);
+    TEST_ASSERT_INT_EQ(byte_reserve_c(channel, 40, &data), CHANNEL_FULL);
+
+    // Records are read in place, and can be committed shorter than reserved.
+    TEST_ASSERT_INT_EQ(byte_reserve_c(channel, 5, &data), CHANNEL_SUCCESS);
+    memcpy(data, "hello", 5);
+    byte_commit_c(channel, 5);
+    TEST_ASSERT_INT_EQ(byte_reserve_c(channel, 16, &data), CHANNEL_SUCCESS);
+    memcpy(data, "abc", 3);
+    byte_commit_c(channel, 3);
+
+    TEST_ASSERT_INT_EQ(byte_read_c(channel, &record, &size), CHANNEL_SUCCESS);
+    TEST_ASSERT(size == 5);
+    TEST_ASSERT(memcmp(record, "hello", 5) == 0);
+    TEST_ASSERT_INT_EQ(byte_try_read_c(channel, &record, &size), CHANNEL_SUCCESS);
+    TEST_ASSERT(size == 5);
+    byte_release_c(channel);
+    TEST_ASSERT_INT_EQ(byte_read_timeout_c(channel, &record, &size, 1.0), CHANNEL_SUCCESS);
+    TEST_ASSERT(size == 3);
+    TEST_ASSERT(memcmp(record, "abc", 3) == 0);
+    byte_release_c(channel);
+    TEST_ASSERT_INT_EQ(byte_try_read_c(channel, &record, &size), CHANNEL_EMPTY);
+    TEST_ASSERT_INT_EQ(byte_read_timeout_c(channel, &record, &size, 0.01), CHANNEL_TIMEOUT);
+
+    // Records of every size wrap around the ring without being split.
+    for (size_t i = 0; i < 200; i++) {
+        size_t wanted = i % 24;
+        TEST_ASSERT_INT_EQ(byte_try_reserve_c(channel, wanted, &data), CHANNEL_SUCCESS);
+        TEST_ASSERT((uintptr_t)data % BYTE_RECORD_ALIGN == 0);
+        memset(data, (int)i, wanted);
+        byte_commit_c(channel, wanted);
+
+        TEST_ASSERT_INT_EQ(byte_try_read_c(channel, &record, &size), CHANNEL_SUCCESS);
+        TEST_ASSERT(record == data);
+        TEST_ASSERT(size == wanted);
+
+        for (size_t j = 0; j < size; j++) {
+            TEST_ASSERT(((const unsigned char*)record)[j] == (unsigned char)i);
+        }
+
+        byte_release_c(channel);
+    }
+
+    // A full ring has room again once a record is released.
+    size_t count = 0;
+
+    while (byte_try_reserve_c(channel, 8, &data) == CHANNEL_SUCCESS) {
+        byte_commit_c(channel, 8);
+        count++;
+    }
+
+    TEST_ASSERT(count == 4);
+    TEST_ASSERT_INT_EQ(byte_reserve_timeout_c(channel, 8, &data, 0.01), CHANNEL_TIMEOUT);
+    TEST_ASSERT_INT_EQ(byte_read_c(channel, &record, &size), CHANNEL_SUCCESS);
+    byte_release_c(channel);
+    TEST_ASSERT_INT_EQ(byte_try_reserve_c(channel, 8, &data), CHANNEL_SUCCESS);
+    byte_commit_c(channel, 8);
+
+    // Records committed before the close are still read.
+    channel_close(channel->sender);
+    TEST_ASSERT_INT_EQ(byte_try_reserve_c(channel, 8, &data), CHANNEL_CLOSED);
+
+    for (size_t i = 0; i < 4; i++) {
+        TEST_ASSERT_INT_EQ(byte_read_c(channel, &record, &size), CHANNEL_SUCCESS);
+        TEST_ASSERT(size == 8);
+        byte_release_c(channel);
+    }
+
+    TEST_ASSERT_INT_EQ(byte_read_c(channel, &record, &size), CHANNEL_CLOSED);
+    free_byte_channel(channel);
+
+    // A producer and a consumer on different threads.
+    channel = byte_channel(256);
+    JoinHandle* handle = thread_spawn(test_byte_channel_helper, channel->sender);
+    count = 0;
+
+    while (byte_read(channel->receiver, &record, &size) == CHANNEL_SUCCESS) {
+        TEST_ASSERT(size == count % 50 + 1);
+        TEST_ASSERT(((const unsigned char*)record)[0] == (unsigned char)(count & 0xff));
+        TEST_ASSERT(((const unsigned char*)record)[size - 1] == (unsigned char)(count & 0xff));
+        byte_release(channel->receiver);
+        count++;
+    }
+
+    thread_join(handle);
+    TEST_ASSERT(count == TEST_BYTE_RECORDS);
+    free_byte_receiver(channel->receiver);
+    free_byte_channel_wrapper(channel);
+}
+
+// Helper for `test_select`.
+void test_select_helper(void* sender_vp)
+{
+    UnboundedSender* sender = (UnboundedSender*)sender_vp;
+
+    test_sleep(0.05);
+    TEST_ASSERT_INT_EQ(unbounded_send(sender, sender_vp), CHANNEL_SUCCESS);
+}
+
+// Helper for `test_select`.
+void test_select_rendezvous_helper(void* receiver_vp)
+{
+    RendezvousReceiver* receiver = (RendezvousReceiver*)receiver_vp;
+
+    test_sleep(0.05);
+    void* recv = rendezvous_recv(receiver);
+    TEST_ASSERT(recv == receiver_vp);
+}
+
+// Test selecting over several channels of different types.
+void test_select(void)
+{
+    RendezvousChannel* rendezvous = rendezvous_channel();
+    BoundedChannel* bounded = bounded_channel(4);
+    UnboundedChannel* unbounded = unbounded_channel_lockfree();
+    UnboundedChannel* other = unbounded_channel();
+
+    SelectCase cases[3];
+    cases[0] = select_rendezvous_recv(rendezvous->receiver);
+    cases[1] = select_bounded_recv(bounded->receiver);
+    cases[2] = select_unbounded_recv(unbounded->receiver);
+
+    size_t selected = 0;
+    int msg = 5;
+
+    // Nothing is ready yet.
+    TEST_ASSERT_INT_EQ(channel_try_select(cases, 3, &selected), CHANNEL_EMPTY);
+    TEST_ASSERT_INT_EQ(channel_select_timeout(cases, 3, &selected, 0.02), CHANNEL_TIMEOUT);
+
+    TEST_ASSERT_INT_EQ(bounded_send_c(bounded, &msg), CHANNEL_SUCCESS);
+    TEST_ASSERT_INT_EQ(channel_try_select(cases, 3, &selected), CHANNEL_SUCCESS);
+    TEST_ASSERT(selected == 1);
+    TEST_ASSERT(cases[1].message == &msg);
+
+    // A blocked select is woken by whichever channel becomes ready.
+    JoinHandle* handle = thread_spawn(test_select_helper, unbounded->sender);
+
+    TEST_ASSERT_INT_EQ(channel_select(cases, 3, &selected), CHANNEL_SUCCESS);
+    TEST_ASSERT(selected == 2);
+    TEST_ASSERT(cases[2].message == unbounded->sender);
+
+    thread_join(handle);
+
+    // A rendezvous send is ready once the receiver is waiting.
+    SelectCase send_cases[2];
+    send_cases[0] = select_rendezvous_send(rendezvous->sender, rendezvous->receiver);
+    send_cases[1] = select_bounded_send(bounded->sender, &msg);
+
+    for (size_t i = 0; i < 4; i++) {
+        TEST_ASSERT_INT_EQ(bounded_send_c(bounded, &msg), CHANNEL_SUCCESS);
+    }
+
+    handle = thread_spawn(test_select_rendezvous_helper, rendezvous->receiver);
+
+    TEST_ASSERT_INT_EQ(channel_select(send_cases, 2, &selected), CHANNEL_SUCCESS);
+    TEST_ASSERT(selected == 0);
+
+    thread_join(handle);
+
+    // Ready cases are picked fairly.
+    for (size_t i = 0; i < 1000; i++) {
+        TEST_ASSERT_INT_EQ(unbounded_send_c(unbounded, &msg), CHANNEL_SUCCESS);
+        TEST_ASSERT_INT_EQ(unbounded_send_c(other, &msg), CHANNEL_SUCCESS);
+    }
+
+    SelectCase fair_cases[2];
+    fair_cases[0] = select_unbounded_recv(unbounded->receiver);
+    fair_cases[1] = select_unbounded_recv(other->receiver);
+    size_t counts[2] = { 0, 0 };
+
+    for (size_t i = 0; i < 1000; i++) {
+        TEST_ASSERT_INT_EQ(channel_try_select(fair_cases, 2, &selected), CHANNEL_SUCCESS);
+        counts[selected]++;
+    }
+
+    TEST_ASSERT(counts[0] > 300 && counts[1] > 300);
+
+    // A closed channel is always ready.
+    free_rendezvous_sender(rendezvous->sender);
+    TEST_ASSERT_INT_EQ(channel_select(cases, 1, &selected), CHANNEL_CLOSED);
+    TEST_ASSERT(selected == 0);
+
+    free_rendezvous_receiver(rendezvous->receiver);
+    free_rendezvous_channel_wrapper(rendezvous);
+    free_bounded_channel(bounded);
+    free_unbounded_channel(unbounded);
+    free_unbounded_channel(other);
+}
+
+// Helper for `test_select_multiple_senders`.
+void test_select_multiple_senders_bounded_helper(void* sender_vp)
+{
+    BoundedSender* sender = (BoundedSender*)sender_vp;
+
+    for (size_t i = 1; i <= 10000; i++) {
+        TEST_ASSERT_INT_EQ(bounded_send(sender, (void*)i), CHANNEL_SUCCESS);
+    }
+}
+
+// Helper for `test_select_multiple_senders`.
+void test_select_multiple_senders_unbounded_helper(void* sender_vp)
+{
+    UnboundedSender* sender = (UnboundedSender*)sender_vp;
+
+    for (size_t i = 1; i <= 10000; i++) {
+        TEST_ASSERT_INT_EQ(unbounded_send(sender, (void*)i), CHANNEL_SUCCESS);
+    }
+}
+
+// Helper for `test_select_multiple_senders`.
+void test_select_multiple_senders_rendezvous_helper(void* sender_vp)
+{
+    RendezvousSender* sender = (RendezvousSender*)sender_vp;
+
+    // Sending through a select too means that neither side ever blocks in the
+    // channel itself.
+    for (size_t i = 1; i <= 10000; i++) {
+        SelectCase select_case = select_rendezvous_send(sender, (void*)i);
+        TEST_ASSERT_INT_EQ(channel_select(&select_case, 1, NULL), CHANNEL_SUCCESS);
+    }
+}
+
+// Test selecting over channels that are being sent to from other threads.
+void test_select_multiple_senders(void)
+{
+    BoundedChannel* bounded1 = bounded_channel(4);
+    BoundedChannel* bounded2 = bounded_channel_lockfree(4);
+    UnboundedChannel* unbounded = unbounded_channel();
+    RendezvousChannel* rendezvous = rendezvous_channel();
+
+    SelectCase cases[4];
+    cases[0] = select_bounded_recv(bounded1->receiver);
+    cases[1] = select_bounded_recv(bounded2->receiver);
+    cases[2] = select_unbounded_recv(unbounded->receiver);
+    cases[3] = select_rendezvous_recv(rendezvous->receiver);
+
+    JoinHandle* handles[4];
+    handles[0] = thread_spawn(test_select_multiple_senders_bounded_helper, bounded1->sender);
+    handles[1] = thread_spawn(test_select_multiple_senders_bounded_helper, bounded2->sender);
+    handles[2] = thread_spawn(test_select_multiple_senders_unbounded_helper, unbounded->sender);
+    handles[3] = thread_spawn(test_select_multiple_senders_rendezvous_helper, rendezvous->sender);
+
+    size_t totals[4] = { 0, 0, 0, 0 };
+    size_t selected = 0;
+
+    for (size_t i = 0; i < 4 * 10000; i++) {
+        TEST_ASSERT_INT_EQ(channel_select(cases, 4, &selected), CHANNEL_SUCCESS);
+        totals[selected] += (size_t)cases[selected].message;
+    }
+
+    for (size_t i = 0; i < 4; i++) {
+        thread_join(handles[i]);
+        TEST_ASSERT(totals[i] == (size_t)10000 * 10001 / 2);
+    }
+
+    free_bounded_channel(bounded1);
+    free_bounded_channel(bounded2);
+    free_unbounded_channel(unbounded);
+    free_rendezvous_channel(rendezvous);
+}
+
 int main(void)
 {
     // Begin
@@ -969,6 +3530,16 @@ int main(void)
     test_rendezvous_receiver_closed();
     printf("\nTesting rendezvous channel with multiple senders...\n");
     test_rendezvous_multiple_senders();
+    printf("\nTesting rendezvous channel round trips between threads...\n");
+    test_rendezvous_ping_pong();
+    printf("\nTesting rendezvous channel batches...\n");
+    test_rendezvous_batch();
+    printf("\nTesting non-blocking rendezvous channel operations...\n");
+    test_rendezvous_try();
+    printf("\nTesting rendezvous channel timeouts...\n");
+    test_rendezvous_timeout();
+    printf("\nTesting rendezvous channel with cloned senders...\n");
+    test_rendezvous_cloned_senders();
     printf("\nTesting bounded channel...\n");
     test_bounded_channel();
     printf("\nTesting bounded sender and receiver...\n");
@@ -981,6 +3552,22 @@ int main(void)
     test_bounded_threaded();
     printf("\nTesting bounded channel with multiple senders...\n");
     test_bounded_multiple_senders();
+    printf("\nTesting bounded channel wrap-around...\n");
+    test_bounded_wraparound();
+    printf("\nTesting lock-free bounded channel...\n");
+    test_bounded_lockfree_channel();
+    printf("\nTesting lock-free bounded channel with many senders...\n");
+    test_bounded_lockfree_multiple_senders();
+    printf("\nTesting bounded channel batches...\n");
+    test_bounded_batch();
+    printf("\nTesting non-blocking bounded channel operations...\n");
+    test_bounded_try();
+    printf("\nTesting bounded channel timeouts...\n");
+    test_bounded_timeout();
+    printf("\nTesting bounded channel with many receivers...\n");
+    test_bounded_mpmc();
+    printf("\nTesting bounded channel with cloned senders...\n");
+    test_bounded_cloned_senders();
     printf("\nTesting unbounded channel...\n");
     test_unbounded_channel();
     printf("\nTesting unbounded sender and receiver...\n");
@@ -993,6 +3580,50 @@ int main(void)
     test_unbounded_threaded();
     printf("\nTesting unbounded channel with multiple senders...\n");
     test_unbounded_multiple_senders();
+    printf("\nTesting unbounded channel blocked receiver wake-up on close...\n");
+    test_unbounded_blocked_sender_closed();
+    printf("\nTesting lock-free unbounded channel...\n");
+    test_unbounded_lockfree_channel();
+    printf("\nTesting lock-free unbounded channel with many senders...\n");
+    test_unbounded_lockfree_multiple_senders();
+    printf("\nTesting unbounded channel batches...\n");
+    test_unbounded_batch();
+    printf("\nTesting non-blocking unbounded channel operations...\n");
+    test_unbounded_try();
+    printf("\nTesting unbounded channel timeouts...\n");
+    test_unbounded_timeout();
+    printf("\nTesting unbounded channel with many receivers...\n");
+    test_unbounded_mpmc();
+    printf("\nTesting unbounded channel with cloned senders...\n");
+    test_unbounded_cloned_senders();
+    printf("\nTesting inline send and receive fast paths...\n");
+    test_inline_fast_paths();
+    printf("\nTesting lock backends and channel options...\n");
+    test_lock_backends();
+    printf("\nTesting single-producer bounded channel...\n");
+    test_spsc_bounded();
+    printf("\nTesting single-producer unbounded channel...\n");
+    test_spsc_unbounded();
+    printf("\nTesting custom allocators and node recycling...\n");
+    test_allocator();
+    printf("\nTesting sized bounded channel...\n");
+    test_bounded_sized();
+    printf("\nTesting channel stats...\n");
+    test_channel_stats();
+    printf("\nTesting channel latency tracing...\n");
+    test_channel_latency();
+    printf("\nTesting receiver event descriptors...\n");
+    test_receiver_fd();
+    printf("\nTesting wait policies...\n");
+    test_wait_policies();
+    printf("\nTesting closing channels...\n");
+    test_channel_close();
+    printf("\nTesting byte channels...\n");
+    test_byte_channel();
+    printf("\nTesting select over multiple channels...\n");
+    test_select();
+    printf("\nTesting select with multiple senders...\n");
+    test_select_multiple_senders();
 
     // Done
     printf("\nCompleted tests\n");